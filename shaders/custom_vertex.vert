@@ -5,29 +5,31 @@
 // ============================================================
 // Instructions:
 // 1. Replace the code below with your custom vertex shader
-// 2. Make sure to keep the same output interface (fragColor)
+// 2. Make sure to keep the same interface (inPosition/inColor in, fragColor out)
 // 3. Save this file and run the app - it will auto-reload!
 // ============================================================
 
-// Simple triangle vertices
-vec2 positions[3] = vec2[](
-    vec2(0.0, 0.5),   // top
-    vec2(-0.5, -0.5), // bottom left
-    vec2(0.5, -0.5)   // bottom right
-);
-
-// Simple bright colors
-vec3 colors[3] = vec3[](
-    vec3(1.0, 0.0, 0.0),  // red
-    vec3(0.0, 1.0, 0.0),  // green
-    vec3(0.0, 0.0, 1.0)   // blue
-);
+// Per-vertex data uploaded by the app (see Vertex in main_triangle_fixed.cpp)
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec3 inColor;
 
 layout(location = 0) out vec3 fragColor;
 
+// Updated by the app every frame (see FrameParameters in main_triangle_fixed.cpp)
+layout(set = 0, binding = 0) uniform FrameParameters {
+    float time;         // seconds since start
+    float deltaTime;    // seconds since the previous frame
+    vec2  resolution;   // framebuffer size in pixels
+} frame;
+
+// Pushed with each draw
+layout(push_constant) uniform DrawParameters {
+    uint drawIndex;
+} draw;
+
 void main() {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-    fragColor = colors[gl_VertexIndex];
+    gl_Position = vec4(inPosition, 0.0, 1.0);
+    fragColor = inColor;
 }
 
 // ============================================================
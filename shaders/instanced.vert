@@ -0,0 +1,17 @@
+#version 450
+
+// Vertex shader for the instanced stress scene (./app --instances N).
+// Each instance places a copy of the mesh: inInstance.xy is its offset, inInstance.zw its scale.
+//
+// Compile with: glslc instanced.vert -o instanced.vert.spv
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec4 inInstance;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    gl_Position = vec4(inPosition * inInstance.zw + inInstance.xy, 0.0, 1.0);
+    fragColor = inColor;
+}
@@ -0,0 +1,28 @@
+#version 450
+
+// Vertex shader for glfw_playground and modern_shader_app: the triangle comes from
+// gl_VertexIndex, so those pipelines have no vertex input and nothing is bound.
+// custom_vertex.vert reads a vertex buffer and is only drawn by ./app.
+//
+// Compile with: glslc triangle.vert -o triangle.vert.spv
+
+// Simple triangle vertices
+vec2 positions[3] = vec2[](
+    vec2(0.0, 0.5),   // top
+    vec2(-0.5, -0.5), // bottom left
+    vec2(0.5, -0.5)   // bottom right
+);
+
+// Simple bright colors
+vec3 colors[3] = vec3[](
+    vec3(1.0, 0.0, 0.0),  // red
+    vec3(0.0, 1.0, 0.0),  // green
+    vec3(0.0, 0.0, 1.0)   // blue
+);
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
+    fragColor = colors[gl_VertexIndex];
+}
@@ -0,0 +1,548 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#include "../Public/VulkanApp.h"
+#include "CommandCache.h"
+#include "ShaderObjects.h"
+#include <array>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+namespace Core {
+
+    namespace {
+
+        const char* const kValidationLayer = "VK_LAYER_KHRONOS_validation";
+
+#ifdef NDEBUG
+        constexpr bool kWantValidation = false;
+#else
+        constexpr bool kWantValidation = true;
+#endif
+
+        bool hasValidationLayer() {
+            for (const auto& layer : vk::enumerateInstanceLayerProperties()) {
+                if (strcmp(layer.layerName, kValidationLayer) == 0) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Frame pacing runs on a timeline semaphore, enabled through the Vulkan 1.2 feature block
+        bool supportsTimelineSemaphores(vk::PhysicalDevice physicalDevice) {
+            if (physicalDevice.getProperties().apiVersion < VK_API_VERSION_1_2) {
+                return false;
+            }
+            auto chain = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+            return chain.get<vk::PhysicalDeviceVulkan12Features>().timelineSemaphore;
+        }
+
+    } // namespace
+
+    VulkanApp::VulkanApp(AppConfig config)
+        : m_config(std::move(config))
+    {}
+
+    VulkanApp::~VulkanApp() = default;
+
+    void VulkanApp::run() {
+        initWindow();
+        initVulkan();
+        onInit();
+        mainLoop();
+        cleanup();
+    }
+
+    void VulkanApp::initWindow() {
+        glfwInit();
+
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        glfwWindowHint(GLFW_RESIZABLE, m_config.resizable ? GLFW_TRUE : GLFW_FALSE);
+
+        m_window = glfwCreateWindow(static_cast<int>(m_config.width), static_cast<int>(m_config.height),
+                                    m_config.title.c_str(), nullptr, nullptr);
+        if (!m_window) {
+            throw std::runtime_error("failed to create window!");
+        }
+        glfwSetWindowUserPointer(m_window, this);
+        glfwSetFramebufferSizeCallback(m_window, framebufferResizeCallback);
+    }
+
+    void VulkanApp::framebufferResizeCallback(GLFWwindow* window, int, int) {
+        auto app = static_cast<VulkanApp*>(glfwGetWindowUserPointer(window));
+        app->m_framebufferResized = true;
+    }
+
+    void VulkanApp::initVulkan() {
+        createInstance();
+        createSurface();
+        pickPhysicalDevice();
+        createDevice();
+        createSwapchain();
+        createRenderPass();
+        createPipelineLibrary();
+        createFrameResources();
+    }
+
+    void VulkanApp::createInstance() {
+        vk::ApplicationInfo appInfo(
+            m_config.title.c_str(),
+            VK_MAKE_VERSION(1, 0, 0),
+            "No Engine",
+            VK_MAKE_VERSION(1, 0, 0),
+            VK_API_VERSION_1_2
+        );
+
+        uint32_t glfwExtensionCount = 0;
+        const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+        std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+
+        // Debug builds validate when the layer is installed, and run without it otherwise
+        m_validation = kWantValidation && hasValidationLayer();
+
+        vk::InstanceCreateInfo createInfo(
+            {},
+            &appInfo,
+            m_validation ? 1 : 0,
+            m_validation ? &kValidationLayer : nullptr,
+            static_cast<uint32_t>(extensions.size()),
+            extensions.data()
+        );
+
+        m_instance = vk::createInstance(createInfo);
+    }
+
+    void VulkanApp::createSurface() {
+        VkSurfaceKHR surface;
+        if (glfwCreateWindowSurface(static_cast<VkInstance>(m_instance), m_window, nullptr, &surface) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create window surface!");
+        }
+        m_surface = vk::SurfaceKHR(surface);
+    }
+
+    void VulkanApp::pickPhysicalDevice() {
+        // Graphics must present to our surface; compute prefers a family of its own
+        for (const auto& device : m_instance.enumeratePhysicalDevices()) {
+            if (!supportsTimelineSemaphores(device)) {
+                continue;
+            }
+            auto families = Renderer::selectQueueFamilies(device, m_surface);
+            if (families.complete()) {
+                m_physicalDevice = device;
+                m_queueFamilies = families;
+                return;
+            }
+        }
+        throw std::runtime_error("failed to find a suitable GPU (Vulkan 1.2 with timeline semaphores, graphics and present)!");
+    }
+
+    void VulkanApp::createDevice() {
+        auto queueCreateInfos = Renderer::queueCreateInfos(m_queueFamilies);
+        std::vector<const char*> extensions = { vk::KHRSwapchainExtensionName };
+
+        // Whatever the device offers for indirect draws; the batcher falls back around the rest
+        m_features.indirect = Renderer::queryIndirectDrawFeatures(m_physicalDevice);
+        vk::PhysicalDeviceFeatures deviceFeatures{};
+        deviceFeatures.multiDrawIndirect = m_features.indirect.multiDrawIndirect;
+        deviceFeatures.drawIndirectFirstInstance = m_features.indirect.drawIndirectFirstInstance;
+
+        // Frame pacing runs on a timeline semaphore
+        vk::PhysicalDeviceVulkan12Features vulkan12Features{};
+        vulkan12Features.timelineSemaphore = VK_TRUE;
+        vulkan12Features.drawIndirectCount = m_features.indirect.drawIndirectCount;
+
+        // Optional features are chained after the Vulkan 1.2 block
+        void** featureChain = &vulkan12Features.pNext;
+
+        m_features.dynamicRendering = m_config.dynamicRendering && Renderer::supportsDynamicRendering(m_physicalDevice);
+        vk::PhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures(VK_TRUE);
+        if (m_features.dynamicRendering) {
+            extensions.push_back(vk::KHRDynamicRenderingExtensionName);
+            *featureChain = &dynamicRenderingFeatures;
+            featureChain = &dynamicRenderingFeatures.pNext;
+        }
+
+        m_features.graphicsPipelineLibrary = m_config.graphicsPipelineLibrary &&
+                                             Renderer::supportsGraphicsPipelineLibrary(m_physicalDevice);
+        vk::PhysicalDeviceGraphicsPipelineLibraryFeaturesEXT pipelineLibraryFeatures(VK_TRUE);
+        if (m_features.graphicsPipelineLibrary) {
+            extensions.push_back(vk::KHRPipelineLibraryExtensionName);
+            extensions.push_back(vk::EXTGraphicsPipelineLibraryExtensionName);
+            *featureChain = &pipelineLibraryFeatures;
+            featureChain = &pipelineLibraryFeatures.pNext;
+        }
+
+        // Shader objects only render with dynamic rendering
+        m_features.shaderObjects = m_config.shaderObjects && m_features.dynamicRendering &&
+                                   Renderer::supportsShaderObject(m_physicalDevice);
+        vk::PhysicalDeviceShaderObjectFeaturesEXT shaderObjectFeatures(VK_TRUE);
+        if (m_features.shaderObjects) {
+            extensions.push_back(vk::EXTShaderObjectExtensionName);
+            *featureChain = &shaderObjectFeatures;
+            featureChain = &shaderObjectFeatures.pNext;
+        }
+
+        vk::DeviceCreateInfo createInfo(
+            {},
+            static_cast<uint32_t>(queueCreateInfos.size()),
+            queueCreateInfos.data(),
+            m_validation ? 1 : 0,
+            m_validation ? &kValidationLayer : nullptr,
+            static_cast<uint32_t>(extensions.size()),
+            extensions.data(),
+            &deviceFeatures
+        );
+        createInfo.pNext = &vulkan12Features;
+
+        m_device = m_physicalDevice.createDevice(createInfo);
+        m_queue = m_device.getQueue(m_queueFamilies.graphics, 0);
+        m_computeQueue = m_device.getQueue(m_queueFamilies.compute, m_queueFamilies.computeQueueIndex);
+        m_transferQueue = m_device.getQueue(m_queueFamilies.transfer, 0);
+        if (m_features.dynamicRendering) {
+            m_dynamicRendering = std::make_unique<Renderer::DynamicRendering>(m_device);
+        }
+    }
+
+    void VulkanApp::createSwapchain() {
+        m_swapchain = std::make_unique<Renderer::SwapchainManager>(m_physicalDevice, m_device, m_surface, windowExtent());
+    }
+
+    // With dynamic rendering there is no render pass and the swapchain builds no framebuffers
+    void VulkanApp::createRenderPass() {
+        if (m_dynamicRendering) {
+            return;
+        }
+
+        vk::AttachmentDescription colorAttachment(
+            {},
+            m_swapchain->format(),
+            vk::SampleCountFlagBits::e1,
+            vk::AttachmentLoadOp::eClear,
+            vk::AttachmentStoreOp::eStore,
+            vk::AttachmentLoadOp::eDontCare,
+            vk::AttachmentStoreOp::eDontCare,
+            vk::ImageLayout::eUndefined,
+            vk::ImageLayout::ePresentSrcKHR
+        );
+        vk::AttachmentReference colorAttachmentRef(0, vk::ImageLayout::eColorAttachmentOptimal);
+        vk::SubpassDescription subpass({}, vk::PipelineBindPoint::eGraphics, {}, colorAttachmentRef);
+
+        // The acquire semaphore is waited at color output; without this the layout transition
+        // would only be ordered after top of pipe and could run before the image is released
+        vk::SubpassDependency dependency(
+            VK_SUBPASS_EXTERNAL,
+            0,
+            vk::PipelineStageFlagBits::eColorAttachmentOutput,
+            vk::PipelineStageFlagBits::eColorAttachmentOutput,
+            {},
+            vk::AccessFlagBits::eColorAttachmentWrite
+        );
+
+        m_renderPass = m_device.createRenderPass(vk::RenderPassCreateInfo({}, 1, &colorAttachment, 1, &subpass, 1, &dependency));
+
+        // Rebuilt by the swapchain manager for every new set of images
+        m_swapchain->setFramebufferFactory([this](vk::ImageView view, vk::Extent2D extent) {
+            return m_device.createFramebuffer(vk::FramebufferCreateInfo({}, m_renderPass, 1, &view, extent.width, extent.height, 1));
+        });
+    }
+
+    void VulkanApp::createPipelineLibrary() {
+        m_shaderLoader = std::make_unique<ShaderLoader::ShaderLoader>(ShaderLoader::createDefaultCompiler());
+        if (!m_config.shaderDependencyGraph.empty()) {
+            m_shaderLoader->enableDependencyTracking(m_config.shaderDependencyGraph);
+        }
+        m_shaderModules = std::make_unique<Renderer::ShaderModuleCache>(m_device, *m_shaderLoader);
+
+        m_pipelineCache = m_config.pipelineCachePath.empty()
+            ? m_device.createPipelineCache(vk::PipelineCacheCreateInfo())
+            : Renderer::loadPipelineCache(m_physicalDevice, m_device, m_config.pipelineCachePath);
+        if (!m_config.pipelineManifestPath.empty()) {
+            m_pipelineManifest.load(m_config.pipelineManifestPath);
+        }
+        m_pipelineLibrary = std::make_unique<Renderer::GraphicsPipelineLibrary>(m_device, m_pipelineCache,
+                                                                                m_features.graphicsPipelineLibrary);
+    }
+
+    void VulkanApp::createFrameResources() {
+        m_framePacer = std::make_unique<Renderer::FramePacer>(m_device, m_config.framesInFlight);
+        m_acquireSemaphores.resize(m_framePacer->framesInFlight());
+        for (auto& semaphore : m_acquireSemaphores) {
+            semaphore = m_device.createSemaphore({});
+        }
+
+        m_commandPool = m_device.createCommandPool(vk::CommandPoolCreateInfo(
+            vk::CommandPoolCreateFlagBits::eResetCommandBuffer, m_queueFamilies.graphics));
+        m_lastShaderReloadCheck = glfwGetTime();
+    }
+
+    void VulkanApp::loadShader(const std::string& path) {
+        if (!m_shaderLoader->loadShader(path)) {
+            throw std::runtime_error("failed to load shader " + path);
+        }
+    }
+
+    Renderer::GraphicsPipelineDesc VulkanApp::describePipeline(vk::PipelineLayout layout) const {
+        Renderer::GraphicsPipelineDesc desc;
+        desc.layout = layout;
+        // Dynamic rendering names the attachment formats instead of a compatible render pass
+        if (m_dynamicRendering) {
+            desc.colorFormats = { m_swapchain->format() };
+        } else {
+            desc.renderPass = m_renderPass;
+        }
+        return desc;
+    }
+
+    Renderer::GraphicsPipelineLibrary::PipelineId VulkanApp::buildPipeline(Renderer::GraphicsPipelineDesc desc,
+                                                                           const std::string& vertexPath,
+                                                                           const std::string& fragmentPath,
+                                                                           std::optional<Renderer::GraphicsPipelineLibrary::PipelineId> replaceId) {
+        desc.vertexShader = m_shaderModules->get(vertexPath);
+        desc.vertexShaderHash = m_shaderLoader->getModule(vertexPath)->hash;
+        desc.fragmentShader = m_shaderModules->get(fragmentPath);
+        desc.fragmentShaderHash = m_shaderLoader->getModule(fragmentPath)->hash;
+
+        m_pipelineManifest.record(desc, vertexPath, fragmentPath);
+
+        if (replaceId) {
+            m_pipelineLibrary->replace(*replaceId, desc, m_framePacer->signalValue());
+            return *replaceId;
+        }
+        return m_pipelineLibrary->add(desc);
+    }
+
+    void VulkanApp::warmUpPipelines(vk::PipelineLayout layout) {
+        m_pipelineLibrary->warmUp(m_pipelineManifest, [this, layout](Renderer::GraphicsPipelineDesc& desc,
+                                                                     const std::string& vertexPath,
+                                                                     const std::string& fragmentPath) {
+            // Entries for the other rendering path are skipped
+            if (desc.colorFormats.empty() == static_cast<bool>(m_dynamicRendering)) {
+                return false;
+            }
+            // So are shaders not loaded yet or edited since; both sides hash after the loader's
+            // optional stripping, as buildPipeline() does
+            const ShaderLoader::ShaderModule* vertex = m_shaderLoader->getModule(vertexPath);
+            const ShaderLoader::ShaderModule* fragment = m_shaderLoader->getModule(fragmentPath);
+            if (!vertex || !fragment || vertex->hash != desc.vertexShaderHash || fragment->hash != desc.fragmentShaderHash) {
+                return false;
+            }
+            desc.vertexShader = m_shaderModules->get(vertexPath);
+            desc.fragmentShader = m_shaderModules->get(fragmentPath);
+            desc.layout = layout;
+            desc.renderPass = m_renderPass;
+            return true;
+        });
+    }
+
+    void VulkanApp::beginColorPass(vk::CommandBuffer commandBuffer, uint32_t imageIndex, vk::SubpassContents contents,
+                                   vk::ClearValue clearColor) {
+        if (m_dynamicRendering) {
+            vk::RenderingFlags flags;
+            if (contents == vk::SubpassContents::eSecondaryCommandBuffers) {
+                flags = vk::RenderingFlagBits::eContentsSecondaryCommandBuffers;
+            }
+            m_dynamicRendering->begin(commandBuffer, m_swapchain->image(imageIndex), m_swapchain->imageView(imageIndex),
+                                      m_swapchain->extent(), clearColor, flags);
+            return;
+        }
+
+        vk::RenderPassBeginInfo renderPassInfo(
+            m_renderPass,
+            m_swapchain->framebuffer(imageIndex),
+            { {0, 0}, m_swapchain->extent() },
+            1,
+            &clearColor
+        );
+        commandBuffer.beginRenderPass(renderPassInfo, contents);
+    }
+
+    void VulkanApp::endColorPass(vk::CommandBuffer commandBuffer, uint32_t imageIndex) {
+        if (m_dynamicRendering) {
+            m_dynamicRendering->end(commandBuffer, m_swapchain->image(imageIndex));
+        } else {
+            commandBuffer.endRenderPass();
+        }
+    }
+
+    void VulkanApp::setViewportAndScissor(vk::CommandBuffer commandBuffer) {
+        vk::Extent2D extent = m_swapchain->extent();
+        vk::Viewport viewport(0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f);
+        commandBuffer.setViewport(0, 1, &viewport);
+        vk::Rect2D scissor({0, 0}, extent);
+        commandBuffer.setScissor(0, 1, &scissor);
+    }
+
+    uint64_t VulkanApp::renderTarget(uint32_t imageIndex) const {
+        return m_dynamicRendering ? Renderer::CommandCacheKey::targetOf(m_swapchain->imageView(imageIndex))
+                                  : Renderer::CommandCacheKey::targetOf(m_swapchain->framebuffer(imageIndex));
+    }
+
+    void VulkanApp::mainLoop() {
+        while (!glfwWindowShouldClose(m_window)) {
+            glfwPollEvents();
+            drawFrame();
+        }
+
+        m_device.waitIdle();
+    }
+
+    void VulkanApp::drawFrame() {
+        // Waits for the frame that last used this slot, freeing its acquire semaphore
+        uint32_t slot = m_framePacer->beginFrame();
+
+        // vulkan.hpp reports out-of-date by throwing; suboptimal comes back as a success code.
+        // Nothing was submitted for this slot, so the next beginFrame() can reuse it as is.
+        uint32_t imageIndex;
+        try {
+            auto result = m_device.acquireNextImageKHR(m_swapchain->handle(), UINT64_MAX, m_acquireSemaphores[slot], nullptr);
+            if (result.result != vk::Result::eSuccess && result.result != vk::Result::eSuboptimalKHR) {
+                throw std::runtime_error("failed to acquire swap chain image!");
+            }
+            imageIndex = result.value;
+        } catch (const vk::OutOfDateKHRError&) {
+            recreateSwapchain();
+            return;
+        }
+
+        m_swapchain->collect(m_framePacer->completedValue());
+        // Optimized builds replace the fast-linked pipelines once done
+        if (m_pipelineLibrary->update(m_framePacer->signalValue(), m_framePacer->completedValue())) {
+            onPipelinesChanged();
+        }
+        pollShaderReload();
+
+        Frame frame{slot, imageIndex, m_framePacer->signalValue()};
+        recordFrame(frame);
+
+        // The binary semaphores ignore their entries in the value arrays
+        std::vector<vk::Semaphore> waitSemaphores = { m_acquireSemaphores[slot] };
+        std::vector<uint64_t> waitValues = { 0 };
+        std::vector<vk::PipelineStageFlags> waitStages = { vk::PipelineStageFlagBits::eColorAttachmentOutput };
+        for (const auto& wait : frame.waits) {
+            waitSemaphores.push_back(wait.semaphore);
+            waitValues.push_back(wait.value);
+            waitStages.push_back(wait.stages);
+        }
+        std::array<vk::Semaphore, 2> signalSemaphores = { m_swapchain->presentSemaphore(imageIndex), m_framePacer->timeline() };
+        std::array<uint64_t, 2> signalValues = { 0, frame.signalValue };
+        vk::TimelineSemaphoreSubmitInfo timelineInfo(
+            static_cast<uint32_t>(waitValues.size()),
+            waitValues.data(),
+            static_cast<uint32_t>(signalValues.size()),
+            signalValues.data()
+        );
+
+        vk::SubmitInfo submitInfo(
+            static_cast<uint32_t>(waitSemaphores.size()),
+            waitSemaphores.data(),
+            waitStages.data(),
+            static_cast<uint32_t>(frame.commandBuffers.size()),
+            frame.commandBuffers.data(),
+            static_cast<uint32_t>(signalSemaphores.size()),
+            signalSemaphores.data(),
+            &timelineInfo
+        );
+
+        if (m_queue.submit(1, &submitInfo, nullptr) != vk::Result::eSuccess) {
+            throw std::runtime_error("failed to submit draw command buffer!");
+        }
+        m_framePacer->endFrame();
+
+        vk::Semaphore presentSemaphore = m_swapchain->presentSemaphore(imageIndex);
+        vk::SwapchainKHR presentSwapchain = m_swapchain->handle();
+        vk::PresentInfoKHR presentInfo(1, &presentSemaphore, 1, &presentSwapchain, &imageIndex);
+
+        vk::Result presentResult;
+        try {
+            presentResult = m_queue.presentKHR(presentInfo);
+        } catch (const vk::OutOfDateKHRError&) {
+            presentResult = vk::Result::eErrorOutOfDateKHR;
+        }
+        if (presentResult == vk::Result::eErrorOutOfDateKHR || presentResult == vk::Result::eSuboptimalKHR || m_framebufferResized) {
+            m_framebufferResized = false;
+            recreateSwapchain();
+        } else if (presentResult != vk::Result::eSuccess) {
+            throw std::runtime_error("failed to present swap chain image!");
+        }
+    }
+
+    void VulkanApp::pollShaderReload() {
+        double now = glfwGetTime();
+        if (now - m_lastShaderReloadCheck < m_config.shaderReloadInterval) {
+            return;
+        }
+        m_lastShaderReloadCheck = now;
+
+        auto reloaded = m_shaderLoader->reloadChanged();
+        if (reloaded.empty()) {
+            return;
+        }
+        // Warm-up builds may still be using the modules invalidate() destroys
+        m_pipelineLibrary->finishWarmUp();
+        m_shaderModules->invalidate(reloaded);
+
+        try {
+            onShadersReloaded(reloaded);
+        } catch (const std::exception& e) {
+            // Keep drawing with what was built before
+            std::cerr << "Shader reload failed: " << e.what() << std::endl;
+        }
+    }
+
+    // Frames already in flight keep rendering to and presenting the old swapchain; it and its
+    // framebuffers go once the next frame, the first on the new swapchain, has completed
+    void VulkanApp::recreateSwapchain() {
+        m_swapchain->recreate(windowExtent(), m_framePacer->signalValue());
+        onSwapchainRecreated();
+    }
+
+    // Minimising leaves a zero-sized framebuffer; there is nothing to present until it comes back
+    vk::Extent2D VulkanApp::windowExtent() {
+        int width = 0, height = 0;
+        glfwGetFramebufferSize(m_window, &width, &height);
+        while (width == 0 || height == 0) {
+            glfwGetFramebufferSize(m_window, &width, &height);
+            glfwWaitEvents();
+        }
+        return { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+    }
+
+    void VulkanApp::cleanup() {
+        onCleanup();
+
+        m_swapchain.reset();
+        for (auto semaphore : m_acquireSemaphores) {
+            m_device.destroySemaphore(semaphore);
+        }
+        m_framePacer.reset();
+        m_device.destroyCommandPool(m_commandPool);
+
+        m_pipelineLibrary.reset();
+        m_shaderModules.reset();
+        if (!m_config.pipelineManifestPath.empty() && m_pipelineManifest.dirty() &&
+            !m_pipelineManifest.save(m_config.pipelineManifestPath)) {
+            std::cerr << "Failed to save pipeline manifest: " << m_config.pipelineManifestPath << std::endl;
+        }
+        if (!m_config.pipelineCachePath.empty() &&
+            !Renderer::savePipelineCache(m_device, m_pipelineCache, m_config.pipelineCachePath)) {
+            std::cerr << "Failed to save pipeline cache: " << m_config.pipelineCachePath << std::endl;
+        }
+        m_device.destroyPipelineCache(m_pipelineCache);
+        m_device.destroyRenderPass(m_renderPass);
+        m_dynamicRendering.reset();
+        m_device.destroy();
+
+        m_instance.destroySurfaceKHR(m_surface);
+        m_instance.destroy();
+
+        glfwDestroyWindow(m_window);
+        glfwTerminate();
+    }
+
+} // namespace Core
@@ -0,0 +1,201 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#ifndef VULKANAPP_H
+#define VULKANAPP_H
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include "AsyncCompute.h"
+#include "DrawBatcher.h"
+#include "DynamicRendering.h"
+#include "FramePacer.h"
+#include "GraphicsPipelineLibrary.h"
+#include "PipelineManifest.h"
+#include "QueueFamilies.h"
+#include "ShaderLoader.h"
+#include "ShaderModuleCache.h"
+#include "SwapchainManager.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+struct GLFWwindow;
+
+namespace Core {
+
+    struct AppConfig {
+        std::string title = "Vulkan";
+        uint32_t    width = 800;
+        uint32_t    height = 600;
+        bool        resizable = true;
+        uint32_t    framesInFlight = 2;
+
+        // Optional device features, enabled when the device has them; features() says which were
+        bool        dynamicRendering = true;
+        bool        graphicsPipelineLibrary = true;
+        bool        shaderObjects = false;    // needs dynamic rendering too
+
+        // Shader files are reloaded from disk every interval; an empty graph path skips
+        // dependency tracking
+        std::string shaderDependencyGraph;
+        double      shaderReloadInterval = 0.25;
+
+        // Pipelines seen by earlier runs are rebuilt at startup into a cache kept on disk;
+        // empty paths keep both in memory only
+        std::string pipelineManifestPath;
+        std::string pipelineCachePath;
+    };
+
+    // What createDevice() found and enabled
+    struct DeviceFeatures {
+        bool dynamicRendering = false;
+        bool graphicsPipelineLibrary = false;
+        bool shaderObjects = false;
+        Renderer::IndirectDrawFeatures indirect;
+    };
+
+    // One frame's work, filled in by recordFrame(). The submission always waits for the image
+    // acquire at color output and signals the image's present semaphore and the frame pacer's
+    // timeline at signalValue.
+    struct Frame {
+        uint32_t slot;          // frame-in-flight index; its previous frame has completed
+        uint32_t imageIndex;
+        uint64_t signalValue;
+        std::vector<vk::CommandBuffer>       commandBuffers;
+        std::vector<Renderer::SemaphoreWait> waits;
+    };
+
+    // The window, device, swapchain, pipelines and frame loop every front end shares.
+    //
+    // run() brings up GLFW and Vulkan, calls onInit(), then loops: wait for the frame slot,
+    // acquire, reload changed shaders, swap in optimized pipelines, recordFrame(), submit and
+    // present. Resizes and out-of-date swapchains are recreated without waiting for the device
+    // (see SwapchainManager). Pipelines are built through the graphics pipeline library from
+    // modules in a content-hash cache, whichever rendering path the device ended up on.
+    class VulkanApp {
+    public:
+        explicit VulkanApp(AppConfig config);
+        virtual ~VulkanApp();
+
+        VulkanApp(const VulkanApp&) = delete;
+        VulkanApp& operator=(const VulkanApp&) = delete;
+
+        // throws std::runtime_error on any setup failure
+        void run();
+
+    protected:
+        // Create whatever the app draws with; the device, swapchain and pipeline library exist
+        virtual void onInit() {}
+        // Record this frame's command buffers and add any waits beyond the acquire
+        virtual void recordFrame(Frame& frame) = 0;
+        // The swapchain has new images; anything recorded against the old ones is stale
+        virtual void onSwapchainRecreated() {}
+        // Shaders were reloaded from disk; stale modules are gone, pipelines are still the old ones
+        virtual void onShadersReloaded([[maybe_unused]] const std::vector<std::string>& paths) {}
+        // The pipeline library swapped in optimized builds, so pipeline(id) handles changed
+        virtual void onPipelinesChanged() {}
+        // Destroy what onInit() created; the device is idle
+        virtual void onCleanup() {}
+
+        // Load a shader into shaderLoader(); throws std::runtime_error if it can't be
+        void loadShader(const std::string& path);
+
+        // A description with the render pass or color formats of the current rendering path
+        Renderer::GraphicsPipelineDesc describePipeline(vk::PipelineLayout layout) const;
+
+        // Adds desc built from the loaded shaders, or rebuilds replaceId with them after a reload
+        Renderer::GraphicsPipelineLibrary::PipelineId buildPipeline(Renderer::GraphicsPipelineDesc desc,
+                                                                    const std::string& vertexPath,
+                                                                    const std::string& fragmentPath,
+                                                                    std::optional<Renderer::GraphicsPipelineLibrary::PipelineId> replaceId = {});
+
+        // Start building the pipelines earlier runs recorded, for the rendering path in use; call
+        // once their shaders are loaded and before buildPipeline() asks for them
+        void warmUpPipelines(vk::PipelineLayout layout);
+
+        // Clears the swapchain image and leaves it ready to present, through whichever path is in use
+        void beginColorPass(vk::CommandBuffer commandBuffer, uint32_t imageIndex, vk::SubpassContents contents,
+                            vk::ClearValue clearColor = vk::ClearColorValue(0.0f, 0.0f, 0.0f, 1.0f));
+        void endColorPass(vk::CommandBuffer commandBuffer, uint32_t imageIndex);
+        void setViewportAndScissor(vk::CommandBuffer commandBuffer);
+
+        // Key for whatever a recording renders into: the framebuffer, or the view with dynamic rendering
+        uint64_t renderTarget(uint32_t imageIndex) const;
+
+        const AppConfig& config() const { return m_config; }
+        const DeviceFeatures& features() const { return m_features; }
+        GLFWwindow* window() const { return m_window; }
+        vk::PhysicalDevice physicalDevice() const { return m_physicalDevice; }
+        vk::Device device() const { return m_device; }
+        const Renderer::QueueFamilies& queueFamilies() const { return m_queueFamilies; }
+        vk::Queue queue() const { return m_queue; }
+        vk::Queue computeQueue() const { return m_computeQueue; }
+        vk::Queue transferQueue() const { return m_transferQueue; }
+        vk::CommandPool commandPool() const { return m_commandPool; }
+        Renderer::SwapchainManager& swapchain() { return *m_swapchain; }
+        const Renderer::SwapchainManager& swapchain() const { return *m_swapchain; }
+        vk::RenderPass renderPass() const { return m_renderPass; }
+        Renderer::FramePacer& framePacer() { return *m_framePacer; }
+        ShaderLoader::ShaderLoader& shaderLoader() { return *m_shaderLoader; }
+        Renderer::ShaderModuleCache& shaderModules() { return *m_shaderModules; }
+        Renderer::GraphicsPipelineLibrary& pipelineLibrary() { return *m_pipelineLibrary; }
+
+    private:
+        void initWindow();
+        void initVulkan();
+        void createInstance();
+        void createSurface();
+        void pickPhysicalDevice();
+        void createDevice();
+        void createSwapchain();
+        void createRenderPass();
+        void createPipelineLibrary();
+        void createFrameResources();
+        void mainLoop();
+        void drawFrame();
+        void pollShaderReload();
+        void recreateSwapchain();
+        vk::Extent2D windowExtent();
+        void cleanup();
+
+        static void framebufferResizeCallback(GLFWwindow* window, int width, int height);
+
+        AppConfig      m_config;
+        DeviceFeatures m_features;
+        bool           m_validation = false;
+
+        GLFWwindow*             m_window = nullptr;
+        vk::Instance            m_instance;
+        vk::SurfaceKHR          m_surface;
+        vk::PhysicalDevice      m_physicalDevice;
+        vk::Device              m_device;
+        Renderer::QueueFamilies m_queueFamilies;
+        vk::Queue               m_queue;
+        vk::Queue               m_computeQueue;
+        vk::Queue               m_transferQueue;
+
+        std::unique_ptr<Renderer::SwapchainManager> m_swapchain;
+        std::unique_ptr<Renderer::DynamicRendering> m_dynamicRendering;
+        vk::RenderPass                              m_renderPass;
+        bool                                        m_framebufferResized = false;
+
+        std::unique_ptr<ShaderLoader::ShaderLoader>        m_shaderLoader;
+        std::unique_ptr<Renderer::ShaderModuleCache>       m_shaderModules;
+        vk::PipelineCache                                  m_pipelineCache;
+        Renderer::PipelineManifest                         m_pipelineManifest;
+        std::unique_ptr<Renderer::GraphicsPipelineLibrary> m_pipelineLibrary;
+        double                                             m_lastShaderReloadCheck = 0.0;
+
+        // One acquire semaphore per frame slot; the swapchain owns one present semaphore per image
+        std::unique_ptr<Renderer::FramePacer> m_framePacer;
+        std::vector<vk::Semaphore>            m_acquireSemaphores;
+        vk::CommandPool                       m_commandPool;
+    };
+
+} // namespace Core
+
+#endif //VULKANAPP_H
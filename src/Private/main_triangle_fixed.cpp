@@ -1,13 +1,15 @@
 #include <iostream>
-#include <fstream>
 #include <stdexcept>
 #include <vector>
-#include <cstring>
 #include <cstdlib>
+#include <cstdio>
 #include <memory>
 #include <algorithm>
-#include <limits>
 #include <array>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <string>
 
 // Use traditional Vulkan-Hpp headers without RAII
 #include <vulkan/vulkan.hpp>
@@ -16,19 +18,33 @@
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 
+#include "../Core/Public/VulkanApp.h"
+#include "../Renderer/Public/CommandCache.h"
+#include "../Renderer/Public/DescriptorAllocator.h"
+#include "../Renderer/Public/DrawBatcher.h"
+#include "../Renderer/Public/GpuAllocator.h"
+#include "../Renderer/Public/ParallelRecorder.h"
+#include "../Renderer/Public/ShaderObjects.h"
+#include "../Renderer/Public/UniformRing.h"
+#include "../Renderer/Public/UploadQueue.h"
+
 constexpr uint32_t WIDTH = 800;
 constexpr uint32_t HEIGHT = 600;
-constexpr int MAX_FRAMES_IN_FLIGHT = 2;
+// Overridden with --frames-in-flight N; 3-4 helps when recording is the bottleneck
+constexpr uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
 
-const std::vector validationLayers = {
-    "VK_LAYER_KHRONOS_validation"
-};
+// Shaders are loaded through ShaderLoader and reloaded when these files change on disk
+const std::string VERTEX_SHADER_PATH = "../shaders/custom_vertex.vert.spv";
+const std::string FRAGMENT_SHADER_PATH = "../shaders/custom_fragment.frag.spv";
+const std::string INSTANCED_SHADER_PATH = "../shaders/instanced.vert.spv";
+const std::string SHADER_DEPENDENCY_GRAPH = "shader_dependencies.txt";
 
-#ifdef NDEBUG
-constexpr bool enableValidationLayers = false;
-#else
-constexpr bool enableValidationLayers = true;
-#endif
+// Pipelines seen by earlier runs are rebuilt in the background at startup, into a cache kept on disk
+const std::string PIPELINE_MANIFEST_PATH = "pipeline_manifest.txt";
+const std::string PIPELINE_CACHE_PATH = "pipeline_cache.bin";
+
+// Draw lists at least this long are recorded on worker threads every frame instead of cached
+constexpr size_t PARALLEL_RECORDING_THRESHOLD = 1024;
 
 struct Vertex {
     glm::vec2 pos;
@@ -46,6 +62,35 @@ struct Vertex {
     }
 };
 
+// Per-frame values, read by shaders as the std140 block at set 0, binding 0
+struct FrameParameters {
+    float     time;
+    float     deltaTime;
+    glm::vec2 resolution;
+};
+
+// Per-draw values, pushed as constants with each draw
+struct DrawParameters {
+    uint32_t drawIndex;
+};
+
+constexpr vk::ShaderStageFlags PARAMETER_STAGES = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment;
+
+// Per-instance data of the instanced stress scene: xy offset, zw scale
+struct InstanceTransform {
+    glm::vec4 offsetScale;
+
+    static vk::VertexInputBindingDescription getBindingDescription() {
+        return { 1, sizeof(InstanceTransform), vk::VertexInputRate::eInstance };
+    }
+
+    static std::array<vk::VertexInputAttributeDescription, 1> getAttributeDescriptions() {
+        return {
+            vk::VertexInputAttributeDescription( 2, 1, vk::Format::eR32G32B32A32Sfloat, offsetof(InstanceTransform, offsetScale) )
+        };
+    }
+};
+
 const std::vector<Vertex> vertices = {
     {{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}},
     {{0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}},
@@ -57,724 +102,454 @@ const std::vector<uint16_t> indices = {
     0, 1, 2, 2, 3, 0
 };
 
-class HelloTriangleApplication {
+Core::AppConfig appConfig(uint32_t framesInFlight) {
+    Core::AppConfig config;
+    config.title = "Vulkan";
+    config.width = WIDTH;
+    config.height = HEIGHT;
+    config.framesInFlight = framesInFlight;
+    config.shaderObjects = true;
+    config.shaderDependencyGraph = SHADER_DEPENDENCY_GRAPH;
+    config.pipelineManifestPath = PIPELINE_MANIFEST_PATH;
+    config.pipelineCachePath = PIPELINE_CACHE_PATH;
+    return config;
+}
+
+// Window, device, swapchain, pipeline library and the frame loop come from Core::VulkanApp;
+// this adds geometry, per-frame parameters and the three ways of recording the draw list
+class HelloTriangleApplication : public Core::VulkanApp {
 public:
-    void run() {
-        initWindow();
-        initVulkan();
-        mainLoop();
-        cleanup();
-    }
+    explicit HelloTriangleApplication(uint32_t framesInFlight = DEFAULT_FRAMES_IN_FLIGHT, size_t drawCount = 1,
+                                      uint32_t instanceCount = 0)
+        : Core::VulkanApp(appConfig(framesInFlight))
+        // Every draw is the same quad for now; --draws N repeats it to load the recording path
+        , drawList(std::max<size_t>(drawCount, 1), vk::DrawIndexedIndirectCommand(static_cast<uint32_t>(indices.size()), 1, 0, 0, 0))
+        , stressInstanceCount(instanceCount) {}
 
 private:
-    GLFWwindow *                     window = nullptr;
-    vk::Instance                     instance;
-    vk::DebugUtilsMessengerEXT       debugMessenger;
-    vk::SurfaceKHR                   surface;
-    vk::PhysicalDevice               physicalDevice;
-    vk::Device                       device;
-    uint32_t                         queueIndex = ~0;
-    vk::Queue                        queue;
-
-    vk::SwapchainKHR swapChain;
-    std::vector<vk::Image> swapChainImages;
-    vk::Format swapChainImageFormat = vk::Format::eUndefined;
-    vk::Extent2D swapChainExtent;
-    std::vector<vk::ImageView> swapChainImageViews;
-
+    vk::DescriptorSetLayout frameSetLayout;
     vk::PipelineLayout pipelineLayout;
+    // Pipelines are fast-linked from shared parts, then swapped for optimized builds as those
+    // finish in the background; the handles below are refreshed whenever that happens
+    Renderer::GraphicsPipelineLibrary::PipelineId graphicsPipelineId = 0;
+    Renderer::GraphicsPipelineLibrary::PipelineId instancedPipelineId = 0;
     vk::Pipeline graphicsPipeline;
-    vk::RenderPass renderPass;
-    std::vector<vk::Framebuffer> swapChainFramebuffers;
 
-    vk::Buffer vertexBuffer;
-    vk::DeviceMemory vertexBufferMemory;
-    vk::Buffer indexBuffer;
-    vk::DeviceMemory indexBufferMemory;
+    // With VK_EXT_shader_object the main draw binds unlinked vertex and fragment shaders
+    // instead of graphicsPipeline, so a reload rebuilds just the stage that changed
+    std::unique_ptr<Renderer::ShaderObjects> shaderObjects;
+    Renderer::GraphicsPipelineDesc graphicsPipelineDesc;
+
+    // Every buffer and image is sub-allocated from a few large blocks per memory type
+    std::unique_ptr<Renderer::GpuAllocator> gpuAllocator;
+    Renderer::AllocatedBuffer vertexBuffer;
+    Renderer::AllocatedBuffer indexBuffer;
+
+    // Per-frame sets come from pools reset each frame; sets that never change are cached
+    std::unique_ptr<Renderer::DescriptorAllocator> descriptorAllocator;
+
+    // FrameParameters live in a dynamic uniform ring bound once per recording; the set is written once
+    std::unique_ptr<Renderer::UniformRing> uniformRing;
+    vk::DescriptorSet frameDescriptorSet;
+    double lastFrameTime = 0.0;
+
+    // Geometry streams through a staging ring on the transfer queue; frames wait for it on the GPU
+    std::unique_ptr<Renderer::UploadQueue> uploadQueue;
+    uint64_t geometryTicket = 0;
+
+    // Frame command buffers are recorded once per framebuffer and replayed until the bound
+    // pipelines change. The draw list is fixed at construction, so its version stays 0 in the key
+    std::unique_ptr<Renderer::CommandBufferCache> commandCache;
+    std::unique_ptr<Renderer::ParallelRecorder> commandRecorder;
+    std::vector<vk::DrawIndexedIndirectCommand> drawList;
+
+    // --instances N replaces the draw list with N objects submitted one by one through the
+    // batcher, which folds them into a few instanced indirect draws
+    uint32_t stressInstanceCount;
+    std::vector<InstanceTransform> stressInstances;
+    vk::Pipeline instancedPipeline;
+    std::unique_ptr<Renderer::DrawBatcher> drawBatcher;
 
-    vk::CommandPool commandPool;
-    std::vector<vk::CommandBuffer> commandBuffers;
-
-    std::vector<vk::Semaphore> presentCompleteSemaphore;
-    std::vector<vk::Semaphore> renderFinishedSemaphore;
-    std::vector<vk::Fence> inFlightFences;
-    uint32_t semaphoreIndex = 0;
     uint32_t currentFrame = 0;
+    double lastStatsUpdate = 0.0;
 
-    bool framebufferResized = false;
-
-    std::vector<const char*> requiredDeviceExtension = {
-        vk::KHRSwapchainExtensionName
-    };
-
-    void initWindow() {
-        glfwInit();
-
-        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-
-        window = glfwCreateWindow(WIDTH, HEIGHT, "Vulkan", nullptr, nullptr);
-        glfwSetWindowUserPointer(window, this);
-        glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);
-    }
-
-    static void framebufferResizeCallback(GLFWwindow* window, int width, int height) {
-        auto app = static_cast<HelloTriangleApplication*>(glfwGetWindowUserPointer(window));
-        app->framebufferResized = true;
-    }
-
-    void initVulkan() {
-        createInstance();
-        setupDebugMessenger();
-        createSurface();
-        pickPhysicalDevice();
-        createLogicalDevice();
-        createSwapChain();
-        createImageViews();
-        createRenderPass();
+    void onInit() override {
         createGraphicsPipeline();
-        createFramebuffers();
-        createCommandPool();
+        createAllocator();
         createVertexBuffer();
         createIndexBuffer();
-        createCommandBuffers();
-        createSyncObjects();
-    }
-
-    void mainLoop() {
-        while (!glfwWindowShouldClose(window)) {
-            glfwPollEvents();
-            drawFrame();
-        }
-
-        device.waitIdle();
+        submitUploads();
+        createFrameParameters();
+        createCommandRecording();
     }
 
-    void cleanupSwapChain() {
-        for (auto& framebuffer : swapChainFramebuffers) {
-            device.destroyFramebuffer(framebuffer);
-        }
-
-        for (auto& imageView : swapChainImageViews) {
-            device.destroyImageView(imageView);
-        }
-        device.destroySwapchainKHR(swapChain);
-    }
-
-    void cleanup() {
-        cleanupSwapChain();
-
-        // Fix: Destroy semaphores with correct loop count
-        for (size_t i = 0; i < swapChainImages.size(); i++) {
-            device.destroySemaphore(renderFinishedSemaphore[i]);
-            device.destroySemaphore(presentCompleteSemaphore[i]);
-        }
-
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-            device.destroyFence(inFlightFences[i]);
-        }
-
-        device.destroyCommandPool(commandPool);
-        device.destroyPipeline(graphicsPipeline);
-        device.destroyPipelineLayout(pipelineLayout);
-        device.destroyRenderPass(renderPass);
-        device.destroy();
-
-        // Skip debug messenger cleanup since we disabled it
-        // if (enableValidationLayers) {
-        //     instance.destroyDebugUtilsMessengerEXT(debugMessenger);
-        // }
-
-        instance.destroySurfaceKHR(surface);
-        instance.destroy();
-
-        glfwDestroyWindow(window);
-        glfwTerminate();
+    void onCleanup() override {
+        commandRecorder.reset();
+        commandCache.reset();
+        drawBatcher.reset();
+        uniformRing.reset();
+        descriptorAllocator.reset();
+        uploadQueue.reset();
+        gpuAllocator->destroyBuffer(indexBuffer);
+        gpuAllocator->destroyBuffer(vertexBuffer);
+        gpuAllocator.reset();
+        shaderObjects.reset();
+        device().destroyPipelineLayout(pipelineLayout);
+        device().destroyDescriptorSetLayout(frameSetLayout);
     }
 
-    void recreateSwapChain() {
-        int width = 0, height = 0;
-        glfwGetFramebufferSize(window, &width, &height);
-        while (width == 0 || height == 0) {
-            glfwGetFramebufferSize(window, &width, &height);
-            glfwWaitEvents();
-        }
-
-        device.waitIdle();
-
-        cleanupSwapChain();
-        createSwapChain();
-        createImageViews();
-        createFramebuffers();
+    // New framebuffers may reuse the old handles, so nothing recorded against them is valid
+    void onSwapchainRecreated() override {
+        commandCache->invalidateAll();
     }
 
-    void createInstance() {
-        vk::ApplicationInfo appInfo(
-            "Hello Triangle",
-            VK_MAKE_VERSION(1, 0, 0),
-            "No Engine",
-            VK_MAKE_VERSION(1, 0, 0),
-            VK_API_VERSION_1_0
-        );
-
-        // Get the required extensions.
-        auto requiredExtensions = getRequiredExtensions();
+    void createGraphicsPipeline() {
+        vk::DescriptorSetLayoutBinding frameBinding(0, vk::DescriptorType::eUniformBufferDynamic, 1, PARAMETER_STAGES);
+        frameSetLayout = device().createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo({}, 1, &frameBinding));
 
-        vk::InstanceCreateInfo createInfo(
+        vk::PushConstantRange pushConstantRange(PARAMETER_STAGES, 0, sizeof(DrawParameters));
+        vk::PipelineLayoutCreateInfo pipelineLayoutInfo(
             {},
-            &appInfo,
-            enableValidationLayers ? static_cast<uint32_t>(validationLayers.size()) : 0,
-            enableValidationLayers ? validationLayers.data() : nullptr,
-            static_cast<uint32_t>(requiredExtensions.size()),
-            requiredExtensions.data()
+            1,
+            &frameSetLayout,
+            1,
+            &pushConstantRange
         );
 
-        instance = vk::createInstance(createInfo);
-    }
+        pipelineLayout = device().createPipelineLayout(pipelineLayoutInfo);
 
-    void setupDebugMessenger() {
-        // Disable debug messenger for now to avoid linker issues
-        // if (!enableValidationLayers) return;
-        return; // Skip debug messenger setup
-    }
-
-    void createSurface() {
-        VkSurfaceKHR _surface;
-        if (glfwCreateWindowSurface(static_cast<VkInstance>(instance), window, nullptr, &_surface) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create window surface!");
+        // Load custom vertex and fragment shaders - users can easily edit these!
+        // Recompiling a .spv while the app runs swaps it in
+        loadShader(VERTEX_SHADER_PATH);
+        loadShader(FRAGMENT_SHADER_PATH);
+        if (stressInstanceCount > 0) {
+            loadShader(INSTANCED_SHADER_PATH);
         }
-        surface = vk::SurfaceKHR(_surface);
-    }
-
-    void pickPhysicalDevice() {
-        std::vector<vk::PhysicalDevice> devices = instance.enumeratePhysicalDevices();
-
-        for (const auto& device : devices) {
-            if (isDeviceSuitable(device)) {
-                physicalDevice = device;
-                break;
-            }
+        warmUpPipelines(pipelineLayout);
+
+        graphicsPipelineDesc = describePipeline(false);
+        if (features().shaderObjects) {
+            shaderObjects = std::make_unique<Renderer::ShaderObjects>(
+                device(), std::vector<vk::DescriptorSetLayout>{frameSetLayout}, std::vector<vk::PushConstantRange>{pushConstantRange});
+            shaderObjects->setStage(vk::ShaderStageFlagBits::eVertex, *shaderLoader().getModule(VERTEX_SHADER_PATH));
+            shaderObjects->setStage(vk::ShaderStageFlagBits::eFragment, *shaderLoader().getModule(FRAGMENT_SHADER_PATH));
+        } else {
+            graphicsPipelineId = buildPipeline(graphicsPipelineDesc, VERTEX_SHADER_PATH, FRAGMENT_SHADER_PATH);
+            graphicsPipeline = pipelineLibrary().pipeline(graphicsPipelineId);
         }
 
-        if (!physicalDevice) {
-            throw std::runtime_error("failed to find a suitable GPU!");
+        // Shares the fragment shader and output parts with the main pipeline
+        if (stressInstanceCount > 0) {
+            instancedPipelineId = buildPipeline(describePipeline(true), INSTANCED_SHADER_PATH, FRAGMENT_SHADER_PATH);
+            instancedPipeline = pipelineLibrary().pipeline(instancedPipelineId);
         }
     }
 
-    bool isDeviceSuitable(vk::PhysicalDevice device) {
-        auto queueFamilies = device.getQueueFamilyProperties();
-
-        bool graphicsQueueFound = false;
-        for (uint32_t i = 0; i < queueFamilies.size(); i++) {
-            if (queueFamilies[i].queueFlags & vk::QueueFlagBits::eGraphics) {
-                if (device.getSurfaceSupportKHR(i, surface)) {
-                    queueIndex = i;
-                    graphicsQueueFound = true;
-                    break;
+    // Everything but the shaders; the instanced variant adds InstanceTransform at binding 1
+    Renderer::GraphicsPipelineDesc describePipeline(bool instanced) {
+        Renderer::GraphicsPipelineDesc desc = VulkanApp::describePipeline(pipelineLayout);
+        desc.bindings = {Vertex::getBindingDescription()};
+        auto vertexAttributes = Vertex::getAttributeDescriptions();
+        desc.attributes.assign(vertexAttributes.begin(), vertexAttributes.end());
+        if (instanced) {
+            desc.bindings.push_back(InstanceTransform::getBindingDescription());
+            for (const auto& attribute : InstanceTransform::getAttributeDescriptions()) {
+                desc.attributes.push_back(attribute);
+            }
+        }
+        return desc;
+    }
+
+    // Shader objects swap only the stage whose file changed; pipelines are rebuilt, which with
+    // the pipeline library recompiles just the part that changed and relinks
+    void onShadersReloaded(const std::vector<std::string>& reloaded) override {
+        if (shaderObjects) {
+            for (const auto& path : reloaded) {
+                if (path == VERTEX_SHADER_PATH) {
+                    shaderObjects->setStage(vk::ShaderStageFlagBits::eVertex, *shaderLoader().getModule(path), framePacer().signalValue());
+                } else if (path == FRAGMENT_SHADER_PATH) {
+                    shaderObjects->setStage(vk::ShaderStageFlagBits::eFragment, *shaderLoader().getModule(path), framePacer().signalValue());
                 }
             }
+        } else {
+            buildPipeline(graphicsPipelineDesc, VERTEX_SHADER_PATH, FRAGMENT_SHADER_PATH, graphicsPipelineId);
+            graphicsPipeline = pipelineLibrary().pipeline(graphicsPipelineId);
         }
-
-        return graphicsQueueFound;
-    }
-
-    void createLogicalDevice() {
-        float queuePriority = 1.0f;
-        vk::DeviceQueueCreateInfo queueCreateInfo(
-            {},
-            queueIndex,
-            1,
-            &queuePriority
-        );
-
-        vk::PhysicalDeviceFeatures deviceFeatures{};
-
-        vk::DeviceCreateInfo createInfo(
-            {},
-            1,
-            &queueCreateInfo,
-            enableValidationLayers ? static_cast<uint32_t>(validationLayers.size()) : 0,
-            enableValidationLayers ? validationLayers.data() : nullptr,
-            static_cast<uint32_t>(requiredDeviceExtension.size()),
-            requiredDeviceExtension.data(),
-            &deviceFeatures
-        );
-
-        device = physicalDevice.createDevice(createInfo);
-        queue = device.getQueue(queueIndex, 0);
-    }
-
-    void createSwapChain() {
-        auto surfaceCapabilities = physicalDevice.getSurfaceCapabilitiesKHR(surface);
-        swapChainImageFormat = chooseSwapSurfaceFormat(physicalDevice.getSurfaceFormatsKHR(surface));
-        swapChainExtent = chooseSwapExtent(surfaceCapabilities);
-
-        uint32_t imageCount = surfaceCapabilities.minImageCount + 1;
-        if (surfaceCapabilities.maxImageCount > 0 && imageCount > surfaceCapabilities.maxImageCount) {
-            imageCount = surfaceCapabilities.maxImageCount;
+        if (instancedPipeline) {
+            buildPipeline(describePipeline(true), INSTANCED_SHADER_PATH, FRAGMENT_SHADER_PATH, instancedPipelineId);
+            instancedPipeline = pipelineLibrary().pipeline(instancedPipelineId);
         }
-
-        vk::SwapchainCreateInfoKHR createInfo(
-            {},
-            surface,
-            imageCount,
-            swapChainImageFormat,
-            vk::ColorSpaceKHR::eSrgbNonlinear,
-            swapChainExtent,
-            1,
-            vk::ImageUsageFlagBits::eColorAttachment,
-            vk::SharingMode::eExclusive,
-            0,
-            nullptr,
-            surfaceCapabilities.currentTransform,
-            vk::CompositeAlphaFlagBitsKHR::eOpaque,
-            chooseSwapPresentMode(physicalDevice.getSurfacePresentModesKHR(surface)),
-            VK_TRUE
-        );
-
-        swapChain = device.createSwapchainKHR(createInfo);
-        swapChainImages = device.getSwapchainImagesKHR(swapChain);
     }
 
-    void createImageViews() {
-        swapChainImageViews.resize(swapChainImages.size());
-
-        for (size_t i = 0; i < swapChainImages.size(); i++) {
-            vk::ImageViewCreateInfo createInfo(
-                {},
-                swapChainImages[i],
-                vk::ImageViewType::e2D,
-                swapChainImageFormat,
-                {},
-                { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 }
-            );
-
-            swapChainImageViews[i] = device.createImageView(createInfo);
+    // The cache key follows the handles, so cached command buffers re-record against them
+    void onPipelinesChanged() override {
+        if (graphicsPipeline) {
+            graphicsPipeline = pipelineLibrary().pipeline(graphicsPipelineId);
         }
-    }
-
-    void createRenderPass() {
-        vk::AttachmentDescription colorAttachment(
-            {},
-            swapChainImageFormat,
-            vk::SampleCountFlagBits::e1,
-            vk::AttachmentLoadOp::eClear,
-            vk::AttachmentStoreOp::eStore,
-            vk::AttachmentLoadOp::eDontCare,
-            vk::AttachmentStoreOp::eDontCare,
-            vk::ImageLayout::eUndefined,
-            vk::ImageLayout::ePresentSrcKHR
-        );
-
-        vk::AttachmentReference colorAttachmentRef(0, vk::ImageLayout::eColorAttachmentOptimal);
-
-        vk::SubpassDescription subpass(
-            {},                           // flags
-            vk::PipelineBindPoint::eGraphics,  // pipelineBindPoint
-            {},                           // inputAttachments (empty)
-            colorAttachmentRef,           // colorAttachments
-            {},                           // resolveAttachments (empty)
-            nullptr,                      // depthStencilAttachment
-            {}                            // preserveAttachments (empty)
-        );
-
-        vk::RenderPassCreateInfo renderPassInfo(
-            {},
-            1,
-            &colorAttachment,
-            1,
-            &subpass
-        );
-
-        renderPass = device.createRenderPass(renderPassInfo);
-    }
-
-    void createGraphicsPipeline() {
-        // Load custom vertex and fragment shaders - users can easily edit these!
-        auto vertShaderCode = readFile("../shaders/custom_vertex.vert.spv");
-        auto fragShaderCode = readFile("../shaders/custom_fragment.frag.spv");
-
-        vk::ShaderModule vertShaderModule = createShaderModule(vertShaderCode);
-        vk::ShaderModule fragShaderModule = createShaderModule(fragShaderCode);
-
-        vk::PipelineShaderStageCreateInfo vertShaderStageInfo(
-            {},
-            vk::ShaderStageFlagBits::eVertex,
-            vertShaderModule,
-            "main"
-        );
-
-        vk::PipelineShaderStageCreateInfo fragShaderStageInfo(
-            {},
-            vk::ShaderStageFlagBits::eFragment,
-            fragShaderModule,
-            "main"
-        );
-
-        vk::PipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
-
-        // The existing shaders don't use vertex input, so we'll disable vertex input
-        vk::PipelineVertexInputStateCreateInfo vertexInputInfo(
-            {},
-            0,
-            nullptr,
-            0,
-            nullptr
-        );
-
-        vk::PipelineInputAssemblyStateCreateInfo inputAssembly(
-            {},
-            vk::PrimitiveTopology::eTriangleList,
-            VK_FALSE
-        );
-
-        vk::PipelineViewportStateCreateInfo viewportState(
-            {},
-            1,
-            nullptr,
-            1,
-            nullptr
-        );
-
-        vk::PipelineRasterizationStateCreateInfo rasterizer(
-            {},
-            VK_FALSE,
-            VK_FALSE,
-            vk::PolygonMode::eFill,
-            vk::CullModeFlagBits::eBack,
-            vk::FrontFace::eClockwise,
-            VK_FALSE,
-            0.0f,
-            0.0f,
-            0.0f,
-            1.0f
-        );
-
-        vk::PipelineMultisampleStateCreateInfo multisampling(
-            {},
-            vk::SampleCountFlagBits::e1,
-            VK_FALSE
-        );
-
-        vk::PipelineColorBlendAttachmentState colorBlendAttachment(
-            VK_FALSE,
-            vk::BlendFactor::eOne,
-            vk::BlendFactor::eZero,
-            vk::BlendOp::eAdd,
-            vk::BlendFactor::eOne,
-            vk::BlendFactor::eZero,
-            vk::BlendOp::eAdd,
-            vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA
-        );
-
-        vk::PipelineColorBlendStateCreateInfo colorBlending(
-            {},
-            VK_FALSE,
-            vk::LogicOp::eCopy,
-            1,
-            &colorBlendAttachment
-        );
-
-        std::vector<vk::DynamicState> dynamicStates = {
-            vk::DynamicState::eViewport,
-            vk::DynamicState::eScissor
-        };
-
-        vk::PipelineDynamicStateCreateInfo dynamicState(
-            {},
-            static_cast<uint32_t>(dynamicStates.size()),
-            dynamicStates.data()
-        );
-
-        vk::PipelineLayoutCreateInfo pipelineLayoutInfo(
-            {},
-            0,
-            nullptr,
-            0,
-            nullptr
-        );
-
-        pipelineLayout = device.createPipelineLayout(pipelineLayoutInfo);
-
-        vk::GraphicsPipelineCreateInfo pipelineInfo(
-            {},
-            2,
-            shaderStages,
-            &vertexInputInfo,
-            &inputAssembly,
-            nullptr,
-            &viewportState,
-            &rasterizer,
-            &multisampling,
-            nullptr,
-            &colorBlending,
-            &dynamicState,
-            pipelineLayout,
-            renderPass,  // Use the render pass instead of nullptr
-            0
-        );
-
-        auto result = device.createGraphicsPipeline(nullptr, pipelineInfo);
-        if (result.result != vk::Result::eSuccess) {
-            throw std::runtime_error("failed to create graphics pipeline!");
-        }
-        graphicsPipeline = result.value;
-
-        device.destroyShaderModule(fragShaderModule);
-        device.destroyShaderModule(vertShaderModule);
-    }
-
-    void createFramebuffers() {
-        swapChainFramebuffers.resize(swapChainImageViews.size());
-
-        for (size_t i = 0; i < swapChainImageViews.size(); i++) {
-            vk::ImageView attachments[] = {
-                swapChainImageViews[i]
-            };
-
-            vk::FramebufferCreateInfo framebufferInfo(
-                {},
-                renderPass,
-                1,
-                attachments,
-                swapChainExtent.width,
-                swapChainExtent.height,
-                1
-            );
-
-            swapChainFramebuffers[i] = device.createFramebuffer(framebufferInfo);
+        if (instancedPipeline) {
+            instancedPipeline = pipelineLibrary().pipeline(instancedPipelineId);
         }
     }
 
-    void createCommandPool() {
-        vk::CommandPoolCreateInfo poolInfo(
-            vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
-            queueIndex
-        );
-
-        commandPool = device.createCommandPool(poolInfo);
+    void createAllocator() {
+        gpuAllocator = std::make_unique<Renderer::GpuAllocator>(physicalDevice(), device());
+        uploadQueue = std::make_unique<Renderer::UploadQueue>(physicalDevice(), device(), transferQueue(), queueFamilies().transfer);
     }
 
+    // Device-local and shared with the transfer family, so no ownership transfer is needed
     void createVertexBuffer() {
-        // The existing shaders don't use vertex buffers, so we'll skip this
+        vk::DeviceSize size = sizeof(vertices[0]) * vertices.size();
+        vertexBuffer = gpuAllocator->createBuffer(size, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst,
+                                                  vk::MemoryPropertyFlagBits::eDeviceLocal, {}, queueFamilies().uniqueFamilies());
+        uploadQueue->upload(vertexBuffer.buffer, vertices);
     }
 
     void createIndexBuffer() {
-        // The existing shaders don't use index buffers, so we'll skip this
+        vk::DeviceSize size = sizeof(indices[0]) * indices.size();
+        indexBuffer = gpuAllocator->createBuffer(size, vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst,
+                                                 vk::MemoryPropertyFlagBits::eDeviceLocal, {}, queueFamilies().uniqueFamilies());
+        uploadQueue->upload(indexBuffer.buffer, indices);
     }
 
-    void createCommandBuffers() {
-        commandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
-
-        vk::CommandBufferAllocateInfo allocInfo(
-            commandPool,
-            vk::CommandBufferLevel::ePrimary,
-            MAX_FRAMES_IN_FLIGHT
-        );
-
-        commandBuffers = device.allocateCommandBuffers(allocInfo);
+    // Everything queued so far goes out in one submission; frames wait on its ticket
+    void submitUploads() {
+        geometryTicket = uploadQueue->flush();
     }
 
-    void recordCommandBuffer(uint32_t imageIndex) {
-        vk::CommandBufferBeginInfo beginInfo{};
-        commandBuffers[currentFrame].begin(beginInfo);
-
-        vk::ClearValue clearColor = vk::ClearColorValue(0.0f, 0.0f, 0.0f, 1.0f);
-        vk::RenderPassBeginInfo renderPassInfo(
-            renderPass,
-            swapChainFramebuffers[imageIndex],
-            { {0, 0}, swapChainExtent },
-            1,
-            &clearColor
-        );
-
-        commandBuffers[currentFrame].beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
-
-        commandBuffers[currentFrame].bindPipeline(vk::PipelineBindPoint::eGraphics, graphicsPipeline);
-
-        vk::Viewport viewport(0.0f, 0.0f, static_cast<float>(swapChainExtent.width), static_cast<float>(swapChainExtent.height), 0.0f, 1.0f);
-        commandBuffers[currentFrame].setViewport(0, 1, &viewport);
+    void createFrameParameters() {
+        descriptorAllocator = std::make_unique<Renderer::DescriptorAllocator>(device(), framePacer().framesInFlight());
+        uniformRing = std::make_unique<Renderer::UniformRing>(physicalDevice(), *gpuAllocator, framePacer().framesInFlight());
 
-        vk::Rect2D scissor({0, 0}, swapChainExtent);
-        commandBuffers[currentFrame].setScissor(0, 1, &scissor);
-
-        // Draw triangle with only 3 vertices since the new shader uses a simple triangle
-        commandBuffers[currentFrame].draw(3, 1, 0, 0);
-
-        commandBuffers[currentFrame].endRenderPass();
-        commandBuffers[currentFrame].end();
+        auto bufferInfo = uniformRing->descriptorInfo();
+        frameDescriptorSet = descriptorAllocator->getImmutable(frameSetLayout, {
+            Renderer::DescriptorWrite::buffer(0, vk::DescriptorType::eUniformBufferDynamic, bufferInfo.buffer,
+                                              bufferInfo.offset, bufferInfo.range)
+        });
+        lastFrameTime = glfwGetTime();
     }
 
-    void createSyncObjects() {
-        presentCompleteSemaphore.resize(swapChainImages.size());
-        renderFinishedSemaphore.resize(swapChainImages.size());
-        inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+    // The slot's first push sits at its slot offset, so recordings can bind that offset once
+    void bindFrameParameters(vk::CommandBuffer commandBuffer) {
+        uint32_t dynamicOffset = uniformRing->slotOffset(currentFrame);
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 0, frameDescriptorSet, dynamicOffset);
+    }
 
-        vk::SemaphoreCreateInfo semaphoreInfo{};
-        vk::FenceCreateInfo fenceInfo(vk::FenceCreateFlagBits::eSignaled);
+    void createCommandRecording() {
+        commandCache = std::make_unique<Renderer::CommandBufferCache>(device(), queueFamilies().graphics);
+        commandRecorder = std::make_unique<Renderer::ParallelRecorder>(device(), queueFamilies().graphics, framePacer().framesInFlight());
 
-        for (size_t i = 0; i < swapChainImages.size(); i++) {
-            presentCompleteSemaphore[i] = device.createSemaphore(semaphoreInfo);
-            renderFinishedSemaphore[i] = device.createSemaphore(semaphoreInfo);
+        if (stressInstanceCount > 0) {
+            drawBatcher = std::make_unique<Renderer::DrawBatcher>(*gpuAllocator, framePacer().framesInFlight(),
+                                                                  sizeof(InstanceTransform), 1, features().indirect);
+            createStressScene();
         }
+    }
 
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-            inFlightFences[i] = device.createFence(fenceInfo);
+    // A square grid of small quads covering the window
+    void createStressScene() {
+        uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(stressInstanceCount))));
+        float cell = 2.0f / static_cast<float>(side);
+        stressInstances.resize(stressInstanceCount);
+        for (uint32_t i = 0; i < stressInstanceCount; i++) {
+            float x = -1.0f + cell * (static_cast<float>(i % side) + 0.5f);
+            float y = -1.0f + cell * (static_cast<float>(i / side) + 0.5f);
+            stressInstances[i].offsetScale = glm::vec4(x, y, cell * 0.8f, cell * 0.8f);
         }
     }
 
-    void drawFrame() {
-        auto waitResult = device.waitForFences(1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
-        if (waitResult != vk::Result::eSuccess) {
-            throw std::runtime_error("failed to wait for fence!");
-        }
+    void recordCommandBuffer(vk::CommandBuffer commandBuffer, uint32_t imageIndex) {
+        beginColorPass(commandBuffer, imageIndex, vk::SubpassContents::eInline);
+        recordDraws(commandBuffer, 0, drawList.size());
+        endColorPass(commandBuffer, imageIndex);
+    }
 
-        auto result = device.acquireNextImageKHR(swapChain, UINT64_MAX, presentCompleteSemaphore[semaphoreIndex], nullptr);
-        if (result.result == vk::Result::eErrorOutOfDateKHR) {
-            recreateSwapChain();
-            return;
-        }
-        if (result.result != vk::Result::eSuccess && result.result != vk::Result::eSuboptimalKHR) {
-            throw std::runtime_error("failed to acquire swap chain image!");
-        }
-        uint32_t imageIndex = result.value;
+    // Records every frame: each object is submitted on its own and the batcher merges
+    // them by (pipeline, mesh) into instanced indirect draws
+    vk::CommandBuffer recordCommandBufferBatched(uint32_t imageIndex) {
+        // Alternate between the whole quad and its first triangle so there is more than one batch
+        const Renderer::MeshRange meshes[] = {
+            {static_cast<uint32_t>(indices.size()), 0, 0},
+            {3, 0, 0}
+        };
 
-        auto resetResult = device.resetFences(1, &inFlightFences[currentFrame]);
-        if (resetResult != vk::Result::eSuccess) {
-            throw std::runtime_error("failed to reset fence!");
+        drawBatcher->begin(currentFrame);
+        for (size_t i = 0; i < stressInstances.size(); i++) {
+            drawBatcher->add(instancedPipeline, meshes[i % 2], &stressInstances[i]);
         }
+        drawBatcher->end();
 
-        commandBuffers[currentFrame].reset();
-        recordCommandBuffer(imageIndex);
-
-        vk::PipelineStageFlags waitStages[] = {vk::PipelineStageFlagBits::eColorAttachmentOutput};
-        vk::SubmitInfo submitInfo(
-            1,
-            &presentCompleteSemaphore[semaphoreIndex],
-            waitStages,
-            1,
-            &commandBuffers[currentFrame],
-            1,
-            &renderFinishedSemaphore[imageIndex]
-        );
-
-        auto submitResult = queue.submit(1, &submitInfo, inFlightFences[currentFrame]);
-        if (submitResult != vk::Result::eSuccess) {
-            throw std::runtime_error("failed to submit draw command buffer!");
-        }
+        commandRecorder->beginFrame(currentFrame);
+        vk::CommandBuffer commandBuffer = commandRecorder->primary();
+        commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
 
-        vk::PresentInfoKHR presentInfo(
-            1,
-            &renderFinishedSemaphore[imageIndex],
-            1,
-            &swapChain,
-            &imageIndex
-        );
+        beginColorPass(commandBuffer, imageIndex, vk::SubpassContents::eInline);
+        setViewportAndScissor(commandBuffer);
 
-        auto presentResult = queue.presentKHR(presentInfo);
-        if (presentResult == vk::Result::eErrorOutOfDateKHR || presentResult == vk::Result::eSuboptimalKHR || framebufferResized) {
-            framebufferResized = false;
-            recreateSwapChain();
-        } else if (presentResult != vk::Result::eSuccess) {
-            throw std::runtime_error("failed to present swap chain image!");
-        }
+        vk::DeviceSize offset = 0;
+        commandBuffer.bindVertexBuffers(0, 1, &vertexBuffer.buffer, &offset);
+        commandBuffer.bindIndexBuffer(indexBuffer.buffer, 0, vk::IndexType::eUint16);
+        bindFrameParameters(commandBuffer);
+        drawBatcher->record(commandBuffer);
 
-        semaphoreIndex = (semaphoreIndex + 1) % presentCompleteSemaphore.size();
-        currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+        endColorPass(commandBuffer, imageIndex);
+        commandBuffer.end();
+        return commandBuffer;
     }
 
-    vk::ShaderModule createShaderModule(const std::vector<char>& code) {
-        vk::ShaderModuleCreateInfo createInfo(
-            {},
-            code.size(),
-            reinterpret_cast<const uint32_t*>(code.data())
-        );
-
-        return device.createShaderModule(createInfo);
-    }
+    // Records every frame: worker threads fill secondaries with slices of the draw list
+    vk::CommandBuffer recordCommandBufferParallel(uint32_t imageIndex) {
+        commandRecorder->beginFrame(currentFrame);
 
-    static vk::Format chooseSwapSurfaceFormat(const std::vector<vk::SurfaceFormatKHR>& availableFormats) {
-        for (const auto& format : availableFormats) {
-            if (format.format == vk::Format::eB8G8R8A8Srgb && format.colorSpace == vk::ColorSpaceKHR::eSrgbNonlinear) {
-                return format.format;
-            }
+        // Secondaries continue either the render pass or a dynamic rendering scope with the same formats
+        vk::Format colorFormat = swapchain().format();
+        vk::CommandBufferInheritanceRenderingInfo renderingInheritance({}, 0, colorFormat);
+        vk::CommandBufferInheritanceInfo inheritance(renderPass(), 0, features().dynamicRendering ? vk::Framebuffer() : swapchain().framebuffer(imageIndex));
+        if (features().dynamicRendering) {
+            inheritance.pNext = &renderingInheritance;
         }
-        return availableFormats[0].format;
-    }
-
-    static vk::PresentModeKHR chooseSwapPresentMode(const std::vector<vk::PresentModeKHR>& availablePresentModes) {
-        for (const auto& availablePresentMode : availablePresentModes) {
-            if (availablePresentMode == vk::PresentModeKHR::eMailbox) {
-                return availablePresentMode;
-            }
+        const auto& secondaries = commandRecorder->record(inheritance, drawList.size(),
+            [this](vk::CommandBuffer secondary, size_t begin, size_t end) {
+                recordDraws(secondary, begin, end);
+            });
+
+        vk::CommandBuffer commandBuffer = commandRecorder->primary();
+        commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+
+        beginColorPass(commandBuffer, imageIndex, vk::SubpassContents::eSecondaryCommandBuffers);
+        commandBuffer.executeCommands(secondaries);
+        endColorPass(commandBuffer, imageIndex);
+        commandBuffer.end();
+        return commandBuffer;
+    }
+
+    // Secondaries inherit nothing but the render pass or rendering formats, so each slice sets up its own state
+    void recordDraws(vk::CommandBuffer commandBuffer, size_t begin, size_t end) {
+        if (shaderObjects) {
+            // Shader objects carry no state, so everything the pipeline would have baked in is set here
+            shaderObjects->bind(commandBuffer);
+            shaderObjects->setState(commandBuffer, graphicsPipelineDesc, swapchain().extent());
+        } else {
+            commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, graphicsPipeline);
+            setViewportAndScissor(commandBuffer);
         }
-        return vk::PresentModeKHR::eFifo;
-    }
+        bindFrameParameters(commandBuffer);
 
-    vk::Extent2D chooseSwapExtent(const vk::SurfaceCapabilitiesKHR& capabilities) {
-        if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
-            return capabilities.currentExtent;
+        vk::DeviceSize offset = 0;
+        commandBuffer.bindVertexBuffers(0, 1, &vertexBuffer.buffer, &offset);
+        commandBuffer.bindIndexBuffer(indexBuffer.buffer, 0, vk::IndexType::eUint16);
+
+        for (size_t i = begin; i < end; i++) {
+            const auto& draw = drawList[i];
+            DrawParameters parameters{static_cast<uint32_t>(i)};
+            commandBuffer.pushConstants(pipelineLayout, PARAMETER_STAGES, 0, sizeof(parameters), &parameters);
+            commandBuffer.drawIndexed(draw.indexCount, draw.instanceCount, draw.firstIndex, draw.vertexOffset, draw.firstInstance);
         }
+    }
 
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+    void recordFrame(Core::Frame& frame) override {
+        currentFrame = frame.slot;
 
-        vk::Extent2D actualExtent = {
-            static_cast<uint32_t>(width),
-            static_cast<uint32_t>(height)
+        // Buffers parked by earlier changes can be reused once the frames that ran them are done
+        commandCache->collect(framePacer().completedValue());
+        uploadQueue->collect();
+        descriptorAllocator->beginFrame(currentFrame);
+        if (shaderObjects) {
+            shaderObjects->collect(framePacer().completedValue());
+        }
+        updateFrameParameters();
+
+        bool batched = drawBatcher != nullptr;
+        bool parallel = !batched && drawList.size() >= PARALLEL_RECORDING_THRESHOLD;
+        Renderer::CommandCacheKey cacheKey{
+            renderTarget(frame.imageIndex),
+            currentFrame,
+            shaderObjects ? shaderObjects->generation() : Renderer::CommandBufferCache::hashPipelines({graphicsPipeline})
         };
+        vk::CommandBuffer commandBuffer = batched
+            ? recordCommandBufferBatched(frame.imageIndex)
+            : parallel
+            ? recordCommandBufferParallel(frame.imageIndex)
+            : commandCache->get(cacheKey, [&](vk::CommandBuffer recording) {
+                  recordCommandBuffer(recording, frame.imageIndex);
+              });
+        if (!batched && !parallel) {
+            commandCache->markSubmitted(cacheKey, frame.signalValue);
+        }
+        frame.commandBuffers.push_back(commandBuffer);
 
-        actualExtent.width = std::clamp(actualExtent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
-        actualExtent.height = std::clamp(actualExtent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
+        // Vertex fetch waits for the geometry upload; once it has landed the wait is free
+        frame.waits.push_back({uploadQueue->semaphore(), geometryTicket, vk::PipelineStageFlagBits::eVertexInput});
 
-        return actualExtent;
+        updateFrameStats();
     }
 
-    std::vector<const char*> getRequiredExtensions() {
-        uint32_t glfwExtensionCount = 0;
-        const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    // The pacer has waited for this slot's previous frame, so its ring region is free to rewrite
+    void updateFrameParameters() {
+        double now = glfwGetTime();
+        FrameParameters parameters{
+            static_cast<float>(now),
+            static_cast<float>(now - lastFrameTime),
+            glm::vec2(static_cast<float>(swapchain().extent().width), static_cast<float>(swapchain().extent().height))
+        };
+        lastFrameTime = now;
 
-        std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        uniformRing->begin(currentFrame);
+        uniformRing->push(parameters);
+    }
 
-        if (enableValidationLayers) {
-            extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+    void updateFrameStats() {
+        double now = glfwGetTime();
+        if (now - lastStatsUpdate < 0.5) {
+            return;
         }
-
-        return extensions;
+        lastStatsUpdate = now;
+
+        const auto& stats = framePacer().stats();
+        char title[224];
+        int length = snprintf(title, sizeof(title), "Vulkan | CPU %.2f ms | GPU wait %.2f ms | latency %.2f ms | %u in flight",
+                              stats.cpuFrameMs, stats.cpuWaitMs, stats.gpuLatencyMs, stats.framesInFlight);
+        if (drawBatcher && length > 0 && static_cast<size_t>(length) < sizeof(title)) {
+            snprintf(title + length, sizeof(title) - length, " | %u instances in %u draws, %u calls",
+                     drawBatcher->instanceCount(), drawBatcher->drawCount(), drawBatcher->drawCallCount());
+        }
+        glfwSetWindowTitle(window(), title);
     }
+};
 
-    static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
-        VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
-        VkDebugUtilsMessageTypeFlagsEXT messageType,
-        const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
-        void* pUserData) {
-
-        std::cerr << "validation layer: " << pCallbackData->pMessage << std::endl;
-
-        return VK_FALSE;
-    }
+static void printUsage() {
+    std::cerr << "Usage: app [--frames-in-flight N] [--draws N] [--instances N]" << std::endl;
+}
 
-    static std::vector<char> readFile(const std::string& filename) {
-        std::ifstream file(filename, std::ios::ate | std::ios::binary);
+// A count and nothing else, in range for value's type
+template <typename T>
+static bool parseCount(const char* text, T& value) {
+    const char* end = text + strlen(text);
+    auto [ptr, ec] = std::from_chars(text, end, value);
+    return ec == std::errc() && ptr == end && ptr != text;
+}
 
-        if (!file.is_open()) {
-            throw std::runtime_error("failed to open file!");
+int main(int argc, char* argv[]) {
+    try {
+        uint32_t framesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
+        size_t drawCount = 1;
+        uint32_t instanceCount = 0;
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            bool parsed = true;
+            if (arg == "--frames-in-flight") {
+                parsed = i + 1 < argc && parseCount(argv[++i], framesInFlight);
+            } else if (arg == "--draws") {
+                parsed = i + 1 < argc && parseCount(argv[++i], drawCount);
+            } else if (arg == "--instances") {
+                parsed = i + 1 < argc && parseCount(argv[++i], instanceCount);
+            }
+            if (!parsed) {
+                printUsage();
+                return EXIT_FAILURE;
+            }
         }
 
-        size_t fileSize = (size_t) file.tellg();
-        std::vector<char> buffer(fileSize);
-
-        file.seekg(0);
-        file.read(buffer.data(), fileSize);
-
-        file.close();
-
-        return buffer;
-    }
-};
-
-int main() {
-    try {
-        HelloTriangleApplication app;
+        HelloTriangleApplication app(framesInFlight, drawCount, instanceCount);
         app.run();
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
@@ -0,0 +1,82 @@
+#include <iostream>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+
+#include "../ShaderLoader/Public/IShaderCompiler.h"
+#include "../ShaderLoader/Public/ShaderCache.h"
+#include "../ShaderLoader/Public/VariantCompiler.h"
+
+// Compiles every permutation in a variant manifest in parallel and writes a
+// directory that ShaderLoader::loadVariants can consume.
+//
+//   shader_variants <manifest> <output-dir> [-j N] [--cache DIR] [--compress] [-O0] [-g]
+//
+// --compress writes .spv.z modules; load those through createCompressedSpirvCompiler.
+
+static void printUsage() {
+    std::cerr << "Usage: shader_variants <manifest> <output-dir> [-j N] [--cache DIR] [--compress] [-O0] [-g]" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    std::string manifestPath = argv[1];
+    std::string outputDir = argv[2];
+    std::string cacheDir;
+    unsigned threads = 0;
+    bool compress = false;
+    ShaderLoader::CompileOptions options;
+
+    for (int i = 3; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) {
+            // A thread count and nothing else; 0 means one per hardware thread
+            const char* value = argv[++i];
+            const char* end = value + strlen(value);
+            auto [ptr, ec] = std::from_chars(value, end, threads);
+            if (ec != std::errc() || ptr != end || ptr == value) {
+                printUsage();
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "--cache" && i + 1 < argc) {
+            cacheDir = argv[++i];
+        } else if (arg == "--compress") {
+            compress = true;
+        } else if (arg == "-O0") {
+            options.optimize = false;
+        } else if (arg == "-g") {
+            options.debugInfo = true;
+        } else {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    ShaderLoader::VariantManifest manifest;
+    std::string error;
+    if (!ShaderLoader::parseVariantManifest(manifestPath, manifest, error)) {
+        std::cerr << error << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    auto compiler = ShaderLoader::createDefaultCompiler();
+    if (!cacheDir.empty()) {
+        compiler = ShaderLoader::createCachingCompiler(std::move(compiler), {.directory = cacheDir});
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto result = ShaderLoader::buildVariants(*compiler, manifest, options, outputDir, threads, compress);
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << result.infoLog << std::endl;
+    std::cout << "Finished in " << elapsed << "s" << std::endl;
+
+    return result.success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,80 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#include "../Public/AsyncCompute.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace Renderer {
+
+    AsyncComputeScheduler::AsyncComputeScheduler(vk::Device device, const QueueFamilies& families,
+                                                 vk::Queue graphicsQueue, vk::Queue computeQueue)
+        : m_device(device)
+        , m_graphicsQueue(graphicsQueue)
+        , m_computeQueue(computeQueue)
+        , m_computeTimeline(device)
+    {
+        m_computePool = device.createCommandPool(vk::CommandPoolCreateInfo(
+            vk::CommandPoolCreateFlagBits::eResetCommandBuffer, families.compute));
+    }
+
+    AsyncComputeScheduler::~AsyncComputeScheduler() {
+        waitIdle();
+        m_device.destroyCommandPool(m_computePool);
+    }
+
+    vk::CommandBuffer AsyncComputeScheduler::beginCompute() {
+        uint64_t completed = m_computeTimeline.completed();
+        auto it = std::find_if(m_computeBuffers.begin(), m_computeBuffers.end(), [&](const ComputeBuffer& buffer) {
+            return !buffer.inUse && buffer.retireValue <= completed;
+        });
+        if (it == m_computeBuffers.end()) {
+            ComputeBuffer buffer;
+            buffer.commandBuffer = m_device.allocateCommandBuffers(
+                vk::CommandBufferAllocateInfo(m_computePool, vk::CommandBufferLevel::ePrimary, 1)).front();
+            m_computeBuffers.push_back(buffer);
+            it = m_computeBuffers.end() - 1;
+        } else {
+            it->commandBuffer.reset();
+        }
+
+        it->inUse = true;
+        it->commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+        return it->commandBuffer;
+    }
+
+    uint64_t AsyncComputeScheduler::submitCompute(vk::CommandBuffer commandBuffer, const std::vector<SemaphoreWait>& waits) {
+        auto it = std::find_if(m_computeBuffers.begin(), m_computeBuffers.end(), [&](const ComputeBuffer& buffer) {
+            return buffer.commandBuffer == commandBuffer;
+        });
+        if (it == m_computeBuffers.end() || !it->inUse) {
+            throw std::runtime_error("submitCompute needs a command buffer from beginCompute");
+        }
+        commandBuffer.end();
+
+        std::vector<vk::Semaphore> waitSemaphores;
+        std::vector<uint64_t> waitValues;
+        std::vector<vk::PipelineStageFlags> waitStages;
+        for (const auto& wait : waits) {
+            waitSemaphores.push_back(wait.semaphore);
+            waitValues.push_back(wait.value);   // ignored for binary semaphores
+            waitStages.push_back(wait.stages);
+        }
+
+        uint64_t value = m_computeTimeline.next();
+        vk::Semaphore signal = m_computeTimeline.handle();
+        vk::TimelineSemaphoreSubmitInfo timelineInfo(waitValues, value);
+        vk::SubmitInfo submitInfo(waitSemaphores, waitStages, commandBuffer, signal, &timelineInfo);
+        m_computeQueue.submit(submitInfo);
+
+        it->retireValue = value;
+        it->inUse = false;
+        return value;
+    }
+
+    void AsyncComputeScheduler::waitIdle() {
+        m_computeTimeline.wait(m_computeTimeline.lastReserved());
+    }
+
+} // namespace Renderer
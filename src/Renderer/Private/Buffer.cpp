@@ -0,0 +1,73 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#include "../Public/Buffer.h"
+#include <stdexcept>
+
+namespace Renderer {
+
+    uint32_t findMemoryType(const vk::PhysicalDeviceMemoryProperties& memoryProperties, uint32_t typeBits,
+                            vk::MemoryPropertyFlags required, vk::MemoryPropertyFlags preferred) {
+        uint32_t fallback = UINT32_MAX;
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i) {
+            if (!(typeBits & (1u << i))) {
+                continue;
+            }
+            auto flags = memoryProperties.memoryTypes[i].propertyFlags;
+            if ((flags & required) != required) {
+                continue;
+            }
+            if ((flags & preferred) == preferred) {
+                return i;
+            }
+            if (fallback == UINT32_MAX) {
+                fallback = i;
+            }
+        }
+        return fallback;
+    }
+
+    Buffer createBuffer(vk::PhysicalDevice physicalDevice, vk::Device device, vk::DeviceSize size,
+                        vk::BufferUsageFlags usage, vk::MemoryPropertyFlags required,
+                        vk::MemoryPropertyFlags preferred) {
+        Buffer result;
+        result.size = size;
+        result.buffer = device.createBuffer(vk::BufferCreateInfo({}, size, usage, vk::SharingMode::eExclusive));
+
+        auto requirements = device.getBufferMemoryRequirements(result.buffer);
+        auto memoryProperties = physicalDevice.getMemoryProperties();
+        uint32_t memoryType = findMemoryType(memoryProperties, requirements.memoryTypeBits, required, preferred);
+        if (memoryType == UINT32_MAX) {
+            device.destroyBuffer(result.buffer);
+            throw std::runtime_error("No suitable memory type for buffer");
+        }
+        result.properties = memoryProperties.memoryTypes[memoryType].propertyFlags;
+
+        try {
+            result.memory = device.allocateMemory(vk::MemoryAllocateInfo(requirements.size, memoryType));
+            device.bindBufferMemory(result.buffer, result.memory, 0);
+            if (result.properties & vk::MemoryPropertyFlagBits::eHostVisible) {
+                result.mapped = device.mapMemory(result.memory, 0, VK_WHOLE_SIZE);
+            }
+        } catch (...) {
+            destroyBuffer(device, result);
+            throw;
+        }
+        return result;
+    }
+
+    void destroyBuffer(vk::Device device, Buffer& buffer) {
+        if (buffer.mapped) {
+            device.unmapMemory(buffer.memory);
+        }
+        if (buffer.buffer) {
+            device.destroyBuffer(buffer.buffer);
+        }
+        if (buffer.memory) {
+            device.freeMemory(buffer.memory);
+        }
+        buffer = {};
+    }
+
+} // namespace Renderer
@@ -0,0 +1,94 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#include "../Public/CommandCache.h"
+#include "ContentHash.h"
+#include <algorithm>
+
+namespace Renderer {
+
+    CommandBufferCache::CommandBufferCache(vk::Device device, uint32_t queueFamily)
+        : m_device(device)
+    {
+        m_pool = device.createCommandPool(vk::CommandPoolCreateInfo(
+            vk::CommandPoolCreateFlagBits::eResetCommandBuffer, queueFamily));
+    }
+
+    CommandBufferCache::~CommandBufferCache() {
+        // Frees every buffer allocated from it; callers wait for the device first
+        m_device.destroyCommandPool(m_pool);
+    }
+
+    vk::CommandBuffer CommandBufferCache::get(const CommandCacheKey& key, const RecordFunction& record) {
+        Target target(key.target, key.frameSlot);
+        auto it = m_entries.find(target);
+        if (it != m_entries.end()) {
+            if (it->second.key == key) {
+                ++m_hits;
+                return it->second.commandBuffer;
+            }
+            // Dirty: whatever the old recording referenced has changed
+            park(it->second);
+            m_entries.erase(it);
+        }
+
+        Entry entry;
+        entry.key = key;
+        entry.commandBuffer = acquire();
+        entry.commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eSimultaneousUse));
+        record(entry.commandBuffer);
+        entry.commandBuffer.end();
+        ++m_recordings;
+
+        m_entries.emplace(target, entry);
+        return entry.commandBuffer;
+    }
+
+    void CommandBufferCache::markSubmitted(const CommandCacheKey& key, uint64_t value) {
+        auto it = m_entries.find(Target(key.target, key.frameSlot));
+        if (it != m_entries.end()) {
+            it->second.lastSubmitted = std::max(it->second.lastSubmitted, value);
+        }
+    }
+
+    void CommandBufferCache::collect(uint64_t completedValue) {
+        auto retired = std::partition(m_parked.begin(), m_parked.end(),
+                                      [&](const Parked& parked) { return parked.lastSubmitted > completedValue; });
+        for (auto it = retired; it != m_parked.end(); ++it) {
+            m_free.push_back(it->commandBuffer);
+        }
+        m_parked.erase(retired, m_parked.end());
+    }
+
+    void CommandBufferCache::invalidateAll() {
+        for (auto& [target, entry] : m_entries) {
+            park(entry);
+        }
+        m_entries.clear();
+    }
+
+    uint64_t CommandBufferCache::hashPipelines(std::initializer_list<vk::Pipeline> pipelines) {
+        ShaderLoader::ContentHasher hasher;
+        for (auto pipeline : pipelines) {
+            hasher.updateValue(reinterpret_cast<uint64_t>(static_cast<VkPipeline>(pipeline)));
+        }
+        return hasher.digest();
+    }
+
+    vk::CommandBuffer CommandBufferCache::acquire() {
+        if (!m_free.empty()) {
+            vk::CommandBuffer commandBuffer = m_free.back();
+            m_free.pop_back();
+            commandBuffer.reset();
+            return commandBuffer;
+        }
+        return m_device.allocateCommandBuffers(
+            vk::CommandBufferAllocateInfo(m_pool, vk::CommandBufferLevel::ePrimary, 1)).front();
+    }
+
+    void CommandBufferCache::park(Entry& entry) {
+        m_parked.push_back({entry.commandBuffer, entry.lastSubmitted});
+    }
+
+} // namespace Renderer
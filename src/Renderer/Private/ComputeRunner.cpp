@@ -0,0 +1,365 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#include "../Public/ComputeRunner.h"
+#include "ContentHash.h"
+#include "SpirvReflection.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace Renderer {
+
+    namespace {
+
+        constexpr vk::DeviceSize kCopyAlignment = 16;
+
+        // Sets are keyed by buffer ranges, so many distinct array sizes would pile them up
+        constexpr size_t kMaxCachedDescriptorSets = 256;
+
+        constexpr vk::MemoryPropertyFlags kDirectMemory =
+            vk::MemoryPropertyFlagBits::eDeviceLocal | vk::MemoryPropertyFlagBits::eHostVisible |
+            vk::MemoryPropertyFlagBits::eHostCoherent | vk::MemoryPropertyFlagBits::eHostCached;
+
+        // Storage buffer ranges and fills work in whole 32-bit words
+        vk::DeviceSize wordAligned(size_t size) {
+            return (static_cast<vk::DeviceSize>(size) + 3) & ~vk::DeviceSize{3};
+        }
+
+        bool hasMemoryType(const vk::PhysicalDeviceMemoryProperties& properties, vk::MemoryPropertyFlags flags) {
+            return findMemoryType(properties, ~0u, flags) != UINT32_MAX;
+        }
+
+    } // namespace
+
+    ComputeRunner::ComputeRunner(vk::PhysicalDevice physicalDevice, vk::Device device, vk::Queue queue, uint32_t queueFamily,
+                                 vk::DeviceSize stagingSize)
+        : m_physicalDevice(physicalDevice)
+        , m_device(device)
+        , m_queue(queue)
+        , m_limits(physicalDevice.getProperties().limits)
+        , m_descriptors(device, 1, {{vk::DescriptorType::eStorageBuffer, 8.0f}}, 16)
+        , m_pipelines(device)
+    {
+        // Mapping device-local memory is only a win when host reads of it are cached;
+        // write-combined BAR memory would make every readback crawl
+        if (hasMemoryType(physicalDevice.getMemoryProperties(), kDirectMemory)) {
+            m_bufferMemory = kDirectMemory;
+        } else {
+            m_bufferMemory = vk::MemoryPropertyFlagBits::eDeviceLocal;
+            m_staging = std::make_unique<StagingRing>(physicalDevice, device, stagingSize);
+            // Half the ring per chunk lets one submission fill while the other is in flight
+            m_chunkSize = std::max<vk::DeviceSize>(stagingSize / 2 / kCopyAlignment * kCopyAlignment, kCopyAlignment);
+        }
+
+        m_commandPool = device.createCommandPool(vk::CommandPoolCreateInfo(
+            vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer, queueFamily));
+        auto commandBuffers = device.allocateCommandBuffers(vk::CommandBufferAllocateInfo(
+            m_commandPool, vk::CommandBufferLevel::ePrimary, static_cast<uint32_t>(m_submissions.size())));
+        for (size_t i = 0; i < m_submissions.size(); ++i) {
+            m_submissions[i].commandBuffer = commandBuffers[i];
+            m_submissions[i].fence = device.createFence({});
+        }
+    }
+
+    ComputeRunner::~ComputeRunner() {
+        completeAll(false);
+        m_pipelines.clear();
+
+        for (auto& submission : m_submissions) {
+            m_device.destroyFence(submission.fence);
+        }
+        m_device.destroyCommandPool(m_commandPool);
+
+        for (auto& [key, layouts] : m_layouts) {
+            m_device.destroyPipelineLayout(layouts.pipelineLayout);
+            m_device.destroyDescriptorSetLayout(layouts.setLayout);
+        }
+        for (auto& [binding, buffer] : m_buffers) {
+            destroyBuffer(m_device, buffer);
+        }
+    }
+
+    void ComputeRunner::run(const ShaderLoader::ShaderModule& module, const std::vector<ComputeBinding>& bindings,
+                            std::array<uint32_t, 3> invocations, const SpecializationConstants& constants) {
+        ShaderLoader::ShaderReflection reflection;
+        std::string error;
+        if (!ShaderLoader::reflectSpirv(module.spirv, reflection, error)) {
+            throw std::runtime_error("Failed to reflect compute shader: " + error);
+        }
+        if (reflection.executionModel != ShaderLoader::ExecutionModel::GLCompute) {
+            throw std::runtime_error("Shader is not a compute shader");
+        }
+        if (!constants.validate(reflection, error)) {
+            throw std::runtime_error(error);
+        }
+
+        // The workgroup size the pipeline will actually have once constants are applied
+        std::array<uint32_t, 3> localSize = reflection.localSize;
+        for (size_t d = 0; d < 3; ++d) {
+            uint32_t value = 0;
+            if (reflection.localSizeSpecIds[d] >= 0 && constants.get(static_cast<uint32_t>(reflection.localSizeSpecIds[d]), value)) {
+                localSize[d] = value;
+            }
+        }
+
+        std::array<uint32_t, 3> groups{};
+        for (size_t d = 0; d < 3; ++d) {
+            if (localSize[d] == 0 || localSize[d] > m_limits.maxComputeWorkGroupSize[d]) {
+                throw std::runtime_error("Workgroup size " + std::to_string(localSize[d]) + " exceeds the device limit");
+            }
+            groups[d] = invocations[d] / localSize[d] + (invocations[d] % localSize[d] != 0);
+            if (groups[d] > m_limits.maxComputeWorkGroupCount[d]) {
+                throw std::runtime_error("Dispatch of " + std::to_string(groups[d]) + " workgroups exceeds the device limit");
+            }
+        }
+        if (static_cast<uint64_t>(localSize[0]) * localSize[1] * localSize[2] > m_limits.maxComputeWorkGroupInvocations) {
+            throw std::runtime_error("Workgroup has more invocations than the device allows");
+        }
+
+        const Layouts& layouts = layoutsFor(bindings);
+        vk::Pipeline pipeline = m_pipelines.getComputePipeline(module, layouts.pipelineLayout, constants, reflection.entryPoint);
+
+        try {
+            for (const auto& binding : bindings) {
+                deviceBuffer(binding.binding, wordAligned(binding.size));
+            }
+            vk::DescriptorSet descriptorSet = writeDescriptorSet(layouts, bindings);
+
+            for (const auto& binding : bindings) {
+                upload(m_buffers.at(binding.binding), binding.input, binding.size);
+            }
+
+            auto commandBuffer = recordingCommandBuffer();
+            if (m_staging) {
+                vk::MemoryBarrier uploaded(vk::AccessFlagBits::eTransferWrite,
+                                           vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+                commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader,
+                                              {}, uploaded, nullptr, nullptr);
+            }
+
+            commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline);
+            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, layouts.pipelineLayout, 0, descriptorSet, nullptr);
+            if (groups[0] && groups[1] && groups[2]) {
+                commandBuffer.dispatch(groups[0], groups[1], groups[2]);
+            }
+
+            vk::MemoryBarrier written(vk::AccessFlagBits::eShaderWrite,
+                                      m_staging ? vk::AccessFlagBits::eTransferRead : vk::AccessFlagBits::eHostRead);
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                                          m_staging ? vk::PipelineStageFlagBits::eTransfer : vk::PipelineStageFlagBits::eHost,
+                                          {}, written, nullptr, nullptr);
+            m_submissions[m_current].hasWork = true;
+
+            for (const auto& binding : bindings) {
+                if (binding.output) {
+                    readBack(m_buffers.at(binding.binding), binding.output, binding.size);
+                }
+            }
+
+            submit();
+            completeAll(true);
+        } catch (...) {
+            // Don't leave submissions around that would copy into the caller's arrays later
+            completeAll(false);
+            throw;
+        }
+    }
+
+    const ComputeRunner::Layouts& ComputeRunner::layoutsFor(const std::vector<ComputeBinding>& bindings) {
+        std::vector<uint32_t> numbers;
+        numbers.reserve(bindings.size());
+        for (const auto& binding : bindings) {
+            numbers.push_back(binding.binding);
+        }
+        std::sort(numbers.begin(), numbers.end());
+        if (std::adjacent_find(numbers.begin(), numbers.end()) != numbers.end()) {
+            throw std::runtime_error("Compute bindings must use distinct binding numbers");
+        }
+
+        uint64_t key = ShaderLoader::ContentHasher().update(numbers.data(), numbers.size() * sizeof(uint32_t)).digest();
+        if (auto it = m_layouts.find(key); it != m_layouts.end()) {
+            return it->second;
+        }
+
+        std::vector<vk::DescriptorSetLayoutBinding> layoutBindings;
+        for (uint32_t number : numbers) {
+            layoutBindings.emplace_back(number, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute);
+        }
+
+        Layouts layouts;
+        layouts.setLayout = m_device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo({}, layoutBindings));
+        layouts.pipelineLayout = m_device.createPipelineLayout(vk::PipelineLayoutCreateInfo({}, layouts.setLayout));
+        return m_layouts.emplace(key, layouts).first->second;
+    }
+
+    vk::DescriptorSet ComputeRunner::writeDescriptorSet(const Layouts& layouts, const std::vector<ComputeBinding>& bindings) {
+        // Repeated runs of the same shape find their set already written
+        if (m_descriptors.immutableCount() >= kMaxCachedDescriptorSets) {
+            m_descriptors.resetImmutable();
+        }
+
+        std::vector<DescriptorWrite> writes;
+        writes.reserve(bindings.size());
+        for (const auto& binding : bindings) {
+            writes.push_back(DescriptorWrite::buffer(binding.binding, vk::DescriptorType::eStorageBuffer,
+                                                     m_buffers.at(binding.binding).buffer, 0, wordAligned(binding.size)));
+        }
+        return m_descriptors.getImmutable(layouts.setLayout, writes);
+    }
+
+    Buffer& ComputeRunner::deviceBuffer(uint32_t binding, vk::DeviceSize size) {
+        Buffer& buffer = m_buffers[binding];
+        size = std::max(size, vk::DeviceSize{4});
+        if (buffer.size < size) {
+            // Runs are synchronous, so no cached set pointing at the old buffer is still in use
+            m_descriptors.resetImmutable();
+            destroyBuffer(m_device, buffer);
+            buffer = createBuffer(m_physicalDevice, m_device, size,
+                                  vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc |
+                                  vk::BufferUsageFlagBits::eTransferDst,
+                                  m_bufferMemory);
+        }
+        return buffer;
+    }
+
+    vk::CommandBuffer ComputeRunner::recordingCommandBuffer() {
+        Submission& submission = m_submissions[m_current];
+        if (!submission.recording) {
+            if (submission.pending) {
+                complete(submission, true);
+            }
+            submission.commandBuffer.reset();
+            submission.commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+            submission.recording = true;
+        }
+        return submission.commandBuffer;
+    }
+
+    void ComputeRunner::submit() {
+        Submission& submission = m_submissions[m_current];
+        if (!submission.recording) {
+            return;
+        }
+        submission.commandBuffer.end();
+        submission.recording = false;
+        if (!submission.hasWork) {
+            return;
+        }
+
+        submission.stagingBatch = m_staging ? m_staging->close() : 0;
+        vk::SubmitInfo submitInfo({}, {}, submission.commandBuffer);
+        m_queue.submit(submitInfo, submission.fence);
+        submission.pending = true;
+        submission.hasWork = false;
+        m_current = (m_current + 1) % m_submissions.size();
+    }
+
+    void ComputeRunner::complete(Submission& submission, bool copyResults) {
+        if (submission.pending) {
+            if (m_device.waitForFences(submission.fence, VK_TRUE, UINT64_MAX) != vk::Result::eSuccess) {
+                throw std::runtime_error("Failed to wait for compute submission");
+            }
+            m_device.resetFences(submission.fence);
+            submission.pending = false;
+        }
+        if (copyResults) {
+            for (const auto& readback : submission.readbacks) {
+                memcpy(readback.destination, readback.source, readback.size);
+            }
+        }
+        submission.readbacks.clear();
+        if (m_staging && submission.stagingBatch) {
+            m_staging->retire(submission.stagingBatch);
+            submission.stagingBatch = 0;
+        }
+    }
+
+    void ComputeRunner::completeAll(bool copyResults) {
+        // Submissions rotate, so starting at the current slot visits the oldest first
+        for (size_t i = 0; i < m_submissions.size(); ++i) {
+            Submission& submission = m_submissions[(m_current + i) % m_submissions.size()];
+            if (submission.recording) {
+                // Never submitted, so nothing in it ran
+                submission.commandBuffer.end();
+                submission.recording = false;
+                submission.hasWork = false;
+                submission.readbacks.clear();
+            }
+            complete(submission, copyResults);
+        }
+        if (m_staging) {
+            // Regions recorded into a command buffer that was never submitted
+            m_staging->retire(m_staging->close());
+        }
+    }
+
+    StagingRing::Region ComputeRunner::stage(vk::DeviceSize size) {
+        StagingRing::Region region;
+        while (!m_staging->allocate(size, kCopyAlignment, region)) {
+            if (m_submissions[m_current].hasWork) {
+                // Hand the GPU what we have; switching submissions waits out the older one
+                submit();
+                recordingCommandBuffer();
+            } else if (m_staging->hasPendingBatches()) {
+                completeAll(true);
+                recordingCommandBuffer();
+            } else {
+                throw std::runtime_error("Staging allocation larger than the ring");
+            }
+        }
+        return region;
+    }
+
+    void ComputeRunner::upload(const Buffer& buffer, const void* data, size_t size) {
+        if (!m_staging) {
+            if (data) {
+                memcpy(buffer.mapped, data, size);
+            } else {
+                memset(buffer.mapped, 0, static_cast<size_t>(wordAligned(size)));
+            }
+            return;
+        }
+
+        if (!data) {
+            recordingCommandBuffer().fillBuffer(buffer.buffer, 0, wordAligned(size), 0);
+            m_submissions[m_current].hasWork = true;
+            return;
+        }
+
+        auto bytes = static_cast<const uint8_t*>(data);
+        for (size_t offset = 0; offset < size; ) {
+            size_t chunk = static_cast<size_t>(std::min<vk::DeviceSize>(size - offset, m_chunkSize));
+            StagingRing::Region region = stage(wordAligned(chunk));
+            memcpy(region.data, bytes + offset, chunk);
+
+            recordingCommandBuffer().copyBuffer(region.buffer, buffer.buffer,
+                                                vk::BufferCopy(region.offset, offset, region.size));
+            m_submissions[m_current].hasWork = true;
+            offset += chunk;
+        }
+    }
+
+    void ComputeRunner::readBack(const Buffer& buffer, void* data, size_t size) {
+        if (!m_staging) {
+            // Copied once the fence covering the dispatch signals
+            m_submissions[m_current].readbacks.push_back({data, buffer.mapped, size});
+            return;
+        }
+
+        auto bytes = static_cast<uint8_t*>(data);
+        for (size_t offset = 0; offset < size; ) {
+            size_t chunk = static_cast<size_t>(std::min<vk::DeviceSize>(size - offset, m_chunkSize));
+            StagingRing::Region region = stage(wordAligned(chunk));
+
+            recordingCommandBuffer().copyBuffer(buffer.buffer, region.buffer,
+                                                vk::BufferCopy(offset, region.offset, region.size));
+            Submission& submission = m_submissions[m_current];
+            submission.hasWork = true;
+            submission.readbacks.push_back({bytes + offset, region.data, chunk});
+            offset += chunk;
+        }
+    }
+
+} // namespace Renderer
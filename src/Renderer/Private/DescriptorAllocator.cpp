@@ -0,0 +1,191 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#include "../Public/DescriptorAllocator.h"
+#include "ContentHash.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace Renderer {
+
+    namespace {
+
+        const std::vector<DescriptorPoolRatio> kDefaultRatios = {
+            {vk::DescriptorType::eUniformBuffer,        2.0f},
+            {vk::DescriptorType::eUniformBufferDynamic, 1.0f},
+            {vk::DescriptorType::eStorageBuffer,        4.0f},
+            {vk::DescriptorType::eStorageBufferDynamic, 1.0f},
+            {vk::DescriptorType::eCombinedImageSampler, 4.0f},
+            {vk::DescriptorType::eSampledImage,         2.0f},
+            {vk::DescriptorType::eStorageImage,         1.0f},
+            {vk::DescriptorType::eSampler,              1.0f},
+        };
+
+        // Each new pool is half again as big as the last, up to this many sets
+        constexpr uint32_t kMaxSetsPerPool = 4096;
+
+        template<typename Handle>
+        uint64_t handleBits(Handle handle) {
+            return reinterpret_cast<uint64_t>(static_cast<typename Handle::CType>(handle));
+        }
+
+    } // namespace
+
+    DescriptorAllocator::DescriptorAllocator(vk::Device device, uint32_t framesInFlight, std::vector<DescriptorPoolRatio> ratios,
+                                             uint32_t initialSetsPerPool)
+        : m_device(device)
+        , m_ratios(ratios.empty() ? kDefaultRatios : std::move(ratios))
+        , m_initialSetsPerPool(std::max(initialSetsPerPool, 1u))
+        , m_frames(std::max(framesInFlight, 1u))
+    {
+        for (auto& frame : m_frames) {
+            frame.setsPerPool = m_initialSetsPerPool;
+        }
+        m_immutablePools.setsPerPool = m_initialSetsPerPool;
+    }
+
+    DescriptorAllocator::~DescriptorAllocator() {
+        for (auto& frame : m_frames) {
+            destroyPools(frame);
+        }
+        destroyPools(m_immutablePools);
+    }
+
+    void DescriptorAllocator::beginFrame(uint32_t frameSlot) {
+        std::lock_guard lock(m_mutex);
+        m_currentFrame = frameSlot % static_cast<uint32_t>(m_frames.size());
+        resetPools(m_frames[m_currentFrame]);
+    }
+
+    vk::DescriptorSet DescriptorAllocator::allocate(vk::DescriptorSetLayout layout) {
+        std::lock_guard lock(m_mutex);
+        return allocateFrom(m_frames[m_currentFrame], layout);
+    }
+
+    vk::DescriptorSet DescriptorAllocator::allocate(vk::DescriptorSetLayout layout, const std::vector<DescriptorWrite>& writes) {
+        vk::DescriptorSet set = allocate(layout);
+        write(set, writes);
+        return set;
+    }
+
+    vk::DescriptorSet DescriptorAllocator::getImmutable(vk::DescriptorSetLayout layout, const std::vector<DescriptorWrite>& writes) {
+        ShaderLoader::ContentHasher hasher;
+        hasher.updateValue(handleBits(layout));
+        for (const auto& write : writes) {
+            hasher.updateValue(write.binding)
+                  .updateValue(static_cast<uint32_t>(write.type))
+                  .updateValue(handleBits(write.bufferInfo.buffer))
+                  .updateValue(write.bufferInfo.offset)
+                  .updateValue(write.bufferInfo.range)
+                  .updateValue(handleBits(write.imageInfo.sampler))
+                  .updateValue(handleBits(write.imageInfo.imageView))
+                  .updateValue(static_cast<uint32_t>(write.imageInfo.imageLayout));
+        }
+        uint64_t key = hasher.digest();
+
+        std::lock_guard lock(m_mutex);
+        if (auto it = m_immutableSets.find(key); it != m_immutableSets.end()) {
+            ++m_immutableHits;
+            return it->second;
+        }
+        vk::DescriptorSet set = allocateFrom(m_immutablePools, layout);
+        write(set, writes);
+        m_immutableSets.emplace(key, set);
+        return set;
+    }
+
+    void DescriptorAllocator::resetImmutable() {
+        std::lock_guard lock(m_mutex);
+        resetPools(m_immutablePools);
+        m_immutableSets.clear();
+    }
+
+    size_t DescriptorAllocator::immutableCount() const {
+        std::lock_guard lock(m_mutex);
+        return m_immutableSets.size();
+    }
+
+    vk::DescriptorSet DescriptorAllocator::allocateFrom(PoolList& pools, vk::DescriptorSetLayout layout) {
+        auto tryAllocate = [&](vk::DescriptorPool pool) -> vk::DescriptorSet {
+            try {
+                return m_device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo(pool, layout)).front();
+            } catch (const vk::OutOfPoolMemoryError&) {
+            } catch (const vk::FragmentedPoolError&) {
+            }
+            return nullptr;
+        };
+
+        // Pools kept from earlier frames may be smaller than the current size, so each one that
+        // can't hold the set is retired until the next reset and the next in line is tried
+        while (!pools.ready.empty()) {
+            if (vk::DescriptorSet set = tryAllocate(pools.ready.back())) {
+                return set;
+            }
+            pools.full.push_back(pools.ready.back());
+            pools.ready.pop_back();
+            pools.setsPerPool = std::min(pools.setsPerPool + pools.setsPerPool / 2, kMaxSetsPerPool);
+        }
+
+        // Only an empty pool at the full size failing says the layout itself doesn't fit
+        if (vk::DescriptorSet set = tryAllocate(createPool(pools))) {
+            return set;
+        }
+        throw std::runtime_error("Descriptor set layout uses types missing from the allocator's pool ratios");
+    }
+
+    vk::DescriptorPool DescriptorAllocator::createPool(PoolList& pools) {
+        std::vector<vk::DescriptorPoolSize> sizes;
+        sizes.reserve(m_ratios.size());
+        for (const auto& ratio : m_ratios) {
+            sizes.emplace_back(ratio.type, std::max(1u, static_cast<uint32_t>(ratio.perSet * static_cast<float>(pools.setsPerPool))));
+        }
+        pools.ready.push_back(m_device.createDescriptorPool(vk::DescriptorPoolCreateInfo({}, pools.setsPerPool, sizes)));
+        return pools.ready.back();
+    }
+
+    void DescriptorAllocator::resetPools(PoolList& pools) {
+        for (auto pool : pools.ready) {
+            m_device.resetDescriptorPool(pool);
+        }
+        for (auto pool : pools.full) {
+            m_device.resetDescriptorPool(pool);
+            pools.ready.push_back(pool);
+        }
+        pools.full.clear();
+    }
+
+    void DescriptorAllocator::destroyPools(PoolList& pools) {
+        for (auto pool : pools.ready) {
+            m_device.destroyDescriptorPool(pool);
+        }
+        for (auto pool : pools.full) {
+            m_device.destroyDescriptorPool(pool);
+        }
+        pools.ready.clear();
+        pools.full.clear();
+    }
+
+    void DescriptorAllocator::write(vk::DescriptorSet set, const std::vector<DescriptorWrite>& writes) {
+        std::vector<vk::WriteDescriptorSet> descriptorWrites;
+        descriptorWrites.reserve(writes.size());
+        for (const auto& write : writes) {
+            vk::WriteDescriptorSet descriptorWrite(set, write.binding, 0, 1, write.type);
+            switch (write.type) {
+                case vk::DescriptorType::eSampler:
+                case vk::DescriptorType::eCombinedImageSampler:
+                case vk::DescriptorType::eSampledImage:
+                case vk::DescriptorType::eStorageImage:
+                case vk::DescriptorType::eInputAttachment:
+                    descriptorWrite.setPImageInfo(&write.imageInfo);
+                    break;
+                default:
+                    descriptorWrite.setPBufferInfo(&write.bufferInfo);
+                    break;
+            }
+            descriptorWrites.push_back(descriptorWrite);
+        }
+        m_device.updateDescriptorSets(descriptorWrites, nullptr);
+    }
+
+} // namespace Renderer
@@ -0,0 +1,198 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#include "../Public/DrawBatcher.h"
+#include "ContentHash.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Renderer {
+
+    namespace {
+
+        constexpr uint32_t kCommandStride = sizeof(vk::DrawIndexedIndirectCommand);
+
+    } // namespace
+
+    IndirectDrawFeatures queryIndirectDrawFeatures(vk::PhysicalDevice physicalDevice) {
+        auto chain = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+        const auto& features = chain.get<vk::PhysicalDeviceFeatures2>().features;
+
+        IndirectDrawFeatures result;
+        result.multiDrawIndirect = features.multiDrawIndirect;
+        result.drawIndirectFirstInstance = features.drawIndirectFirstInstance;
+        result.drawIndirectCount = chain.get<vk::PhysicalDeviceVulkan12Features>().drawIndirectCount;
+        return result;
+    }
+
+    size_t DrawBatcher::BatchKeyHash::operator()(const BatchKey& key) const {
+        return static_cast<size_t>(ShaderLoader::ContentHasher()
+            .updateValue(reinterpret_cast<uint64_t>(static_cast<VkPipeline>(key.pipeline)))
+            .updateValue(key.mesh.indexCount)
+            .updateValue(key.mesh.firstIndex)
+            .updateValue(key.mesh.vertexOffset)
+            .digest());
+    }
+
+    DrawBatcher::DrawBatcher(GpuAllocator& allocator, uint32_t framesInFlight, uint32_t instanceStride, uint32_t instanceBinding,
+                             const IndirectDrawFeatures& features)
+        : m_allocator(allocator)
+        , m_instanceStride(instanceStride)
+        , m_instanceBinding(instanceBinding)
+        , m_features(features)
+        , m_frames(std::max(framesInFlight, 1u))
+    {}
+
+    DrawBatcher::~DrawBatcher() {
+        for (auto& frame : m_frames) {
+            m_allocator.destroyBuffer(frame.instances.buffer);
+            m_allocator.destroyBuffer(frame.commands.buffer);
+            m_allocator.destroyBuffer(frame.counts.buffer);
+        }
+    }
+
+    void DrawBatcher::begin(uint32_t frameSlot) {
+        m_currentFrame = frameSlot % static_cast<uint32_t>(m_frames.size());
+
+        // Drop batches nothing drew from last frame, so a changing scene doesn't accumulate them
+        auto unused = std::remove_if(m_batches.begin(), m_batches.end(), [](const Batch& batch) { return batch.count == 0; });
+        if (unused != m_batches.end()) {
+            m_batches.erase(unused, m_batches.end());
+            m_batchIndex.clear();
+            for (uint32_t i = 0; i < m_batches.size(); ++i) {
+                m_batchIndex.emplace(m_batches[i].key, i);
+            }
+        }
+        for (auto& batch : m_batches) {
+            batch.instances.clear();
+            batch.count = 0;
+        }
+
+        m_commands.clear();
+        m_groups.clear();
+        m_instanceCount = 0;
+    }
+
+    void DrawBatcher::add(vk::Pipeline pipeline, const MeshRange& mesh, const void* instances, uint32_t count) {
+        BatchKey key{pipeline, mesh};
+        auto [it, inserted] = m_batchIndex.emplace(key, static_cast<uint32_t>(m_batches.size()));
+        if (inserted) {
+            m_batches.push_back({key, {}, 0});
+        }
+
+        Batch& batch = m_batches[it->second];
+        const auto* bytes = static_cast<const uint8_t*>(instances);
+        batch.instances.insert(batch.instances.end(), bytes, bytes + size_t{count} * m_instanceStride);
+        batch.count += count;
+    }
+
+    void DrawBatcher::end() {
+        // Group by pipeline so each is bound once; batch order breaks ties to keep frames stable
+        m_order.clear();
+        for (uint32_t i = 0; i < m_batches.size(); ++i) {
+            if (m_batches[i].count > 0) {
+                m_order.push_back(i);
+                m_instanceCount += m_batches[i].count;
+            }
+        }
+        if (m_order.empty()) {
+            return;
+        }
+        std::stable_sort(m_order.begin(), m_order.end(), [this](uint32_t a, uint32_t b) {
+            return static_cast<VkPipeline>(m_batches[a].key.pipeline) < static_cast<VkPipeline>(m_batches[b].key.pipeline);
+        });
+
+        FrameBuffers& frame = m_frames[m_currentFrame];
+        auto* instances = static_cast<uint8_t*>(reserve(frame.instances, vk::DeviceSize{m_instanceCount} * m_instanceStride,
+                                                        vk::BufferUsageFlagBits::eVertexBuffer));
+
+        uint32_t firstInstance = 0;
+        for (uint32_t index : m_order) {
+            const Batch& batch = m_batches[index];
+            memcpy(instances + size_t{firstInstance} * m_instanceStride, batch.instances.data(), batch.instances.size());
+
+            if (m_groups.empty() || m_groups.back().pipeline != batch.key.pipeline) {
+                m_groups.push_back({batch.key.pipeline, static_cast<uint32_t>(m_commands.size()), 0});
+            }
+            ++m_groups.back().commandCount;
+            m_commands.emplace_back(batch.key.mesh.indexCount, batch.count, batch.key.mesh.firstIndex,
+                                    batch.key.mesh.vertexOffset, firstInstance);
+            firstInstance += batch.count;
+        }
+
+        auto* commands = static_cast<vk::DrawIndexedIndirectCommand*>(
+            reserve(frame.commands, vk::DeviceSize{kCommandStride} * m_commands.size(), vk::BufferUsageFlagBits::eIndirectBuffer));
+        memcpy(commands, m_commands.data(), m_commands.size() * kCommandStride);
+        if (!m_features.drawIndirectFirstInstance) {
+            // The device requires zero; record() binds the instance buffer at each command's offset instead
+            for (size_t i = 0; i < m_commands.size(); ++i) {
+                commands[i].firstInstance = 0;
+            }
+        }
+
+        auto* counts = static_cast<uint32_t*>(
+            reserve(frame.counts, sizeof(uint32_t) * m_groups.size(), vk::BufferUsageFlagBits::eIndirectBuffer));
+        for (size_t i = 0; i < m_groups.size(); ++i) {
+            counts[i] = m_groups[i].commandCount;
+        }
+    }
+
+    void DrawBatcher::record(vk::CommandBuffer commandBuffer) const {
+        if (m_commands.empty()) {
+            return;
+        }
+        const FrameBuffers& frame = m_frames[m_currentFrame];
+        vk::Buffer instances = frame.instances.buffer.buffer;
+        vk::Buffer commands = frame.commands.buffer.buffer;
+
+        vk::DeviceSize instanceOffset = 0;
+        if (m_features.drawIndirectFirstInstance) {
+            commandBuffer.bindVertexBuffers(m_instanceBinding, instances, instanceOffset);
+        }
+
+        for (size_t g = 0; g < m_groups.size(); ++g) {
+            const PipelineGroup& group = m_groups[g];
+            commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, group.pipeline);
+            vk::DeviceSize commandOffset = vk::DeviceSize{group.firstCommand} * kCommandStride;
+
+            if (!m_features.drawIndirectFirstInstance) {
+                for (uint32_t i = 0; i < group.commandCount; ++i) {
+                    instanceOffset = vk::DeviceSize{m_commands[group.firstCommand + i].firstInstance} * m_instanceStride;
+                    commandBuffer.bindVertexBuffers(m_instanceBinding, instances, instanceOffset);
+                    commandBuffer.drawIndexedIndirect(commands, commandOffset + vk::DeviceSize{i} * kCommandStride, 1, kCommandStride);
+                }
+            } else if (m_features.drawIndirectCount) {
+                commandBuffer.drawIndexedIndirectCount(commands, commandOffset, frame.counts.buffer.buffer, g * sizeof(uint32_t),
+                                                       group.commandCount, kCommandStride);
+            } else if (m_features.multiDrawIndirect) {
+                commandBuffer.drawIndexedIndirect(commands, commandOffset, group.commandCount, kCommandStride);
+            } else {
+                for (uint32_t i = 0; i < group.commandCount; ++i) {
+                    commandBuffer.drawIndexedIndirect(commands, commandOffset + vk::DeviceSize{i} * kCommandStride, 1, kCommandStride);
+                }
+            }
+        }
+    }
+
+    uint32_t DrawBatcher::drawCallCount() const {
+        if (m_features.drawIndirectFirstInstance && (m_features.drawIndirectCount || m_features.multiDrawIndirect)) {
+            return static_cast<uint32_t>(m_groups.size());
+        }
+        return static_cast<uint32_t>(m_commands.size());
+    }
+
+    void* DrawBatcher::reserve(GrowableBuffer& buffer, vk::DeviceSize size, vk::BufferUsageFlags usage) {
+        if (buffer.capacity < size) {
+            // The slot's previous frame has completed (see begin()), so the old buffer is free to go
+            m_allocator.destroyBuffer(buffer.buffer);
+            buffer.capacity = std::max(size, buffer.capacity * 2);
+            // Device-local where the host can write it directly (resizable BAR, integrated GPUs)
+            buffer.buffer = m_allocator.createBuffer(buffer.capacity, usage,
+                                                     vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+                                                     vk::MemoryPropertyFlagBits::eDeviceLocal);
+        }
+        return buffer.buffer.allocation.mapped;
+    }
+
+} // namespace Renderer
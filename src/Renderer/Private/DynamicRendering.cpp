@@ -0,0 +1,93 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#include "../Public/DynamicRendering.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace Renderer {
+
+    namespace {
+
+        const vk::ImageSubresourceRange kColorRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+
+    } // namespace
+
+    bool supportsDynamicRendering(vk::PhysicalDevice physicalDevice) {
+        bool hasExtension = false;
+        for (const auto& extension : physicalDevice.enumerateDeviceExtensionProperties()) {
+            if (strcmp(extension.extensionName, vk::KHRDynamicRenderingExtensionName) == 0) {
+                hasExtension = true;
+                break;
+            }
+        }
+        if (!hasExtension) {
+            // Chaining the feature struct is only valid when the extension exists
+            return false;
+        }
+
+        auto chain = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceDynamicRenderingFeaturesKHR>();
+        return chain.get<vk::PhysicalDeviceDynamicRenderingFeaturesKHR>().dynamicRendering;
+    }
+
+    DynamicRendering::DynamicRendering(vk::Device device) {
+        m_beginRendering = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(device.getProcAddr("vkCmdBeginRenderingKHR"));
+        m_endRendering = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(device.getProcAddr("vkCmdEndRenderingKHR"));
+        if (!m_beginRendering || !m_endRendering) {
+            throw std::runtime_error("Device has no VK_KHR_dynamic_rendering commands");
+        }
+    }
+
+    void DynamicRendering::begin(vk::CommandBuffer commandBuffer, vk::Image image, vk::ImageView view, vk::Extent2D extent,
+                                 const vk::ClearValue& clearValue, vk::RenderingFlags flags) const {
+        // The ordering a render pass gets from an EXTERNAL -> 0 dependency at color output: the
+        // acquire semaphore is waited at that stage, so the transition only has to follow it
+        vk::ImageMemoryBarrier toAttachment(
+            {},
+            vk::AccessFlagBits::eColorAttachmentWrite,
+            vk::ImageLayout::eUndefined,
+            vk::ImageLayout::eColorAttachmentOptimal,
+            VK_QUEUE_FAMILY_IGNORED,
+            VK_QUEUE_FAMILY_IGNORED,
+            image,
+            kColorRange
+        );
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput,
+                                      vk::PipelineStageFlagBits::eColorAttachmentOutput,
+                                      {}, nullptr, nullptr, toAttachment);
+
+        vk::RenderingAttachmentInfo colorAttachment(
+            view,
+            vk::ImageLayout::eColorAttachmentOptimal,
+            vk::ResolveModeFlagBits::eNone,
+            nullptr,
+            vk::ImageLayout::eUndefined,
+            vk::AttachmentLoadOp::eClear,
+            vk::AttachmentStoreOp::eStore,
+            clearValue
+        );
+        vk::RenderingInfo renderingInfo(flags, { {0, 0}, extent }, 1, 0, colorAttachment);
+        m_beginRendering(commandBuffer, reinterpret_cast<const VkRenderingInfo*>(&renderingInfo));
+    }
+
+    void DynamicRendering::end(vk::CommandBuffer commandBuffer, vk::Image image) const {
+        m_endRendering(commandBuffer);
+
+        // Presentation waits on a semaphore, which covers visibility; only the layout has to change
+        vk::ImageMemoryBarrier toPresent(
+            vk::AccessFlagBits::eColorAttachmentWrite,
+            {},
+            vk::ImageLayout::eColorAttachmentOptimal,
+            vk::ImageLayout::ePresentSrcKHR,
+            VK_QUEUE_FAMILY_IGNORED,
+            VK_QUEUE_FAMILY_IGNORED,
+            image,
+            kColorRange
+        );
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput,
+                                      vk::PipelineStageFlagBits::eBottomOfPipe,
+                                      {}, nullptr, nullptr, toPresent);
+    }
+
+} // namespace Renderer
@@ -0,0 +1,72 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#include "../Public/FramePacer.h"
+#include <algorithm>
+
+namespace Renderer {
+
+    namespace {
+
+        constexpr double kSmoothing = 0.1;
+
+        double millisecondsBetween(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+            return std::chrono::duration<double, std::milli>(to - from).count();
+        }
+
+    } // namespace
+
+    FramePacer::FramePacer(vk::Device device, uint32_t framesInFlight)
+        : m_timeline(device)
+        , m_framesInFlight(std::clamp(framesInFlight, 1u, kMaxFramesInFlight))
+        , m_submitTimes(kMaxFramesInFlight)
+    {
+        m_stats.framesInFlight = m_framesInFlight;
+    }
+
+    uint32_t FramePacer::beginFrame() {
+        auto begin = Clock::now();
+        if (m_haveLastBegin) {
+            smooth(m_stats.cpuFrameMs, millisecondsBetween(m_lastBegin, begin));
+        }
+        m_lastBegin = begin;
+        m_haveLastBegin = true;
+
+        uint64_t next = m_submitted + 1;
+        if (next > m_framesInFlight) {
+            m_timeline.wait(next - m_framesInFlight);
+        }
+        smooth(m_stats.cpuWaitMs, millisecondsBetween(begin, Clock::now()));
+        observeCompleted();
+
+        return static_cast<uint32_t>(next % m_framesInFlight);
+    }
+
+    void FramePacer::endFrame() {
+        ++m_submitted;
+        m_timeline.next();
+        m_submitTimes[m_submitted % kMaxFramesInFlight] = Clock::now();
+        m_stats.frame = m_submitted;
+    }
+
+    void FramePacer::waitIdle() {
+        m_timeline.wait(m_submitted);
+        observeCompleted();
+    }
+
+    void FramePacer::observeCompleted() {
+        uint64_t completed = std::min(m_timeline.completed(), m_submitted);
+        if (completed <= m_observed) {
+            return;
+        }
+        // Only the newest completion carries a meaningful latency; older ones finished before we looked
+        smooth(m_stats.gpuLatencyMs, millisecondsBetween(m_submitTimes[completed % kMaxFramesInFlight], Clock::now()));
+        m_observed = completed;
+    }
+
+    void FramePacer::smooth(double& average, double sample) {
+        average = average == 0.0 ? sample : average + (sample - average) * kSmoothing;
+    }
+
+} // namespace Renderer
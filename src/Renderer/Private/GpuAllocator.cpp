@@ -0,0 +1,376 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#include "../Public/GpuAllocator.h"
+#include "../Public/Buffer.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace Renderer {
+
+    namespace {
+        constexpr vk::DeviceSize kMaxResourceAlignment = 64 * 1024;
+    } // namespace
+
+    GpuAllocator::GpuAllocator(vk::PhysicalDevice physicalDevice, vk::Device device, const GpuAllocatorConfig& config)
+        : m_physicalDevice(physicalDevice)
+        , m_device(device)
+        , m_config(config)
+        , m_memoryProperties(physicalDevice.getMemoryProperties())
+        , m_maxAllocationCount(physicalDevice.getProperties().limits.maxMemoryAllocationCount)
+    {}
+
+    GpuAllocator::~GpuAllocator() {
+        for (uint32_t i = 0; i < m_blocks.size(); ++i) {
+            if (m_blocks[i]) {
+                releaseBlock(i);
+            }
+        }
+    }
+
+    Allocation GpuAllocator::allocate(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags required,
+                                      vk::MemoryPropertyFlags preferred, ResourceKind kind) {
+        uint32_t memoryType = findMemoryType(m_memoryProperties, requirements.memoryTypeBits, required, preferred);
+        if (memoryType == UINT32_MAX) {
+            throw std::runtime_error("No memory type satisfies the allocation");
+        }
+
+        std::lock_guard lock(m_mutex);
+        Allocation allocation;
+
+        bool dedicated = requirements.size > m_config.blockSize / 2;
+        if (!dedicated) {
+            for (uint32_t i = 0; i < m_blocks.size(); ++i) {
+                const auto& block = m_blocks[i];
+                if (block && block->ranges && !block->evacuating && block->memoryType == memoryType && block->kind == kind &&
+                    allocateFromBlock(i, requirements, allocation)) {
+                    return allocation;
+                }
+            }
+        }
+
+        uint32_t blockIndex;
+        try {
+            blockIndex = createBlock(memoryType, kind, dedicated ? requirements.size : m_config.blockSize, dedicated);
+        } catch (const vk::OutOfDeviceMemoryError&) {
+            if (dedicated) {
+                throw;
+            }
+            // The heap can't fit another full block; a dedicated allocation may still fit
+            dedicated = true;
+            blockIndex = createBlock(memoryType, kind, requirements.size, dedicated);
+        }
+        if (dedicated) {
+            Block& block = *m_blocks[blockIndex];
+            allocation.memory = block.memory;
+            allocation.size = requirements.size;
+            allocation.mapped = block.mapped;
+            allocation.memoryType = memoryType;
+            allocation.block = blockIndex;
+            return allocation;
+        }
+        if (!allocateFromBlock(blockIndex, requirements, allocation)) {
+            throw std::runtime_error("Fresh memory block could not satisfy the allocation");
+        }
+        return allocation;
+    }
+
+    void GpuAllocator::free(Allocation& allocation) {
+        if (!allocation) {
+            return;
+        }
+        std::lock_guard lock(m_mutex);
+        freeLocked(allocation);
+    }
+
+    void GpuAllocator::freeLocked(Allocation& allocation) {
+        uint32_t blockIndex = allocation.block;
+        if (blockIndex < m_blocks.size() && m_blocks[blockIndex]) {
+            Block& block = *m_blocks[blockIndex];
+            if (!block.ranges) {
+                releaseBlock(blockIndex);
+            } else {
+                block.ranges->free(allocation.node);
+                if (block.ranges->empty() && !block.evacuating && isSpareEmptyBlock(blockIndex)) {
+                    releaseBlock(blockIndex);
+                }
+            }
+        }
+        allocation = {};
+    }
+
+    AllocatedBuffer GpuAllocator::createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage,
+                                               vk::MemoryPropertyFlags required, vk::MemoryPropertyFlags preferred,
+                                               const std::vector<uint32_t>& queueFamilies) {
+        vk::BufferCreateInfo createInfo({}, size, usage, vk::SharingMode::eExclusive);
+        if (queueFamilies.size() > 1) {
+            createInfo.setSharingMode(vk::SharingMode::eConcurrent).setQueueFamilyIndices(queueFamilies);
+        }
+
+        AllocatedBuffer result;
+        result.buffer = m_device.createBuffer(createInfo);
+        try {
+            result.allocation = allocate(m_device.getBufferMemoryRequirements(result.buffer), required, preferred);
+            m_device.bindBufferMemory(result.buffer, result.allocation.memory, result.allocation.offset);
+        } catch (...) {
+            destroyBuffer(result);
+            throw;
+        }
+        return result;
+    }
+
+    void GpuAllocator::destroyBuffer(AllocatedBuffer& buffer) {
+        if (buffer.buffer) {
+            m_device.destroyBuffer(buffer.buffer);
+        }
+        free(buffer.allocation);
+        buffer = {};
+    }
+
+    AllocatedImage GpuAllocator::createImage(const vk::ImageCreateInfo& createInfo, vk::MemoryPropertyFlags required) {
+        AllocatedImage result;
+        result.image = m_device.createImage(createInfo);
+        try {
+            ResourceKind kind = createInfo.tiling == vk::ImageTiling::eOptimal ? ResourceKind::Optimal : ResourceKind::Linear;
+            result.allocation = allocate(m_device.getImageMemoryRequirements(result.image), required, {}, kind);
+            m_device.bindImageMemory(result.image, result.allocation.memory, result.allocation.offset);
+        } catch (...) {
+            destroyImage(result);
+            throw;
+        }
+        return result;
+    }
+
+    void GpuAllocator::destroyImage(AllocatedImage& image) {
+        if (image.image) {
+            m_device.destroyImage(image.image);
+        }
+        free(image.allocation);
+        image = {};
+    }
+
+    std::vector<HeapBudget> GpuAllocator::budgets() const {
+        std::vector<HeapBudget> heaps(m_memoryProperties.memoryHeapCount);
+        for (uint32_t i = 0; i < heaps.size(); ++i) {
+            heaps[i].heapIndex = i;
+            heaps[i].heapSize = m_memoryProperties.memoryHeaps[i].size;
+        }
+
+        {
+            std::lock_guard lock(m_mutex);
+            for (const auto& block : m_blocks) {
+                if (!block) {
+                    continue;
+                }
+                HeapBudget& heap = heaps[m_memoryProperties.memoryTypes[block->memoryType].heapIndex];
+                heap.blockBytes += block->size;
+                ++heap.blockCount;
+                if (block->ranges) {
+                    heap.allocatedBytes += block->size - block->ranges->freeBytes();
+                    heap.allocationCount += block->ranges->allocationCount();
+                } else {
+                    heap.allocatedBytes += block->size;
+                    ++heap.allocationCount;
+                }
+            }
+        }
+
+        if (m_config.memoryBudgetExtension) {
+            auto chain = m_physicalDevice.getMemoryProperties2<vk::PhysicalDeviceMemoryProperties2,
+                                                               vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+            const auto& budget = chain.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+            for (auto& heap : heaps) {
+                heap.budget = budget.heapBudget[heap.heapIndex];
+                heap.usage = budget.heapUsage[heap.heapIndex];
+            }
+        } else {
+            // Without the extension the best guess is what we hold against most of the heap
+            for (auto& heap : heaps) {
+                heap.budget = heap.heapSize / 10 * 8;
+                heap.usage = heap.blockBytes;
+            }
+        }
+        return heaps;
+    }
+
+    std::vector<DefragmentationMove> GpuAllocator::beginDefragmentation(vk::DeviceSize maxBytes) {
+        std::lock_guard lock(m_mutex);
+        std::vector<DefragmentationMove> moves;
+
+        // Sparsest blocks first: they are the cheapest to empty
+        std::vector<uint32_t> candidates;
+        for (uint32_t i = 0; i < m_blocks.size(); ++i) {
+            if (m_blocks[i] && m_blocks[i]->ranges && !m_blocks[i]->ranges->empty()) {
+                candidates.push_back(i);
+            }
+        }
+        auto usedBytes = [&](uint32_t index) {
+            return m_blocks[index]->size - m_blocks[index]->ranges->freeBytes();
+        };
+        std::sort(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b) { return usedBytes(a) < usedBytes(b); });
+
+        // A block that receives ranges this pass is not emptied in it too: its moves would copy
+        // out of ranges the same batch is still copying into
+        std::vector<bool> receiving(m_blocks.size(), false);
+
+        vk::DeviceSize movedBytes = 0;
+        for (uint32_t source : candidates) {
+            Block& sourceBlock = *m_blocks[source];
+            if (sourceBlock.evacuating || receiving[source]) {
+                continue;
+            }
+
+            // Destinations: the fullest other blocks of the same pool, never one being emptied
+            std::vector<uint32_t> destinations;
+            for (auto it = candidates.rbegin(); it != candidates.rend(); ++it) {
+                const Block& block = *m_blocks[*it];
+                if (*it != source && !block.evacuating && block.memoryType == sourceBlock.memoryType && block.kind == sourceBlock.kind) {
+                    destinations.push_back(*it);
+                }
+            }
+            if (destinations.empty()) {
+                continue;
+            }
+
+            auto ranges = sourceBlock.ranges->allocations();
+            vk::DeviceSize blockBytes = 0;
+            for (const auto& range : ranges) {
+                blockBytes += range.size;
+            }
+            if (movedBytes + blockBytes > maxBytes) {
+                continue;
+            }
+
+            // Only commit to emptying the block if every range fits elsewhere
+            std::vector<DefragmentationMove> blockMoves;
+            bool fits = true;
+            for (const auto& range : ranges) {
+                // The original alignment isn't kept, but the offset was aligned to it: the largest power of two
+                // dividing the offset is always enough. Offset 0 says nothing, so assume the 64 KiB sparse page
+                vk::DeviceSize alignment = range.offset ? (range.offset & (~range.offset + 1)) : kMaxResourceAlignment;
+                vk::MemoryRequirements requirements(range.size, alignment, 1u << sourceBlock.memoryType);
+
+                DefragmentationMove move;
+                move.source.memory = sourceBlock.memory;
+                move.source.offset = range.offset;
+                move.source.size = range.size;
+                move.source.mapped = sourceBlock.mapped ? static_cast<uint8_t*>(sourceBlock.mapped) + range.offset : nullptr;
+                move.source.memoryType = sourceBlock.memoryType;
+                move.source.block = source;
+                move.source.node = range.node;
+
+                bool placed = false;
+                for (uint32_t destination : destinations) {
+                    if (allocateFromBlock(destination, requirements, move.destination)) {
+                        placed = true;
+                        break;
+                    }
+                }
+                if (!placed) {
+                    fits = false;
+                    break;
+                }
+                blockMoves.push_back(move);
+            }
+
+            if (!fits) {
+                for (auto& move : blockMoves) {
+                    freeLocked(move.destination);
+                }
+                continue;
+            }
+
+            sourceBlock.evacuating = true;
+            movedBytes += blockBytes;
+            for (const auto& move : blockMoves) {
+                receiving[move.destination.block] = true;
+            }
+            moves.insert(moves.end(), blockMoves.begin(), blockMoves.end());
+        }
+        return moves;
+    }
+
+    void GpuAllocator::endDefragmentation(const std::vector<DefragmentationMove>& moves) {
+        std::lock_guard lock(m_mutex);
+        for (auto move : moves) {
+            freeLocked(move.skip ? move.destination : move.source);
+        }
+        for (uint32_t i = 0; i < m_blocks.size(); ++i) {
+            if (m_blocks[i] && m_blocks[i]->evacuating) {
+                m_blocks[i]->evacuating = false;
+                if (m_blocks[i]->ranges->empty() && isSpareEmptyBlock(i)) {
+                    releaseBlock(i);
+                }
+            }
+        }
+    }
+
+    bool GpuAllocator::allocateFromBlock(uint32_t blockIndex, const vk::MemoryRequirements& requirements, Allocation& allocation) {
+        Block& block = *m_blocks[blockIndex];
+        TlsfAllocator::Range range;
+        if (!block.ranges->allocate(requirements.size, requirements.alignment, range)) {
+            return false;
+        }
+        allocation.memory = block.memory;
+        allocation.offset = range.offset;
+        allocation.size = range.size;
+        allocation.mapped = block.mapped ? static_cast<uint8_t*>(block.mapped) + range.offset : nullptr;
+        allocation.memoryType = block.memoryType;
+        allocation.block = blockIndex;
+        allocation.node = range.node;
+        return true;
+    }
+
+    uint32_t GpuAllocator::createBlock(uint32_t memoryType, ResourceKind kind, vk::DeviceSize size, bool dedicated) {
+        if (m_deviceAllocationCount >= m_maxAllocationCount) {
+            throw std::runtime_error("Device memory allocation count limit reached");
+        }
+
+        auto block = std::make_unique<Block>();
+        block->size = size;
+        block->memoryType = memoryType;
+        block->kind = kind;
+        block->memory = m_device.allocateMemory(vk::MemoryAllocateInfo(size, memoryType));
+        ++m_deviceAllocationCount;
+
+        if (m_memoryProperties.memoryTypes[memoryType].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible) {
+            block->mapped = m_device.mapMemory(block->memory, 0, VK_WHOLE_SIZE);
+        }
+        if (!dedicated) {
+            block->ranges = std::make_unique<TlsfAllocator>(size);
+        }
+
+        auto slot = std::find(m_blocks.begin(), m_blocks.end(), nullptr);
+        if (slot != m_blocks.end()) {
+            *slot = std::move(block);
+            return static_cast<uint32_t>(slot - m_blocks.begin());
+        }
+        m_blocks.push_back(std::move(block));
+        return static_cast<uint32_t>(m_blocks.size() - 1);
+    }
+
+    void GpuAllocator::releaseBlock(uint32_t blockIndex) {
+        Block& block = *m_blocks[blockIndex];
+        if (block.mapped) {
+            m_device.unmapMemory(block.memory);
+        }
+        m_device.freeMemory(block.memory);
+        --m_deviceAllocationCount;
+        m_blocks[blockIndex].reset();
+    }
+
+    bool GpuAllocator::isSpareEmptyBlock(uint32_t blockIndex) const {
+        // Keep one empty block per pool so an alloc/free pattern at the boundary doesn't thrash
+        const Block& block = *m_blocks[blockIndex];
+        for (uint32_t i = 0; i < m_blocks.size(); ++i) {
+            const auto& other = m_blocks[i];
+            if (i != blockIndex && other && other->ranges && other->ranges->empty() && !other->evacuating &&
+                other->memoryType == block.memoryType && other->kind == block.kind) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+} // namespace Renderer
@@ -0,0 +1,574 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#include "../Public/GraphicsPipelineLibrary.h"
+#include "../Public/PipelineManifest.h"
+#include "ContentHash.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace Renderer {
+
+    namespace {
+
+        bool hasExtension(const std::vector<vk::ExtensionProperties>& extensions, const char* name) {
+            for (const auto& extension : extensions) {
+                if (strcmp(extension.extensionName, name) == 0) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        uint64_t shaderKey(vk::ShaderModule module, uint64_t contentHash) {
+            return contentHash ? contentHash : reinterpret_cast<uint64_t>(static_cast<VkShaderModule>(module));
+        }
+
+        // Bindings and attributes in binding and location order, so descriptions that only list
+        // them differently share a key
+        void hashVertexInput(ShaderLoader::ContentHasher& hasher, const GraphicsPipelineDesc& desc) {
+            auto bindings = desc.bindings;
+            std::sort(bindings.begin(), bindings.end(), [](const auto& a, const auto& b) { return a.binding < b.binding; });
+            auto attributes = desc.attributes;
+            std::sort(attributes.begin(), attributes.end(), [](const auto& a, const auto& b) { return a.location < b.location; });
+
+            hasher.update(bindings.data(), bindings.size() * sizeof(bindings[0]));
+            hasher.update(attributes.data(), attributes.size() * sizeof(attributes[0]));
+            hasher.updateValue(desc.topology);
+        }
+
+        // hashPipelineState plus the handles it leaves out; only meaningful within one run
+        uint64_t runtimeKey(const GraphicsPipelineDesc& desc) {
+            return ShaderLoader::ContentHasher()
+                .updateValue(hashPipelineState(desc))
+                .updateValue(reinterpret_cast<uint64_t>(static_cast<VkPipelineLayout>(desc.layout)))
+                .updateValue(reinterpret_cast<uint64_t>(static_cast<VkRenderPass>(desc.renderPass)))
+                .digest();
+        }
+
+        const vk::DynamicState kDynamicStates[] = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
+
+        // Every state struct a description expands to, kept alive for the create call
+        struct PipelineState {
+            explicit PipelineState(const GraphicsPipelineDesc& desc)
+                : vertexInput({}, static_cast<uint32_t>(desc.bindings.size()), desc.bindings.data(),
+                              static_cast<uint32_t>(desc.attributes.size()), desc.attributes.data())
+                , inputAssembly({}, desc.topology, VK_FALSE)
+                , viewport({}, 1, nullptr, 1, nullptr)
+                , rasterization({}, VK_FALSE, VK_FALSE, desc.polygonMode, desc.cullMode, desc.frontFace,
+                                VK_FALSE, 0.0f, 0.0f, 0.0f, 1.0f)
+                , multisample({}, vk::SampleCountFlagBits::e1, VK_FALSE)
+                , dynamic({}, static_cast<uint32_t>(std::size(kDynamicStates)), kDynamicStates)
+                , rendering(0, static_cast<uint32_t>(desc.colorFormats.size()), desc.colorFormats.data())
+            {
+                stages[0] = vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eVertex, desc.vertexShader,
+                                                              desc.vertexEntryPoint.c_str());
+                stages[1] = vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eFragment, desc.fragmentShader,
+                                                              desc.fragmentEntryPoint.c_str());
+
+                size_t attachmentCount = desc.renderPass ? 1 : desc.colorFormats.size();
+                blendAttachments.assign(attachmentCount, vk::PipelineColorBlendAttachmentState(
+                    VK_FALSE,
+                    vk::BlendFactor::eOne, vk::BlendFactor::eZero, vk::BlendOp::eAdd,
+                    vk::BlendFactor::eOne, vk::BlendFactor::eZero, vk::BlendOp::eAdd,
+                    vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
+                    vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA));
+                colorBlend = vk::PipelineColorBlendStateCreateInfo({}, VK_FALSE, vk::LogicOp::eCopy,
+                                                                   static_cast<uint32_t>(blendAttachments.size()),
+                                                                   blendAttachments.data());
+            }
+
+            vk::PipelineShaderStageCreateInfo        stages[2];
+            vk::PipelineVertexInputStateCreateInfo   vertexInput;
+            vk::PipelineInputAssemblyStateCreateInfo inputAssembly;
+            vk::PipelineViewportStateCreateInfo      viewport;
+            vk::PipelineRasterizationStateCreateInfo rasterization;
+            vk::PipelineMultisampleStateCreateInfo   multisample;
+            vk::PipelineDynamicStateCreateInfo       dynamic;
+            std::vector<vk::PipelineColorBlendAttachmentState> blendAttachments;
+            vk::PipelineColorBlendStateCreateInfo    colorBlend;
+            vk::PipelineRenderingCreateInfo          rendering;
+        };
+
+        vk::Pipeline createPipeline(vk::Device device, vk::PipelineCache pipelineCache, const vk::GraphicsPipelineCreateInfo& info,
+                                    const char* what) {
+            auto result = device.createGraphicsPipeline(pipelineCache, info);
+            if (result.result != vk::Result::eSuccess) {
+                throw std::runtime_error(std::string("Failed to create ") + what);
+            }
+            return result.value;
+        }
+
+    } // namespace
+
+    uint64_t hashPipelineState(const GraphicsPipelineDesc& desc, bool usesRenderPass) {
+        ShaderLoader::ContentHasher hasher;
+        hashVertexInput(hasher, desc);
+        hasher.updateValue(desc.vertexShaderHash);
+        hasher.update(desc.vertexEntryPoint);
+        hasher.updateValue(desc.polygonMode);
+        hasher.updateValue(static_cast<uint32_t>(desc.cullMode));
+        hasher.updateValue(desc.frontFace);
+        hasher.updateValue(desc.fragmentShaderHash);
+        hasher.update(desc.fragmentEntryPoint);
+        hasher.updateValue(usesRenderPass);
+        hasher.updateValue(desc.subpass);
+        hasher.update(desc.colorFormats.data(), desc.colorFormats.size() * sizeof(desc.colorFormats[0]));
+        return hasher.digest();
+    }
+
+    bool supportsGraphicsPipelineLibrary(vk::PhysicalDevice physicalDevice) {
+        auto extensions = physicalDevice.enumerateDeviceExtensionProperties();
+        if (!hasExtension(extensions, vk::KHRPipelineLibraryExtensionName) ||
+            !hasExtension(extensions, vk::EXTGraphicsPipelineLibraryExtensionName)) {
+            return false;
+        }
+
+        auto chain = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceGraphicsPipelineLibraryFeaturesEXT>();
+        return chain.get<vk::PhysicalDeviceGraphicsPipelineLibraryFeaturesEXT>().graphicsPipelineLibrary;
+    }
+
+    GraphicsPipelineLibrary::GraphicsPipelineLibrary(vk::Device device, vk::PipelineCache pipelineCache, bool useLibraries)
+        : m_device(device)
+        , m_pipelineCache(pipelineCache)
+        , m_useLibraries(useLibraries)
+        , m_optimizer(1)
+    {}
+
+    GraphicsPipelineLibrary::~GraphicsPipelineLibrary() {
+        finishWarmUp();
+        m_optimizer.wait();
+
+        for (PipelineId id = 0; id < m_entryCount; ++id) {
+            Entry& entry = entryAt(id);
+            vk::Pipeline current = entry.current.load(std::memory_order_relaxed);
+            if (entry.optimized && entry.optimized != current) {
+                m_device.destroyPipeline(entry.optimized);
+            }
+            m_device.destroyPipeline(current);
+        }
+        for (auto& chunk : m_entryChunks) {
+            delete[] chunk.load(std::memory_order_relaxed);
+        }
+        for (auto& retired : m_retired) {
+            m_device.destroyPipeline(retired.pipeline);
+        }
+        for (auto& [key, pipeline] : m_prebuilt) {
+            m_device.destroyPipeline(pipeline);
+        }
+        // Linked pipelines don't reference their libraries once created
+        for (auto& [key, library] : m_libraries) {
+            m_device.destroyPipeline(library.pipeline);
+        }
+    }
+
+    GraphicsPipelineLibrary::PipelineId GraphicsPipelineLibrary::add(const GraphicsPipelineDesc& desc) {
+        uint64_t key = runtimeKey(desc);
+        if (auto shared = m_ids.find(key); shared && *shared != kNoPipeline) {
+            m_sharedHits.fetch_add(1, std::memory_order_relaxed);
+            return *shared;
+        }
+
+        PipelineId id;
+        {
+            std::lock_guard lock(m_mutex);
+            id = appendEntry();
+        }
+        LibraryKeys parts;
+        vk::Pipeline pipeline = build(id, desc, parts);
+        std::lock_guard lock(m_mutex);
+        entryAt(id).current.store(pipeline, std::memory_order_release);
+        entryAt(id).key = key;
+        entryAt(id).parts = parts;
+        // Another thread may have added the same state meanwhile; both ids stay valid
+        auto [stored, inserted] = m_ids.insert(key, id);
+        if (!inserted && stored == kNoPipeline) {
+            m_ids.assign(key, id);
+        }
+        return id;
+    }
+
+    GraphicsPipelineLibrary::PipelineId GraphicsPipelineLibrary::appendEntry() {
+        size_t chunk = m_entryCount / kEntryChunkSize;
+        if (chunk == kMaxEntryChunks) {
+            throw std::runtime_error("Too many graphics pipelines");
+        }
+        if (m_entryCount % kEntryChunkSize == 0) {
+            m_entryChunks[chunk].store(new Entry[kEntryChunkSize], std::memory_order_release);
+        }
+        return static_cast<PipelineId>(m_entryCount++);
+    }
+
+    void GraphicsPipelineLibrary::replace(PipelineId id, const GraphicsPipelineDesc& desc, uint64_t retireValue) {
+        uint64_t key = runtimeKey(desc);
+        LibraryKeys parts;
+        vk::Pipeline pipeline = build(id, desc, parts);
+
+        std::lock_guard lock(m_mutex);
+        Entry& entry = entryAt(id);
+        m_retired.push_back({entry.current.load(std::memory_order_relaxed), retireValue});
+        entry.current.store(pipeline, std::memory_order_release);
+        // The new parts were taken first, so a part both states share keeps its library
+        releaseLibraries(entry.parts, retireValue);
+        entry.parts = parts;
+
+        // The table never drops keys, so the old state is marked as no longer built by anyone
+        auto previous = m_ids.find(entry.key);
+        if (previous && *previous == id) {
+            m_ids.assign(entry.key, kNoPipeline);
+        }
+        entry.key = key;
+        m_ids.assign(key, id);
+    }
+
+    vk::Pipeline GraphicsPipelineLibrary::build(PipelineId id, const GraphicsPipelineDesc& desc, LibraryKeys& parts) {
+        parts = {};
+        if (vk::Pipeline prebuilt = takePrebuilt(desc)) {
+            // Already complete and optimized
+            restart(id, false);
+            return prebuilt;
+        }
+        if (!m_useLibraries) {
+            return buildComplete(desc);
+        }
+
+        std::array<vk::Pipeline, PartCount> libraries;
+        vk::Pipeline fast;
+        try {
+            for (int part = 0; part < PartCount; ++part) {
+                libraries[part] = getLibrary(static_cast<Part>(part), desc, parts[part]);
+            }
+            fast = link(libraries, desc.layout, false);
+        } catch (...) {
+            std::lock_guard lock(m_mutex);
+            releaseLibraries(parts, 0);
+            throw;
+        }
+        uint32_t version = restart(id, true);
+
+        // The background link takes its own use of the libraries, so a replace() meanwhile can't
+        // retire them from under it
+        {
+            std::lock_guard lock(m_mutex);
+            retainLibraries(parts);
+        }
+        vk::PipelineLayout layout = desc.layout;
+        m_optimizer.submit([this, id, version, libraries, parts, layout] {
+            vk::Pipeline optimized;
+            try {
+                optimized = link(libraries, layout, true);
+            } catch (const std::exception&) {
+                // Keep the fast-linked pipeline; it is correct, just not as quick
+            }
+            std::lock_guard lock(m_mutex);
+            // Nothing the device runs refers to a library, so one left unused can go at the next update()
+            releaseLibraries(parts, 0);
+            Entry& entry = entryAt(id);
+            if (entry.version != version) {
+                // replace() got there first; this build is for state nobody uses any more
+                if (optimized) {
+                    m_device.destroyPipeline(optimized);
+                }
+                return;
+            }
+            entry.optimized = optimized;
+            entry.pending = false;
+        });
+        return fast;
+    }
+
+    uint32_t GraphicsPipelineLibrary::restart(PipelineId id, bool optimizing) {
+        std::lock_guard lock(m_mutex);
+        Entry& entry = entryAt(id);
+        if (entry.optimized && entry.optimized != entry.current.load(std::memory_order_relaxed)) {
+            // Finished for the previous state but never swapped in, so nothing has bound it
+            m_device.destroyPipeline(entry.optimized);
+        }
+        entry.optimized = nullptr;
+        entry.pending = optimizing;
+        return ++entry.version;
+    }
+
+    vk::Pipeline GraphicsPipelineLibrary::takePrebuilt(const GraphicsPipelineDesc& desc) {
+        if (!desc.vertexShaderHash || !desc.fragmentShaderHash) {
+            return nullptr;
+        }
+        uint64_t key = runtimeKey(desc);
+
+        std::unique_lock lock(m_mutex);
+        auto warming = m_warming.find(key);
+        if (warming != m_warming.end()) {
+            if (!warming->second) {
+                // Not started yet: building it here is no slower, and the job will skip it
+                m_warming.erase(warming);
+                return nullptr;
+            }
+            m_warmed.wait(lock, [&] { return m_warming.find(key) == m_warming.end(); });
+        }
+
+        auto it = m_prebuilt.find(key);
+        if (it == m_prebuilt.end()) {
+            return nullptr;
+        }
+        vk::Pipeline pipeline = it->second;
+        m_prebuilt.erase(it);
+        ++m_prebuiltHits;
+        return pipeline;
+    }
+
+    void GraphicsPipelineLibrary::warmUp(const PipelineManifest& manifest,
+                                         const std::function<bool(GraphicsPipelineDesc& desc, const std::string& vertexPath,
+                                                                  const std::string& fragmentPath)>& resolve) {
+        for (const auto& entry : manifest.entries()) {
+            GraphicsPipelineDesc desc = entry.desc;
+            if (!resolve(desc, entry.vertexPath, entry.fragmentPath) ||
+                static_cast<bool>(desc.renderPass) != entry.usesRenderPass) {
+                continue;
+            }
+            uint64_t key = runtimeKey(desc);
+            if (auto built = m_ids.find(key); built && *built != kNoPipeline) {
+                continue;
+            }
+            {
+                std::lock_guard lock(m_mutex);
+                if (m_prebuilt.count(key) || !m_warming.emplace(key, false).second) {
+                    continue;
+                }
+            }
+
+            if (!m_warmUp) {
+                // Separate from the optimizer so warm-up never holds up an optimized link
+                m_warmUp = std::make_unique<ShaderLoader::WorkStealingPool>();
+            }
+            m_warmUp->submit([this, key, desc = std::move(desc)] {
+                {
+                    std::lock_guard lock(m_mutex);
+                    auto warming = m_warming.find(key);
+                    if (warming == m_warming.end()) {
+                        // add() got to it first
+                        return;
+                    }
+                    warming->second = true;
+                }
+
+                vk::Pipeline pipeline;
+                try {
+                    pipeline = buildComplete(desc);
+                } catch (const std::exception&) {
+                    // Warm-up is best effort; add() builds it as usual
+                }
+                {
+                    std::lock_guard lock(m_mutex);
+                    m_warming.erase(key);
+                    if (pipeline && !m_prebuilt.emplace(key, pipeline).second) {
+                        m_device.destroyPipeline(pipeline);
+                    }
+                }
+                m_warmed.notify_all();
+            });
+        }
+    }
+
+    void GraphicsPipelineLibrary::finishWarmUp() {
+        if (m_warmUp) {
+            m_warmUp->wait();
+        }
+    }
+
+    bool GraphicsPipelineLibrary::update(uint64_t retireValue, uint64_t completedValue) {
+        bool changed = false;
+        std::lock_guard lock(m_mutex);
+        for (PipelineId id = 0; id < m_entryCount; ++id) {
+            Entry& entry = entryAt(id);
+            vk::Pipeline current = entry.current.load(std::memory_order_relaxed);
+            if (entry.optimized && entry.optimized != current) {
+                m_retired.push_back({current, retireValue});
+                entry.current.store(entry.optimized, std::memory_order_release);
+                changed = true;
+            }
+        }
+
+        auto destroyed = std::remove_if(m_retired.begin(), m_retired.end(), [&](const Retired& retired) {
+            if (retired.retireValue > completedValue) {
+                return false;
+            }
+            m_device.destroyPipeline(retired.pipeline);
+            return true;
+        });
+        m_retired.erase(destroyed, m_retired.end());
+        return changed;
+    }
+
+    size_t GraphicsPipelineLibrary::pendingOptimizations() const {
+        std::lock_guard lock(m_mutex);
+        size_t pending = 0;
+        for (PipelineId id = 0; id < m_entryCount; ++id) {
+            pending += entryAt(id).pending ? 1 : 0;
+        }
+        return pending;
+    }
+
+    size_t GraphicsPipelineLibrary::libraryCount() const {
+        std::lock_guard lock(m_mutex);
+        return m_libraries.size();
+    }
+
+    void GraphicsPipelineLibrary::retainLibraries(const LibraryKeys& keys) {
+        for (uint64_t key : keys) {
+            if (key) {
+                m_libraries.at(key).users++;
+            }
+        }
+    }
+
+    void GraphicsPipelineLibrary::releaseLibraries(const LibraryKeys& keys, uint64_t retireValue) {
+        for (uint64_t key : keys) {
+            auto it = key ? m_libraries.find(key) : m_libraries.end();
+            if (it == m_libraries.end() || --it->second.users > 0) {
+                continue;
+            }
+            // Out of the cache now; a later add() with the same part compiles it again
+            m_retired.push_back({it->second.pipeline, retireValue});
+            m_libraries.erase(it);
+        }
+    }
+
+    vk::Pipeline GraphicsPipelineLibrary::getLibrary(Part part, const GraphicsPipelineDesc& desc, uint64_t& key) {
+        ShaderLoader::ContentHasher hasher;
+        hasher.updateValue(static_cast<uint32_t>(part));
+        switch (part) {
+            case VertexInput:
+                hashVertexInput(hasher, desc);
+                break;
+            case PreRasterization:
+                hasher.updateValue(shaderKey(desc.vertexShader, desc.vertexShaderHash));
+                hasher.update(desc.vertexEntryPoint);
+                hasher.updateValue(desc.polygonMode);
+                hasher.updateValue(static_cast<uint32_t>(desc.cullMode));
+                hasher.updateValue(desc.frontFace);
+                break;
+            case FragmentShader:
+                hasher.updateValue(shaderKey(desc.fragmentShader, desc.fragmentShaderHash));
+                hasher.update(desc.fragmentEntryPoint);
+                break;
+            default:
+                break;
+        }
+        if (part != VertexInput) {
+            // The shader parts and the output all see the layout and what they render into
+            hasher.updateValue(reinterpret_cast<uint64_t>(static_cast<VkPipelineLayout>(desc.layout)));
+            hasher.updateValue(reinterpret_cast<uint64_t>(static_cast<VkRenderPass>(desc.renderPass)));
+            hasher.updateValue(desc.subpass);
+            hasher.update(desc.colorFormats.data(), desc.colorFormats.size() * sizeof(desc.colorFormats[0]));
+        }
+        // key is only set once the use is taken, so a throw leaves nothing to release
+        uint64_t partKey = hasher.digest();
+
+        {
+            std::lock_guard lock(m_mutex);
+            auto it = m_libraries.find(partKey);
+            if (it != m_libraries.end()) {
+                it->second.users++;
+                key = partKey;
+                return it->second.pipeline;
+            }
+        }
+
+        static const vk::GraphicsPipelineLibraryFlagBitsEXT kPartFlags[PartCount] = {
+            vk::GraphicsPipelineLibraryFlagBitsEXT::eVertexInputInterface,
+            vk::GraphicsPipelineLibraryFlagBitsEXT::ePreRasterizationShaders,
+            vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentShader,
+            vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentOutputInterface
+        };
+
+        PipelineState state(desc);
+        vk::GraphicsPipelineLibraryCreateInfoEXT libraryInfo(kPartFlags[part]);
+        if (!desc.renderPass) {
+            libraryInfo.pNext = &state.rendering;
+        }
+
+        // Retained so the background link can optimize across parts
+        vk::GraphicsPipelineCreateInfo info;
+        info.pNext = &libraryInfo;
+        info.flags = vk::PipelineCreateFlagBits::eLibraryKHR | vk::PipelineCreateFlagBits::eRetainLinkTimeOptimizationInfoEXT;
+        switch (part) {
+            case VertexInput:
+                info.pVertexInputState = &state.vertexInput;
+                info.pInputAssemblyState = &state.inputAssembly;
+                break;
+            case PreRasterization:
+                info.stageCount = 1;
+                info.pStages = &state.stages[0];
+                info.pViewportState = &state.viewport;
+                info.pRasterizationState = &state.rasterization;
+                info.pDynamicState = &state.dynamic;
+                break;
+            case FragmentShader:
+                info.stageCount = 1;
+                info.pStages = &state.stages[1];
+                info.pMultisampleState = &state.multisample;
+                break;
+            case FragmentOutput:
+                info.pMultisampleState = &state.multisample;
+                info.pColorBlendState = &state.colorBlend;
+                break;
+            default:
+                break;
+        }
+        if (part != VertexInput) {
+            info.layout = desc.layout;
+            info.renderPass = desc.renderPass;
+            info.subpass = desc.subpass;
+        }
+
+        // Compiled outside the lock; if another thread built the same part meanwhile, keep its copy
+        vk::Pipeline library = createPipeline(m_device, m_pipelineCache, info, "graphics pipeline library");
+        std::lock_guard lock(m_mutex);
+        auto [it, inserted] = m_libraries.emplace(partKey, Library{library});
+        if (!inserted) {
+            m_device.destroyPipeline(library);
+        }
+        it->second.users++;
+        key = partKey;
+        return it->second.pipeline;
+    }
+
+    vk::Pipeline GraphicsPipelineLibrary::link(const std::array<vk::Pipeline, PartCount>& libraries, vk::PipelineLayout layout,
+                                               bool optimize) {
+        vk::PipelineLibraryCreateInfoKHR linkInfo(static_cast<uint32_t>(libraries.size()), libraries.data());
+
+        vk::GraphicsPipelineCreateInfo info;
+        info.pNext = &linkInfo;
+        info.flags = optimize ? vk::PipelineCreateFlagBits::eLinkTimeOptimizationEXT : vk::PipelineCreateFlags{};
+        info.layout = layout;
+        return createPipeline(m_device, m_pipelineCache, info, optimize ? "optimized pipeline" : "linked pipeline");
+    }
+
+    vk::Pipeline GraphicsPipelineLibrary::buildComplete(const GraphicsPipelineDesc& desc) {
+        PipelineState state(desc);
+        vk::GraphicsPipelineCreateInfo info(
+            {},
+            2,
+            state.stages,
+            &state.vertexInput,
+            &state.inputAssembly,
+            nullptr,
+            &state.viewport,
+            &state.rasterization,
+            &state.multisample,
+            nullptr,
+            &state.colorBlend,
+            &state.dynamic,
+            desc.layout,
+            desc.renderPass,
+            desc.subpass
+        );
+        if (!desc.renderPass) {
+            info.pNext = &state.rendering;
+        }
+        return createPipeline(m_device, m_pipelineCache, info, "graphics pipeline");
+    }
+
+} // namespace Renderer
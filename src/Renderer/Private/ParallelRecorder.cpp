@@ -0,0 +1,100 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#include "../Public/ParallelRecorder.h"
+#include <algorithm>
+
+namespace Renderer {
+
+    ParallelRecorder::ParallelRecorder(vk::Device device, uint32_t queueFamily, uint32_t framesInFlight, unsigned threadCount)
+        : m_device(device)
+        , m_workers(threadCount)
+        // The thread calling record() runs slices too
+        , m_contextCount(m_workers.threadCount() + 1)
+        , m_slots(std::max(framesInFlight, 1u))
+    {
+        vk::CommandPoolCreateInfo poolInfo(vk::CommandPoolCreateFlagBits::eTransient, queueFamily);
+        for (auto& slot : m_slots) {
+            slot.primary.pool = device.createCommandPool(poolInfo);
+            slot.contexts.resize(m_contextCount);
+            for (auto& context : slot.contexts) {
+                context.pool = device.createCommandPool(poolInfo);
+            }
+        }
+    }
+
+    ParallelRecorder::~ParallelRecorder() {
+        for (auto& slot : m_slots) {
+            m_device.destroyCommandPool(slot.primary.pool);
+            for (auto& context : slot.contexts) {
+                m_device.destroyCommandPool(context.pool);
+            }
+        }
+    }
+
+    void ParallelRecorder::beginFrame(uint32_t frameSlot) {
+        m_currentSlot = frameSlot % static_cast<uint32_t>(m_slots.size());
+        FrameSlot& slot = m_slots[m_currentSlot];
+
+        // One reset per pool returns every buffer in it to the initial state
+        m_device.resetCommandPool(slot.primary.pool);
+        slot.primary.used = 0;
+        for (auto& context : slot.contexts) {
+            m_device.resetCommandPool(context.pool);
+            context.used = 0;
+        }
+    }
+
+    vk::CommandBuffer ParallelRecorder::primary() {
+        return next(m_slots[m_currentSlot].primary, vk::CommandBufferLevel::ePrimary);
+    }
+
+    const std::vector<vk::CommandBuffer>& ParallelRecorder::record(const vk::CommandBufferInheritanceInfo& inheritance,
+                                                                   size_t drawCount, const RecordSlice& recordSlice,
+                                                                   size_t minDrawsPerSlice) {
+        m_recorded.clear();
+        if (drawCount == 0) {
+            return m_recorded;
+        }
+
+        size_t grain = std::max<size_t>(minDrawsPerSlice, 1);
+        size_t sliceCount = std::min<size_t>(m_contextCount, (drawCount + grain - 1) / grain);
+        size_t perSlice = (drawCount + sliceCount - 1) / sliceCount;
+        m_recorded.resize(sliceCount);
+
+        FrameSlot& slot = m_slots[m_currentSlot];
+        vk::CommandBufferBeginInfo beginInfo(
+            vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
+            &inheritance);
+
+        auto recordOne = [&](size_t slice) {
+            size_t begin = slice * perSlice;
+            size_t end = std::min(drawCount, begin + perSlice);
+            vk::CommandBuffer commandBuffer = next(slot.contexts[slice], vk::CommandBufferLevel::eSecondary);
+            commandBuffer.begin(beginInfo);
+            if (begin < end) {
+                recordSlice(commandBuffer, begin, end);
+            }
+            commandBuffer.end();
+            m_recorded[slice] = commandBuffer;
+        };
+
+        if (sliceCount == 1) {
+            // Not worth waking the workers
+            recordOne(0);
+        } else {
+            m_workers.parallelFor(sliceCount, recordOne);
+        }
+        return m_recorded;
+    }
+
+    vk::CommandBuffer ParallelRecorder::next(Context& context, vk::CommandBufferLevel level) {
+        if (context.used == context.buffers.size()) {
+            auto allocated = m_device.allocateCommandBuffers(vk::CommandBufferAllocateInfo(context.pool, level, 1));
+            context.buffers.push_back(allocated.front());
+        }
+        return context.buffers[context.used++];
+    }
+
+} // namespace Renderer
@@ -0,0 +1,51 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#include "../Public/PipelineCache.h"
+
+namespace Renderer {
+
+    PipelineCache::PipelineCache(vk::Device device, size_t initialCapacity)
+        : m_device(device)
+        , m_pipelines(initialCapacity)
+    {}
+
+    PipelineCache::~PipelineCache() {
+        clear();
+    }
+
+    vk::Pipeline PipelineCache::find(uint64_t key) const {
+        auto pipeline = m_pipelines.find(key);
+        if (!pipeline) {
+            return nullptr;
+        }
+        m_hits.fetch_add(1, std::memory_order_relaxed);
+        return *pipeline;
+    }
+
+    vk::Pipeline PipelineCache::getOrCreate(uint64_t key, const std::function<vk::Pipeline()>& create) {
+        if (vk::Pipeline pipeline = find(key)) {
+            return pipeline;
+        }
+
+        vk::Pipeline pipeline = create();
+        auto [stored, inserted] = m_pipelines.insert(key, pipeline);
+        if (!inserted) {
+            // Another thread won the race; keep its pipeline
+            m_device.destroyPipeline(pipeline);
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+            return stored;
+        }
+        m_misses.fetch_add(1, std::memory_order_relaxed);
+        return pipeline;
+    }
+
+    void PipelineCache::clear() {
+        m_pipelines.forEach([this](VkPipeline pipeline) {
+            m_device.destroyPipeline(pipeline);
+        });
+        m_pipelines.clear();
+    }
+
+} // namespace Renderer
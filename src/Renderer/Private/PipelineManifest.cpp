@@ -0,0 +1,206 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#include "../Public/PipelineManifest.h"
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace Renderer {
+
+    namespace {
+
+        std::string toHex(uint64_t value) {
+            std::ostringstream ss;
+            ss << std::hex << value;
+            return ss.str();
+        }
+
+        // The whole of text as a number; false on anything else, including overflow
+        template <typename T>
+        bool parseNumber(const std::string& text, T& value, int base = 10) {
+            const char* end = text.data() + text.size();
+            auto [ptr, ec] = std::from_chars(text.data(), end, value, base);
+            return ec == std::errc() && ptr == end && !text.empty();
+        }
+
+        bool writeAtomically(const std::string& path, const std::function<bool(std::ofstream&)>& write) {
+            auto tempPath = path + ".tmp";
+            {
+                std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+                if (!file || !write(file) || !file) {
+                    return false;
+                }
+            }
+            std::error_code ec;
+            fs::rename(tempPath, path, ec);
+            return !ec;
+        }
+
+    } // namespace
+
+    bool PipelineManifest::record(const GraphicsPipelineDesc& desc, const std::string& vertexPath, const std::string& fragmentPath) {
+        if (!desc.vertexShaderHash || !desc.fragmentShaderHash) {
+            return false;
+        }
+        if (!m_keys.insert(hashPipelineState(desc)).second) {
+            return false;
+        }
+
+        Entry entry;
+        entry.vertexPath = vertexPath;
+        entry.fragmentPath = fragmentPath;
+        entry.desc = desc;
+        entry.desc.vertexShader = nullptr;
+        entry.desc.fragmentShader = nullptr;
+        entry.desc.layout = nullptr;
+        entry.desc.renderPass = nullptr;
+        entry.usesRenderPass = static_cast<bool>(desc.renderPass);
+        m_entries.push_back(std::move(entry));
+        m_dirty = true;
+        return true;
+    }
+
+    // Tab-separated text, one record per line:
+    //   P <vertex path> <hash> <entry> <fragment path> <hash> <entry>
+    //     <topology> <polygon mode> <cull mode> <front face> <render pass 0/1> <subpass>
+    //   B <binding> <stride> <input rate>                 vertex binding of the preceding pipeline
+    //   A <location> <binding> <format> <offset>          vertex attribute of the preceding pipeline
+    //   C <format>                                        color attachment of the preceding pipeline
+    bool PipelineManifest::save(const std::string& path) {
+        bool saved = writeAtomically(path, [&](std::ofstream& file) {
+            for (const auto& entry : m_entries) {
+                const auto& desc = entry.desc;
+                file << "P\t" << entry.vertexPath << "\t" << toHex(desc.vertexShaderHash) << "\t" << desc.vertexEntryPoint
+                     << "\t" << entry.fragmentPath << "\t" << toHex(desc.fragmentShaderHash) << "\t" << desc.fragmentEntryPoint
+                     << "\t" << static_cast<uint32_t>(desc.topology) << "\t" << static_cast<uint32_t>(desc.polygonMode)
+                     << "\t" << static_cast<uint32_t>(desc.cullMode) << "\t" << static_cast<uint32_t>(desc.frontFace)
+                     << "\t" << (entry.usesRenderPass ? 1 : 0) << "\t" << desc.subpass << "\n";
+                for (const auto& binding : desc.bindings) {
+                    file << "B\t" << binding.binding << "\t" << binding.stride << "\t" << static_cast<uint32_t>(binding.inputRate) << "\n";
+                }
+                for (const auto& attribute : desc.attributes) {
+                    file << "A\t" << attribute.location << "\t" << attribute.binding << "\t"
+                         << static_cast<uint32_t>(attribute.format) << "\t" << attribute.offset << "\n";
+                }
+                for (auto format : desc.colorFormats) {
+                    file << "C\t" << static_cast<uint32_t>(format) << "\n";
+                }
+            }
+            return true;
+        });
+        if (saved) {
+            m_dirty = false;
+        }
+        return saved;
+    }
+
+    bool PipelineManifest::load(const std::string& path) {
+        std::ifstream file(path);
+        if (!file) {
+            return false;
+        }
+
+        m_entries.clear();
+        m_keys.clear();
+        m_dirty = false;
+
+        // Parsed aside, so a truncated or hand-edited file leaves the manifest empty
+        std::vector<Entry> entries;
+        std::string line;
+        while (std::getline(file, line)) {
+            std::vector<std::string> fields;
+            std::istringstream ss(line);
+            for (std::string field; std::getline(ss, field, '\t');) {
+                fields.push_back(field);
+            }
+            if (fields.empty()) {
+                continue;
+            }
+
+            bool valid = true;
+            auto number = [&](size_t index) {
+                uint32_t value = 0;
+                valid = parseNumber(fields[index], value) && valid;
+                return value;
+            };
+            if (fields[0] == "P" && fields.size() == 13) {
+                Entry entry;
+                entry.vertexPath = fields[1];
+                valid = parseNumber(fields[2], entry.desc.vertexShaderHash, 16);
+                entry.desc.vertexEntryPoint = fields[3];
+                entry.fragmentPath = fields[4];
+                valid = parseNumber(fields[5], entry.desc.fragmentShaderHash, 16) && valid;
+                entry.desc.fragmentEntryPoint = fields[6];
+                entry.desc.topology = static_cast<vk::PrimitiveTopology>(number(7));
+                entry.desc.polygonMode = static_cast<vk::PolygonMode>(number(8));
+                entry.desc.cullMode = static_cast<vk::CullModeFlags>(number(9));
+                entry.desc.frontFace = static_cast<vk::FrontFace>(number(10));
+                entry.usesRenderPass = number(11) != 0;
+                entry.desc.subpass = number(12);
+                entries.push_back(std::move(entry));
+            } else if (entries.empty()) {
+                valid = false;
+            } else if (fields[0] == "B" && fields.size() == 4) {
+                entries.back().desc.bindings.emplace_back(number(1), number(2), static_cast<vk::VertexInputRate>(number(3)));
+            } else if (fields[0] == "A" && fields.size() == 5) {
+                entries.back().desc.attributes.emplace_back(number(1), number(2), static_cast<vk::Format>(number(3)), number(4));
+            } else if (fields[0] == "C" && fields.size() == 2) {
+                entries.back().desc.colorFormats.push_back(static_cast<vk::Format>(number(1)));
+            } else {
+                valid = false;
+            }
+            if (!valid) {
+                return false;
+            }
+        }
+
+        // Keys are taken once every field of an entry is in
+        for (const auto& entry : entries) {
+            m_keys.insert(hashPipelineState(entry.desc, entry.usesRenderPass));
+        }
+        m_entries = std::move(entries);
+        return true;
+    }
+
+    vk::PipelineCache loadPipelineCache(vk::PhysicalDevice physicalDevice, vk::Device device, const std::string& path) {
+        std::vector<char> data;
+        std::ifstream file(path, std::ios::binary);
+        if (file) {
+            data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        // Drivers should reject foreign data themselves, but not all do; check the header first
+        auto properties = physicalDevice.getProperties();
+        VkPipelineCacheHeaderVersionOne header{};
+        if (data.size() >= sizeof(header)) {
+            memcpy(&header, data.data(), sizeof(header));
+        }
+        bool compatible = data.size() >= sizeof(header) &&
+            header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+            header.vendorID == properties.vendorID &&
+            header.deviceID == properties.deviceID &&
+            memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
+        if (!compatible) {
+            data.clear();
+        }
+
+        return device.createPipelineCache(vk::PipelineCacheCreateInfo({}, data.size(), data.empty() ? nullptr : data.data()));
+    }
+
+    bool savePipelineCache(vk::Device device, vk::PipelineCache pipelineCache, const std::string& path) {
+        auto data = device.getPipelineCacheData(pipelineCache);
+        return writeAtomically(path, [&](std::ofstream& file) {
+            file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+            return true;
+        });
+    }
+
+} // namespace Renderer
@@ -0,0 +1,91 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#include "../Public/QueueFamilies.h"
+#include <algorithm>
+
+namespace Renderer {
+
+    namespace {
+
+        // Storage for vk::DeviceQueueCreateInfo::pQueuePriorities; no family needs more than two queues here
+        const float kQueuePriorities[2] = {1.0f, 1.0f};
+
+    } // namespace
+
+    std::vector<uint32_t> QueueFamilies::uniqueFamilies() const {
+        std::vector<uint32_t> families;
+        for (uint32_t family : {graphics, compute, transfer}) {
+            if (family != UINT32_MAX && std::find(families.begin(), families.end(), family) == families.end()) {
+                families.push_back(family);
+            }
+        }
+        return families;
+    }
+
+    QueueFamilies selectQueueFamilies(vk::PhysicalDevice physicalDevice, vk::SurfaceKHR surface) {
+        auto properties = physicalDevice.getQueueFamilyProperties();
+        QueueFamilies families;
+
+        // The spec only promises that some graphics family also supports compute, so that one is
+        // preferred; any graphics family that can present will do otherwise
+        for (bool needCompute : {true, false}) {
+            for (uint32_t i = 0; i < properties.size() && families.graphics == UINT32_MAX; ++i) {
+                auto flags = properties[i].queueFlags;
+                if (!(flags & vk::QueueFlagBits::eGraphics) || (needCompute && !(flags & vk::QueueFlagBits::eCompute))) {
+                    continue;
+                }
+                if (surface && !physicalDevice.getSurfaceSupportKHR(i, surface)) {
+                    continue;
+                }
+                families.graphics = i;
+            }
+        }
+
+        for (uint32_t i = 0; i < properties.size(); ++i) {
+            auto flags = properties[i].queueFlags;
+            if ((flags & vk::QueueFlagBits::eCompute) && !(flags & vk::QueueFlagBits::eGraphics) && families.compute == UINT32_MAX) {
+                families.compute = i;
+            }
+            if ((flags & vk::QueueFlagBits::eTransfer) && !(flags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute)) &&
+                families.transfer == UINT32_MAX) {
+                families.transfer = i;
+            }
+        }
+
+        if (families.graphics == UINT32_MAX) {
+            return families;
+        }
+        if (families.compute == UINT32_MAX && (properties[families.graphics].queueFlags & vk::QueueFlagBits::eCompute)) {
+            // A second queue in the graphics family can still overlap on some hardware
+            families.compute = families.graphics;
+            families.computeQueueIndex = properties[families.graphics].queueCount > 1 ? 1 : 0;
+        }
+        for (uint32_t i = 0; i < properties.size() && families.compute == UINT32_MAX; ++i) {
+            // The graphics family can't compute: any family that can, even one that can't present
+            if (properties[i].queueFlags & vk::QueueFlagBits::eCompute) {
+                families.compute = i;
+            }
+        }
+        if (families.transfer == UINT32_MAX) {
+            // Graphics and compute queues implicitly support transfers
+            families.transfer = families.compute != UINT32_MAX && families.compute != families.graphics
+                ? families.compute : families.graphics;
+        }
+        return families;
+    }
+
+    std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos(const QueueFamilies& families) {
+        std::vector<vk::DeviceQueueCreateInfo> createInfos;
+        for (uint32_t family : families.uniqueFamilies()) {
+            uint32_t count = 1;
+            if (family == families.compute) {
+                count = std::max(count, families.computeQueueIndex + 1);
+            }
+            createInfos.emplace_back(vk::DeviceQueueCreateFlags{}, family, count, kQueuePriorities);
+        }
+        return createInfos;
+    }
+
+} // namespace Renderer
@@ -0,0 +1,82 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#include "../Public/ShaderModuleCache.h"
+#include "ContentHash.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace Renderer {
+
+    namespace {
+
+        uint64_t contentHash(const ShaderLoader::ShaderModule& module) {
+            return module.hash ? module.hash : ShaderLoader::hashSpirv(module.spirv);
+        }
+
+    } // namespace
+
+    ShaderModuleCache::ShaderModuleCache(vk::Device device, const ShaderLoader::ShaderLoader& loader)
+        : m_device(device)
+        , m_loader(loader)
+    {}
+
+    ShaderModuleCache::~ShaderModuleCache() {
+        for (auto& [hash, module] : m_modules) {
+            m_device.destroyShaderModule(module);
+        }
+    }
+
+    vk::ShaderModule ShaderModuleCache::get(const std::string& path) {
+        const ShaderLoader::ShaderModule* loaded = m_loader.getModule(path);
+        if (!loaded) {
+            throw std::runtime_error("Shader not loaded: " + path);
+        }
+        uint64_t hash = contentHash(*loaded);
+
+        std::lock_guard lock(m_mutex);
+        m_paths[path] = hash;
+        auto it = m_modules.find(hash);
+        if (it != m_modules.end()) {
+            ++m_hits;
+            return it->second;
+        }
+
+        vk::ShaderModule module = m_device.createShaderModule(
+            vk::ShaderModuleCreateInfo({}, loaded->spirv.size() * sizeof(uint32_t), loaded->spirv.data()));
+        m_modules.emplace(hash, module);
+        ++m_creations;
+        return module;
+    }
+
+    void ShaderModuleCache::invalidate(const std::vector<std::string>& paths) {
+        std::lock_guard lock(m_mutex);
+        for (const auto& path : paths) {
+            auto it = m_paths.find(path);
+            if (it == m_paths.end()) {
+                continue;
+            }
+            uint64_t hash = it->second;
+            const ShaderLoader::ShaderModule* loaded = m_loader.getModule(path);
+            if (loaded && contentHash(*loaded) == hash) {
+                // Rewritten with the same bytes
+                continue;
+            }
+            m_paths.erase(it);
+
+            bool shared = std::any_of(m_paths.begin(), m_paths.end(), [&](const auto& entry) { return entry.second == hash; });
+            auto module = m_modules.find(hash);
+            if (!shared && module != m_modules.end()) {
+                m_device.destroyShaderModule(module->second);
+                m_modules.erase(module);
+            }
+        }
+    }
+
+    size_t ShaderModuleCache::size() const {
+        std::lock_guard lock(m_mutex);
+        return m_modules.size();
+    }
+
+} // namespace Renderer
@@ -0,0 +1,211 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#include "../Public/ShaderObjects.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace Renderer {
+
+    // Loaded from the device; the loader only exports core entry points
+    struct ShaderObjects::Commands {
+        PFN_vkCreateShadersEXT                  createShaders;
+        PFN_vkDestroyShaderEXT                  destroyShader;
+        PFN_vkCmdBindShadersEXT                 bindShaders;
+        PFN_vkCmdSetVertexInputEXT              setVertexInput;
+        PFN_vkCmdSetPrimitiveTopologyEXT        setPrimitiveTopology;
+        PFN_vkCmdSetPrimitiveRestartEnableEXT   setPrimitiveRestartEnable;
+        PFN_vkCmdSetViewportWithCountEXT        setViewportWithCount;
+        PFN_vkCmdSetScissorWithCountEXT         setScissorWithCount;
+        PFN_vkCmdSetRasterizerDiscardEnableEXT  setRasterizerDiscardEnable;
+        PFN_vkCmdSetPolygonModeEXT              setPolygonMode;
+        PFN_vkCmdSetRasterizationSamplesEXT     setRasterizationSamples;
+        PFN_vkCmdSetSampleMaskEXT               setSampleMask;
+        PFN_vkCmdSetAlphaToCoverageEnableEXT    setAlphaToCoverageEnable;
+        PFN_vkCmdSetCullModeEXT                 setCullMode;
+        PFN_vkCmdSetFrontFaceEXT                setFrontFace;
+        PFN_vkCmdSetDepthTestEnableEXT          setDepthTestEnable;
+        PFN_vkCmdSetDepthWriteEnableEXT         setDepthWriteEnable;
+        PFN_vkCmdSetDepthBiasEnableEXT          setDepthBiasEnable;
+        PFN_vkCmdSetStencilTestEnableEXT        setStencilTestEnable;
+        PFN_vkCmdSetColorBlendEnableEXT         setColorBlendEnable;
+        PFN_vkCmdSetColorWriteMaskEXT           setColorWriteMask;
+    };
+
+    namespace {
+
+        template<typename Function>
+        void loadCommand(vk::Device device, Function& function, const char* name) {
+            function = reinterpret_cast<Function>(device.getProcAddr(name));
+            if (!function) {
+                throw std::runtime_error(std::string("Device has no ") + name);
+            }
+        }
+
+    } // namespace
+
+    bool supportsShaderObject(vk::PhysicalDevice physicalDevice) {
+        bool hasExtension = false;
+        for (const auto& extension : physicalDevice.enumerateDeviceExtensionProperties()) {
+            if (strcmp(extension.extensionName, vk::EXTShaderObjectExtensionName) == 0) {
+                hasExtension = true;
+                break;
+            }
+        }
+        if (!hasExtension) {
+            return false;
+        }
+
+        auto chain = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceShaderObjectFeaturesEXT>();
+        return chain.get<vk::PhysicalDeviceShaderObjectFeaturesEXT>().shaderObject;
+    }
+
+    ShaderObjects::ShaderObjects(vk::Device device, std::vector<vk::DescriptorSetLayout> setLayouts,
+                                 std::vector<vk::PushConstantRange> pushConstantRanges)
+        : m_device(device)
+        , m_commands(std::make_unique<Commands>())
+        , m_setLayouts(std::move(setLayouts))
+        , m_pushConstantRanges(std::move(pushConstantRanges))
+    {
+        Commands& c = *m_commands;
+        loadCommand(device, c.createShaders, "vkCreateShadersEXT");
+        loadCommand(device, c.destroyShader, "vkDestroyShaderEXT");
+        loadCommand(device, c.bindShaders, "vkCmdBindShadersEXT");
+        loadCommand(device, c.setVertexInput, "vkCmdSetVertexInputEXT");
+        loadCommand(device, c.setPrimitiveTopology, "vkCmdSetPrimitiveTopologyEXT");
+        loadCommand(device, c.setPrimitiveRestartEnable, "vkCmdSetPrimitiveRestartEnableEXT");
+        loadCommand(device, c.setViewportWithCount, "vkCmdSetViewportWithCountEXT");
+        loadCommand(device, c.setScissorWithCount, "vkCmdSetScissorWithCountEXT");
+        loadCommand(device, c.setRasterizerDiscardEnable, "vkCmdSetRasterizerDiscardEnableEXT");
+        loadCommand(device, c.setPolygonMode, "vkCmdSetPolygonModeEXT");
+        loadCommand(device, c.setRasterizationSamples, "vkCmdSetRasterizationSamplesEXT");
+        loadCommand(device, c.setSampleMask, "vkCmdSetSampleMaskEXT");
+        loadCommand(device, c.setAlphaToCoverageEnable, "vkCmdSetAlphaToCoverageEnableEXT");
+        loadCommand(device, c.setCullMode, "vkCmdSetCullModeEXT");
+        loadCommand(device, c.setFrontFace, "vkCmdSetFrontFaceEXT");
+        loadCommand(device, c.setDepthTestEnable, "vkCmdSetDepthTestEnableEXT");
+        loadCommand(device, c.setDepthWriteEnable, "vkCmdSetDepthWriteEnableEXT");
+        loadCommand(device, c.setDepthBiasEnable, "vkCmdSetDepthBiasEnableEXT");
+        loadCommand(device, c.setStencilTestEnable, "vkCmdSetStencilTestEnableEXT");
+        loadCommand(device, c.setColorBlendEnable, "vkCmdSetColorBlendEnableEXT");
+        loadCommand(device, c.setColorWriteMask, "vkCmdSetColorWriteMaskEXT");
+    }
+
+    ShaderObjects::~ShaderObjects() {
+        VkDevice device = m_device;
+        for (auto& retired : m_retired) {
+            m_commands->destroyShader(device, retired.shader, nullptr);
+        }
+        if (m_vertex) {
+            m_commands->destroyShader(device, m_vertex, nullptr);
+        }
+        if (m_fragment) {
+            m_commands->destroyShader(device, m_fragment, nullptr);
+        }
+    }
+
+    void ShaderObjects::setStage(vk::ShaderStageFlagBits stage, const ShaderLoader::ShaderModule& module, uint64_t retireValue,
+                                 const std::string& entryPoint) {
+        if (stage != vk::ShaderStageFlagBits::eVertex && stage != vk::ShaderStageFlagBits::eFragment) {
+            throw std::runtime_error("Shader objects only cover the vertex and fragment stages here");
+        }
+
+        // Unlinked, so either stage can be swapped on its own; the vertex stage names what follows it
+        vk::ShaderCreateInfoEXT createInfo(
+            {},
+            stage,
+            stage == vk::ShaderStageFlagBits::eVertex ? vk::ShaderStageFlagBits::eFragment : vk::ShaderStageFlags{},
+            vk::ShaderCodeTypeEXT::eSpirv,
+            module.spirv.size() * sizeof(uint32_t),
+            module.spirv.data(),
+            entryPoint.c_str(),
+            static_cast<uint32_t>(m_setLayouts.size()),
+            m_setLayouts.data(),
+            static_cast<uint32_t>(m_pushConstantRanges.size()),
+            m_pushConstantRanges.data()
+        );
+
+        VkShaderEXT shader = VK_NULL_HANDLE;
+        VkResult result = m_commands->createShaders(m_device, 1, reinterpret_cast<const VkShaderCreateInfoEXT*>(&createInfo),
+                                                    nullptr, &shader);
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create shader object");
+        }
+
+        VkShaderEXT& current = stage == vk::ShaderStageFlagBits::eVertex ? m_vertex : m_fragment;
+        if (current) {
+            m_retired.push_back({current, retireValue});
+        }
+        current = shader;
+        ++m_generation;
+    }
+
+    void ShaderObjects::collect(uint64_t completedValue) {
+        auto destroyed = std::remove_if(m_retired.begin(), m_retired.end(), [&](const Retired& retired) {
+            if (retired.retireValue > completedValue) {
+                return false;
+            }
+            m_commands->destroyShader(m_device, retired.shader, nullptr);
+            return true;
+        });
+        m_retired.erase(destroyed, m_retired.end());
+    }
+
+    void ShaderObjects::bind(vk::CommandBuffer commandBuffer) const {
+        const VkShaderStageFlagBits stages[] = { VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT };
+        const VkShaderEXT shaders[] = { m_vertex, m_fragment };
+        m_commands->bindShaders(commandBuffer, 2, stages, shaders);
+    }
+
+    void ShaderObjects::setState(vk::CommandBuffer commandBuffer, const GraphicsPipelineDesc& desc, vk::Extent2D extent) const {
+        const Commands& c = *m_commands;
+        VkCommandBuffer cb = commandBuffer;
+
+        std::vector<VkVertexInputBindingDescription2EXT> bindings;
+        bindings.reserve(desc.bindings.size());
+        for (const auto& binding : desc.bindings) {
+            bindings.push_back({VK_STRUCTURE_TYPE_VERTEX_INPUT_BINDING_DESCRIPTION_2_EXT, nullptr, binding.binding, binding.stride,
+                                static_cast<VkVertexInputRate>(binding.inputRate), 1});
+        }
+        std::vector<VkVertexInputAttributeDescription2EXT> attributes;
+        attributes.reserve(desc.attributes.size());
+        for (const auto& attribute : desc.attributes) {
+            attributes.push_back({VK_STRUCTURE_TYPE_VERTEX_INPUT_ATTRIBUTE_DESCRIPTION_2_EXT, nullptr, attribute.location,
+                                  attribute.binding, static_cast<VkFormat>(attribute.format), attribute.offset});
+        }
+        c.setVertexInput(cb, static_cast<uint32_t>(bindings.size()), bindings.data(),
+                         static_cast<uint32_t>(attributes.size()), attributes.data());
+        c.setPrimitiveTopology(cb, static_cast<VkPrimitiveTopology>(desc.topology));
+        c.setPrimitiveRestartEnable(cb, VK_FALSE);
+
+        VkViewport viewport{0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f};
+        VkRect2D scissor{{0, 0}, extent};
+        c.setViewportWithCount(cb, 1, &viewport);
+        c.setScissorWithCount(cb, 1, &scissor);
+
+        c.setRasterizerDiscardEnable(cb, VK_FALSE);
+        c.setPolygonMode(cb, static_cast<VkPolygonMode>(desc.polygonMode));
+        c.setCullMode(cb, static_cast<VkCullModeFlags>(desc.cullMode));
+        c.setFrontFace(cb, static_cast<VkFrontFace>(desc.frontFace));
+        c.setDepthBiasEnable(cb, VK_FALSE);
+
+        const VkSampleMask sampleMask = ~0u;
+        c.setRasterizationSamples(cb, VK_SAMPLE_COUNT_1_BIT);
+        c.setSampleMask(cb, VK_SAMPLE_COUNT_1_BIT, &sampleMask);
+        c.setAlphaToCoverageEnable(cb, VK_FALSE);
+
+        c.setDepthTestEnable(cb, VK_FALSE);
+        c.setDepthWriteEnable(cb, VK_FALSE);
+        c.setStencilTestEnable(cb, VK_FALSE);
+
+        uint32_t attachmentCount = std::max<uint32_t>(1, static_cast<uint32_t>(desc.colorFormats.size()));
+        std::vector<VkBool32> blendEnables(attachmentCount, VK_FALSE);
+        std::vector<VkColorComponentFlags> writeMasks(attachmentCount,
+            VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT);
+        c.setColorBlendEnable(cb, 0, attachmentCount, blendEnables.data());
+        c.setColorWriteMask(cb, 0, attachmentCount, writeMasks.data());
+    }
+
+} // namespace Renderer
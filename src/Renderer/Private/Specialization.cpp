@@ -0,0 +1,124 @@
+//
+// Created by charlie on 8/7/25.
+//
+
+#include "../Public/Specialization.h"
+#include "ContentHash.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace Renderer {
+
+    SpecializationConstants& SpecializationConstants::setRaw(uint32_t specId, const void* value, size_t size) {
+        auto it = std::lower_bound(m_entries.begin(), m_entries.end(), specId,
+                                   [](const vk::SpecializationMapEntry& entry, uint32_t id) { return entry.constantID < id; });
+
+        if (it != m_entries.end() && it->constantID == specId) {
+            if (it->size == size) {
+                memcpy(m_data.data() + it->offset, value, size);
+                rehash();
+                return *this;
+            }
+            // Type changed width; drop the old bytes and re-insert below
+            size_t oldOffset = it->offset;
+            size_t oldSize = it->size;
+            m_data.erase(m_data.begin() + static_cast<ptrdiff_t>(oldOffset),
+                         m_data.begin() + static_cast<ptrdiff_t>(oldOffset + oldSize));
+            it = m_entries.erase(it);
+            for (auto& entry : m_entries) {
+                if (entry.offset > oldOffset) {
+                    entry.offset -= static_cast<uint32_t>(oldSize);
+                }
+            }
+        }
+
+        // Data is packed in spec id order so the byte image is canonical too
+        uint32_t offset = it == m_entries.end() ? static_cast<uint32_t>(m_data.size()) : it->offset;
+        m_data.insert(m_data.begin() + offset, static_cast<const uint8_t*>(value), static_cast<const uint8_t*>(value) + size);
+        for (auto next = it; next != m_entries.end(); ++next) {
+            next->offset += static_cast<uint32_t>(size);
+        }
+        m_entries.insert(it, vk::SpecializationMapEntry(specId, offset, size));
+        rehash();
+        return *this;
+    }
+
+    void SpecializationConstants::rehash() {
+        ShaderLoader::ContentHasher hasher;
+        for (const auto& entry : m_entries) {
+            hasher.updateValue(entry.constantID);
+            hasher.updateValue(static_cast<uint32_t>(entry.size));
+        }
+        hasher.update(m_data.data(), m_data.size());
+        m_hash = hasher.digest();
+    }
+
+    bool SpecializationConstants::get(uint32_t specId, uint32_t& value) const {
+        for (const auto& entry : m_entries) {
+            if (entry.constantID == specId && entry.size == sizeof(value)) {
+                memcpy(&value, m_data.data() + entry.offset, sizeof(value));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool SpecializationConstants::validate(const ShaderLoader::ShaderReflection& reflection, std::string& error) const {
+        for (const auto& entry : m_entries) {
+            auto constant = reflection.findSpecConstant(entry.constantID);
+            if (!constant) {
+                error = "Shader has no specialization constant with id " + std::to_string(entry.constantID);
+                return false;
+            }
+            size_t expected = constant->type == ShaderLoader::SpecConstantType::Bool ? sizeof(VkBool32) : constant->bitWidth / 8;
+            if (entry.size != expected) {
+                error = "Specialization constant " + std::to_string(entry.constantID) +
+                    (constant->name.empty() ? "" : " (" + constant->name + ")") +
+                    " expects " + std::to_string(expected) + " bytes, got " + std::to_string(entry.size);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    SpecializedPipelineCache::SpecializedPipelineCache(vk::Device device, vk::PipelineCache pipelineCache)
+        : m_device(device)
+        , m_pipelineCache(pipelineCache)
+        , m_pipelines(device)
+    {}
+
+    vk::Pipeline SpecializedPipelineCache::getComputePipeline(const ShaderLoader::ShaderModule& module, vk::PipelineLayout layout,
+                                                              const SpecializationConstants& constants,
+                                                              const std::string& entryPoint) {
+        uint64_t moduleHash = module.hash ? module.hash : ShaderLoader::hashSpirv(module.spirv);
+        uint64_t key = ShaderLoader::ContentHasher()
+            .updateValue(moduleHash)
+            .updateValue(reinterpret_cast<uint64_t>(static_cast<VkPipelineLayout>(layout)))
+            .updateValue(constants.hash())
+            .update(entryPoint)
+            .digest();
+
+        return getOrCreate(key, [&] {
+            vk::ShaderModuleCreateInfo createInfo({}, module.spirv.size() * sizeof(uint32_t), module.spirv.data());
+            auto shaderModule = m_device.createShaderModule(createInfo);
+
+            auto specializationInfo = constants.info();
+            vk::PipelineShaderStageCreateInfo stage({}, vk::ShaderStageFlagBits::eCompute, shaderModule, entryPoint.c_str(),
+                                                    constants.empty() ? nullptr : &specializationInfo);
+            vk::ComputePipelineCreateInfo pipelineInfo({}, stage, layout);
+
+            auto result = m_device.createComputePipeline(m_pipelineCache, pipelineInfo);
+            m_device.destroyShaderModule(shaderModule);
+            if (result.result != vk::Result::eSuccess) {
+                throw std::runtime_error("Failed to create specialized compute pipeline");
+            }
+            return result.value;
+        });
+    }
+
+    vk::Pipeline SpecializedPipelineCache::getOrCreate(uint64_t key, const std::function<vk::Pipeline()>& create) {
+        return m_pipelines.getOrCreate(key, create);
+    }
+
+} // namespace Renderer
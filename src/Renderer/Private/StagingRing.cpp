@@ -0,0 +1,72 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#include "../Public/StagingRing.h"
+
+namespace Renderer {
+
+    StagingRing::StagingRing(vk::PhysicalDevice physicalDevice, vk::Device device, vk::DeviceSize capacity,
+                             vk::BufferUsageFlags usage)
+        : m_device(device)
+    {
+        // Coherent so callers never flush; cached so reading results back isn't an uncached crawl
+        m_buffer = createBuffer(physicalDevice, device, capacity, usage,
+                                vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+                                vk::MemoryPropertyFlagBits::eHostCached);
+    }
+
+    StagingRing::~StagingRing() {
+        destroyBuffer(m_device, m_buffer);
+    }
+
+    bool StagingRing::allocate(vk::DeviceSize size, vk::DeviceSize alignment, Region& region) {
+        if (size == 0 || size > m_buffer.size) {
+            return false;
+        }
+        if (alignment == 0) {
+            alignment = 1;
+        }
+
+        vk::DeviceSize offset = (m_head + alignment - 1) / alignment * alignment;
+        if (offset + size > m_buffer.size) {
+            // Doesn't fit before the end; skip the tail and start over at zero
+            offset = 0;
+        }
+        vk::DeviceSize consumed = (offset >= m_head ? offset - m_head : m_buffer.size - m_head) + size;
+        if (m_used + consumed > m_buffer.size) {
+            return false;
+        }
+
+        m_used += consumed;
+        m_openBytes += consumed;
+        m_head = offset + size;
+
+        region.buffer = m_buffer.buffer;
+        region.offset = offset;
+        region.size = size;
+        region.data = static_cast<uint8_t*>(m_buffer.mapped) + offset;
+        return true;
+    }
+
+    uint64_t StagingRing::close() {
+        uint64_t id = m_nextBatch++;
+        if (m_openBytes > 0) {
+            m_batches.push_back({id, m_openBytes});
+            m_openBytes = 0;
+        }
+        return id;
+    }
+
+    void StagingRing::retire(uint64_t batchId) {
+        while (!m_batches.empty() && m_batches.front().id <= batchId) {
+            m_used -= m_batches.front().bytes;
+            m_batches.pop_front();
+        }
+        if (m_used == 0) {
+            // Nothing live: rewind so the next run gets the whole buffer unfragmented
+            m_head = 0;
+        }
+    }
+
+} // namespace Renderer
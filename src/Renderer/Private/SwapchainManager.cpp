@@ -0,0 +1,167 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#include "../Public/SwapchainManager.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace Renderer {
+
+    namespace {
+
+        vk::SurfaceFormatKHR chooseFormat(const std::vector<vk::SurfaceFormatKHR>& available, vk::SurfaceFormatKHR preferred) {
+            if (available.empty()) {
+                throw std::runtime_error("Surface reports no formats");
+            }
+            for (const auto& format : available) {
+                if (format.format == preferred.format && format.colorSpace == preferred.colorSpace) {
+                    return format;
+                }
+            }
+            return available[0];
+        }
+
+        vk::PresentModeKHR choosePresentMode(const std::vector<vk::PresentModeKHR>& available, vk::PresentModeKHR preferred) {
+            if (std::find(available.begin(), available.end(), preferred) != available.end()) {
+                return preferred;
+            }
+            return vk::PresentModeKHR::eFifo;
+        }
+
+        vk::Extent2D chooseExtent(const vk::SurfaceCapabilitiesKHR& capabilities, vk::Extent2D windowExtent) {
+            if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
+                return capabilities.currentExtent;
+            }
+            return {
+                std::clamp(windowExtent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width),
+                std::clamp(windowExtent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height)
+            };
+        }
+
+    } // namespace
+
+    SwapchainManager::SwapchainManager(vk::PhysicalDevice physicalDevice, vk::Device device, vk::SurfaceKHR surface,
+                                       vk::Extent2D windowExtent, const SwapchainConfig& config)
+        : m_physicalDevice(physicalDevice)
+        , m_device(device)
+        , m_surface(surface)
+        , m_config(config)
+    {
+        m_format = chooseFormat(physicalDevice.getSurfaceFormatsKHR(surface), config.preferredFormat);
+        create(windowExtent, nullptr);
+    }
+
+    SwapchainManager::~SwapchainManager() {
+        for (auto& generation : m_retired) {
+            destroy(generation);
+        }
+        destroy(m_current);
+    }
+
+    void SwapchainManager::setFramebufferFactory(FramebufferFactory factory) {
+        for (auto framebuffer : m_current.framebuffers) {
+            m_device.destroyFramebuffer(framebuffer);
+        }
+        m_current.framebuffers.clear();
+        m_framebufferFactory = std::move(factory);
+        createFramebuffers();
+    }
+
+    void SwapchainManager::recreate(vk::Extent2D windowExtent, uint64_t retireValue) {
+        Generation old = std::move(m_current);
+        old.retireValue = retireValue;
+        m_current = {};
+
+        try {
+            create(windowExtent, old.swapchain);
+        } catch (...) {
+            m_retired.push_back(std::move(old));
+            throw;
+        }
+        // Once passed as oldSwapchain it can't acquire any more, but images already acquired may still be presenting
+        m_retired.push_back(std::move(old));
+        ++m_generation;
+    }
+
+    void SwapchainManager::collect(uint64_t completedValue) {
+        // Retired in order, so values only grow along the deque
+        while (!m_retired.empty() && m_retired.front().retireValue <= completedValue) {
+            destroy(m_retired.front());
+            m_retired.pop_front();
+        }
+    }
+
+    void SwapchainManager::create(vk::Extent2D windowExtent, vk::SwapchainKHR oldSwapchain) {
+        auto capabilities = m_physicalDevice.getSurfaceCapabilitiesKHR(m_surface);
+        m_extent = chooseExtent(capabilities, windowExtent);
+
+        uint32_t imageCount = capabilities.minImageCount + 1;
+        if (capabilities.maxImageCount > 0 && imageCount > capabilities.maxImageCount) {
+            imageCount = capabilities.maxImageCount;
+        }
+
+        vk::SwapchainCreateInfoKHR createInfo(
+            {},
+            m_surface,
+            imageCount,
+            m_format.format,
+            m_format.colorSpace,
+            m_extent,
+            1,
+            m_config.usage,
+            vk::SharingMode::eExclusive,
+            0,
+            nullptr,
+            capabilities.currentTransform,
+            vk::CompositeAlphaFlagBitsKHR::eOpaque,
+            choosePresentMode(m_physicalDevice.getSurfacePresentModesKHR(m_surface), m_config.preferredPresentMode),
+            VK_TRUE,
+            oldSwapchain
+        );
+
+        m_current.swapchain = m_device.createSwapchainKHR(createInfo);
+        m_images = m_device.getSwapchainImagesKHR(m_current.swapchain);
+
+        for (auto image : m_images) {
+            vk::ImageViewCreateInfo viewInfo(
+                {},
+                image,
+                vk::ImageViewType::e2D,
+                m_format.format,
+                {},
+                { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 }
+            );
+            m_current.views.push_back(m_device.createImageView(viewInfo));
+            m_current.presentSemaphores.push_back(m_device.createSemaphore({}));
+        }
+        createFramebuffers();
+    }
+
+    void SwapchainManager::createFramebuffers() {
+        if (!m_framebufferFactory) {
+            return;
+        }
+        for (auto view : m_current.views) {
+            m_current.framebuffers.push_back(m_framebufferFactory(view, m_extent));
+        }
+    }
+
+    void SwapchainManager::destroy(Generation& generation) {
+        for (auto framebuffer : generation.framebuffers) {
+            m_device.destroyFramebuffer(framebuffer);
+        }
+        for (auto view : generation.views) {
+            m_device.destroyImageView(view);
+        }
+        for (auto semaphore : generation.presentSemaphores) {
+            m_device.destroySemaphore(semaphore);
+        }
+        if (generation.swapchain) {
+            m_device.destroySwapchainKHR(generation.swapchain);
+        }
+        generation = {};
+    }
+
+} // namespace Renderer
@@ -0,0 +1,46 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#include "../Public/TimelineSemaphore.h"
+#include <stdexcept>
+
+namespace Renderer {
+
+    TimelineSemaphore::TimelineSemaphore(vk::Device device, uint64_t initialValue)
+        : m_device(device)
+        , m_lastReserved(initialValue)
+    {
+        vk::SemaphoreTypeCreateInfo typeInfo(vk::SemaphoreType::eTimeline, initialValue);
+        vk::SemaphoreCreateInfo createInfo({}, &typeInfo);
+        m_semaphore = device.createSemaphore(createInfo);
+    }
+
+    TimelineSemaphore::~TimelineSemaphore() {
+        m_device.destroySemaphore(m_semaphore);
+    }
+
+    uint64_t TimelineSemaphore::completed() const {
+        return m_device.getSemaphoreCounterValue(m_semaphore);
+    }
+
+    bool TimelineSemaphore::wait(uint64_t value, uint64_t timeoutNs) const {
+        vk::SemaphoreWaitInfo waitInfo({}, m_semaphore, value);
+        auto result = m_device.waitSemaphores(waitInfo, timeoutNs);
+        if (result == vk::Result::eTimeout) {
+            return false;
+        }
+        if (result != vk::Result::eSuccess) {
+            throw std::runtime_error("Failed to wait for timeline semaphore");
+        }
+        return true;
+    }
+
+    void TimelineSemaphore::signal(uint64_t value) {
+        m_device.signalSemaphore(vk::SemaphoreSignalInfo(m_semaphore, value));
+        if (value > m_lastReserved) {
+            m_lastReserved = value;
+        }
+    }
+
+} // namespace Renderer
@@ -0,0 +1,251 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#include "../Public/TlsfAllocator.h"
+#include <algorithm>
+#include <bit>
+
+namespace Renderer {
+
+    TlsfAllocator::TlsfAllocator(uint64_t size)
+        : m_size(size)
+        , m_freeBytes(size)
+    {
+        for (auto& heads : m_heads) {
+            std::fill(std::begin(heads), std::end(heads), kInvalidNode);
+        }
+        if (size > 0) {
+            uint32_t node = newNode();
+            m_nodes[node].offset = 0;
+            m_nodes[node].size = size;
+            m_firstPhysical = node;
+            insertFree(node);
+        }
+    }
+
+    void TlsfAllocator::mapping(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel) {
+        if (size < kSecondLevelCount) {
+            // Small sizes get one bin each in the first row
+            firstLevel = 0;
+            secondLevel = static_cast<uint32_t>(size);
+            return;
+        }
+        uint32_t msb = 63 - static_cast<uint32_t>(std::countl_zero(size));
+        firstLevel = msb - kSecondLevelBits + 1;
+        secondLevel = static_cast<uint32_t>(size >> (msb - kSecondLevelBits)) ^ kSecondLevelCount;
+    }
+
+    uint32_t TlsfAllocator::findFreeNode(uint64_t size) const {
+        // Round up to the next bin so any node found is big enough
+        if (size >= kSecondLevelCount) {
+            uint32_t msb = 63 - static_cast<uint32_t>(std::countl_zero(size));
+            uint64_t round = (uint64_t{1} << (msb - kSecondLevelBits)) - 1;
+            if (size > UINT64_MAX - round) {
+                return kInvalidNode;
+            }
+            size += round;
+        }
+        uint32_t firstLevel, secondLevel;
+        mapping(size, firstLevel, secondLevel);
+        if (firstLevel >= kFirstLevelCount) {
+            return kInvalidNode;
+        }
+
+        uint32_t secondMap = m_secondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+        if (secondMap == 0) {
+            uint64_t firstMap = firstLevel + 1 < 64 ? m_firstLevelBitmap & (~uint64_t{0} << (firstLevel + 1)) : 0;
+            if (firstMap == 0) {
+                return kInvalidNode;
+            }
+            firstLevel = static_cast<uint32_t>(std::countr_zero(firstMap));
+            secondMap = m_secondLevelBitmaps[firstLevel];
+        }
+        secondLevel = static_cast<uint32_t>(std::countr_zero(secondMap));
+        return m_heads[firstLevel][secondLevel];
+    }
+
+    bool TlsfAllocator::allocate(uint64_t size, uint64_t alignment, Range& range) {
+        if (size == 0 || size > m_freeBytes) {
+            return false;
+        }
+        alignment = std::max<uint64_t>(alignment, 1);
+
+        // Over-ask by the worst-case padding so the node found always fits once aligned
+        uint64_t search = size + alignment - 1;
+        if (search < size) {
+            return false;
+        }
+        uint32_t node = findFreeNode(search);
+        if (node == kInvalidNode) {
+            // Rounding up skips the bin search itself falls in; it may still hold a big enough node
+            uint32_t firstLevel, secondLevel;
+            mapping(search, firstLevel, secondLevel);
+            node = firstLevel < kFirstLevelCount ? m_heads[firstLevel][secondLevel] : kInvalidNode;
+            while (node != kInvalidNode && m_nodes[node].size < search) {
+                node = m_nodes[node].nextFree;
+            }
+            if (node == kInvalidNode) {
+                return false;
+            }
+        }
+        removeFree(node);
+
+        uint64_t aligned = (m_nodes[node].offset + alignment - 1) / alignment * alignment;
+        uint64_t padding = aligned - m_nodes[node].offset;
+        if (padding > 0) {
+            insertFree(splitFront(node, padding));
+        }
+        if (m_nodes[node].size > size) {
+            // Hand out the front and put the tail back on the free lists
+            uint32_t front = splitFront(node, size);
+            insertFree(node);
+            node = front;
+        }
+
+        m_nodes[node].isFree = false;
+        m_freeBytes -= m_nodes[node].size;
+        ++m_allocationCount;
+
+        range.offset = m_nodes[node].offset;
+        range.size = m_nodes[node].size;
+        range.node = node;
+        return true;
+    }
+
+    void TlsfAllocator::free(uint32_t node) {
+        if (node >= m_nodes.size() || m_nodes[node].isFree) {
+            return;
+        }
+        m_freeBytes += m_nodes[node].size;
+        --m_allocationCount;
+
+        uint32_t prev = m_nodes[node].prevPhysical;
+        if (prev != kInvalidNode && m_nodes[prev].isFree) {
+            removeFree(prev);
+            m_nodes[prev].size += m_nodes[node].size;
+            m_nodes[prev].nextPhysical = m_nodes[node].nextPhysical;
+            if (m_nodes[node].nextPhysical != kInvalidNode) {
+                m_nodes[m_nodes[node].nextPhysical].prevPhysical = prev;
+            }
+            releaseNode(node);
+            node = prev;
+        }
+
+        uint32_t next = m_nodes[node].nextPhysical;
+        if (next != kInvalidNode && m_nodes[next].isFree) {
+            removeFree(next);
+            m_nodes[node].size += m_nodes[next].size;
+            m_nodes[node].nextPhysical = m_nodes[next].nextPhysical;
+            if (m_nodes[next].nextPhysical != kInvalidNode) {
+                m_nodes[m_nodes[next].nextPhysical].prevPhysical = node;
+            }
+            releaseNode(next);
+        }
+
+        insertFree(node);
+    }
+
+    uint64_t TlsfAllocator::largestFreeRange() const {
+        if (m_firstLevelBitmap == 0) {
+            return 0;
+        }
+        // Every node in the highest non-empty bin is within one size class; scan just that list
+        uint32_t firstLevel = 63 - static_cast<uint32_t>(std::countl_zero(m_firstLevelBitmap));
+        uint32_t secondLevel = 31 - static_cast<uint32_t>(std::countl_zero(m_secondLevelBitmaps[firstLevel]));
+        uint64_t largest = 0;
+        for (uint32_t node = m_heads[firstLevel][secondLevel]; node != kInvalidNode; node = m_nodes[node].nextFree) {
+            largest = std::max(largest, m_nodes[node].size);
+        }
+        return largest;
+    }
+
+    std::vector<TlsfAllocator::Range> TlsfAllocator::allocations() const {
+        std::vector<Range> ranges;
+        ranges.reserve(m_allocationCount);
+        for (uint32_t node = m_firstPhysical; node != kInvalidNode; node = m_nodes[node].nextPhysical) {
+            if (!m_nodes[node].isFree) {
+                ranges.push_back({m_nodes[node].offset, m_nodes[node].size, node});
+            }
+        }
+        return ranges;
+    }
+
+    uint32_t TlsfAllocator::newNode() {
+        if (!m_unusedNodes.empty()) {
+            uint32_t node = m_unusedNodes.back();
+            m_unusedNodes.pop_back();
+            m_nodes[node] = {};
+            return node;
+        }
+        m_nodes.emplace_back();
+        return static_cast<uint32_t>(m_nodes.size() - 1);
+    }
+
+    void TlsfAllocator::releaseNode(uint32_t node) {
+        m_nodes[node] = {};
+        m_nodes[node].isFree = true;    // stale handles passed to free() are ignored
+        m_unusedNodes.push_back(node);
+    }
+
+    void TlsfAllocator::insertFree(uint32_t node) {
+        uint32_t firstLevel, secondLevel;
+        mapping(m_nodes[node].size, firstLevel, secondLevel);
+
+        Node& entry = m_nodes[node];
+        entry.isFree = true;
+        entry.prevFree = kInvalidNode;
+        entry.nextFree = m_heads[firstLevel][secondLevel];
+        if (entry.nextFree != kInvalidNode) {
+            m_nodes[entry.nextFree].prevFree = node;
+        }
+        m_heads[firstLevel][secondLevel] = node;
+        m_firstLevelBitmap |= uint64_t{1} << firstLevel;
+        m_secondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+    }
+
+    void TlsfAllocator::removeFree(uint32_t node) {
+        uint32_t firstLevel, secondLevel;
+        mapping(m_nodes[node].size, firstLevel, secondLevel);
+
+        Node& entry = m_nodes[node];
+        if (entry.prevFree != kInvalidNode) {
+            m_nodes[entry.prevFree].nextFree = entry.nextFree;
+        } else {
+            m_heads[firstLevel][secondLevel] = entry.nextFree;
+        }
+        if (entry.nextFree != kInvalidNode) {
+            m_nodes[entry.nextFree].prevFree = entry.prevFree;
+        }
+        entry.prevFree = entry.nextFree = kInvalidNode;
+        entry.isFree = false;
+
+        if (m_heads[firstLevel][secondLevel] == kInvalidNode) {
+            m_secondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+            if (m_secondLevelBitmaps[firstLevel] == 0) {
+                m_firstLevelBitmap &= ~(uint64_t{1} << firstLevel);
+            }
+        }
+    }
+
+    uint32_t TlsfAllocator::splitFront(uint32_t node, uint64_t size) {
+        uint32_t front = newNode();
+        // newNode() may have grown m_nodes; index afresh
+        Node& frontNode = m_nodes[front];
+        Node& backNode = m_nodes[node];
+        frontNode.offset = backNode.offset;
+        frontNode.size = size;
+        frontNode.prevPhysical = backNode.prevPhysical;
+        frontNode.nextPhysical = node;
+        if (backNode.prevPhysical != kInvalidNode) {
+            m_nodes[backNode.prevPhysical].nextPhysical = front;
+        } else {
+            m_firstPhysical = front;
+        }
+        backNode.prevPhysical = front;
+        backNode.offset += size;
+        backNode.size -= size;
+        return front;
+    }
+
+} // namespace Renderer
@@ -0,0 +1,59 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#include "../Public/UniformRing.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace Renderer {
+
+    namespace {
+
+        vk::DeviceSize alignUp(vk::DeviceSize value, vk::DeviceSize alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+    } // namespace
+
+    UniformRing::UniformRing(vk::PhysicalDevice physicalDevice, GpuAllocator& allocator, uint32_t framesInFlight,
+                             vk::DeviceSize bytesPerFrame, vk::DeviceSize blockRange)
+        : m_allocator(allocator)
+        , m_frameCount(std::max(framesInFlight, 1u))
+    {
+        const auto limits = physicalDevice.getProperties().limits;
+        m_alignment = std::max<vk::DeviceSize>(limits.minUniformBufferOffsetAlignment, 1);
+        m_blockRange = std::min<vk::DeviceSize>(blockRange, limits.maxUniformBufferRange);
+        m_regionSize = alignUp(std::max(bytesPerFrame, m_blockRange), m_alignment);
+
+        // Trailing blockRange bytes keep offset + range inside the buffer for a block pushed at the very end
+        m_buffer = allocator.createBuffer(m_regionSize * m_frameCount + m_blockRange, vk::BufferUsageFlagBits::eUniformBuffer,
+                                          vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+                                          vk::MemoryPropertyFlagBits::eDeviceLocal);
+    }
+
+    UniformRing::~UniformRing() {
+        m_allocator.destroyBuffer(m_buffer);
+    }
+
+    void UniformRing::begin(uint32_t frameSlot) {
+        m_regionStart = slotOffset(frameSlot);
+        m_head = m_regionStart;
+    }
+
+    uint32_t UniformRing::push(const void* data, vk::DeviceSize size) {
+        if (size > m_blockRange) {
+            throw std::runtime_error("Uniform block larger than the ring's descriptor range");
+        }
+        if (m_head + size > m_regionStart + m_regionSize) {
+            throw std::runtime_error("Uniform ring region for this frame is full");
+        }
+
+        vk::DeviceSize offset = m_head;
+        memcpy(static_cast<uint8_t*>(m_buffer.allocation.mapped) + offset, data, size);
+        m_head = alignUp(offset + size, m_alignment);
+        return static_cast<uint32_t>(offset);
+    }
+
+} // namespace Renderer
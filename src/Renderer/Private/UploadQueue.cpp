@@ -0,0 +1,178 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#include "../Public/UploadQueue.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace Renderer {
+
+    namespace {
+
+        // Keeps every chunk 16-byte aligned in the ring so memcpy runs on whole vectors
+        constexpr vk::DeviceSize kCopyAlignment = 16;
+
+        bool overlaps(const vk::BufferCopy& a, const vk::BufferCopy& b) {
+            return a.dstOffset < b.dstOffset + b.size && b.dstOffset < a.dstOffset + a.size;
+        }
+
+    } // namespace
+
+    UploadQueue::UploadQueue(vk::PhysicalDevice physicalDevice, vk::Device device, vk::Queue queue, uint32_t queueFamily,
+                             vk::DeviceSize stagingSize)
+        : m_device(device)
+        , m_queue(queue)
+        , m_staging(physicalDevice, device, stagingSize, vk::BufferUsageFlagBits::eTransferSrc)
+        // A quarter of the ring per chunk leaves room to keep filling while earlier chunks are in flight
+        , m_chunkSize(std::max<vk::DeviceSize>(stagingSize / 4 / kCopyAlignment * kCopyAlignment, kCopyAlignment))
+        , m_commandPool(device.createCommandPool(vk::CommandPoolCreateInfo(
+              vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer, queueFamily)))
+        , m_timeline(device)
+    {}
+
+    UploadQueue::~UploadQueue() {
+        while (!m_inFlight.empty()) {
+            waitOldest();
+        }
+        for (auto& submission : m_idle) {
+            m_device.destroyFence(submission.fence);
+        }
+        m_device.destroyCommandPool(m_commandPool);
+    }
+
+    void UploadQueue::upload(vk::Buffer destination, vk::DeviceSize offset, const void* data, vk::DeviceSize size) {
+        const auto* source = static_cast<const uint8_t*>(data);
+        while (size > 0) {
+            vk::DeviceSize chunk = std::min(size, m_chunkSize);
+            StagingRing::Region region;
+            while (!m_staging.allocate(chunk, kCopyAlignment, region)) {
+                // Ring full: push out what is queued and wait for the oldest batch to free its space
+                flush();
+                if (m_inFlight.empty()) {
+                    throw std::runtime_error("Upload chunk does not fit in an empty staging ring");
+                }
+                waitOldest();
+            }
+
+            memcpy(region.data, source, chunk);
+            m_copies.push_back({destination, vk::BufferCopy(region.offset, offset, chunk)});
+
+            source += chunk;
+            offset += chunk;
+            size -= chunk;
+            m_bytesUploaded += chunk;
+        }
+    }
+
+    uint64_t UploadQueue::flush() {
+        if (m_copies.empty()) {
+            return m_timeline.lastReserved();
+        }
+
+        Submission submission = acquireSubmission();
+        submission.commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+
+        // One vkCmdCopyBuffer per destination and round, regions in upload order
+        std::stable_sort(m_copies.begin(), m_copies.end(), [](const Copy& a, const Copy& b) {
+            return static_cast<VkBuffer>(a.destination) < static_cast<VkBuffer>(b.destination);
+        });
+
+        // Regions of one copy command must not overlap in the destination, so a region that
+        // rewrites an earlier upload's bytes goes in a later round, ordered after it by a barrier;
+        // the last upload wins, as it would have with one submission per upload
+        std::vector<uint32_t> rounds(m_copies.size(), 0);
+        uint32_t roundCount = 1;
+        for (size_t i = 0; i < m_copies.size(); ++i) {
+            for (size_t j = i; j-- > 0 && m_copies[j].destination == m_copies[i].destination;) {
+                if (overlaps(m_copies[i].region, m_copies[j].region)) {
+                    rounds[i] = std::max(rounds[i], rounds[j] + 1);
+                }
+            }
+            roundCount = std::max(roundCount, rounds[i] + 1);
+        }
+
+        std::vector<vk::BufferCopy> regions;
+        for (uint32_t round = 0; round < roundCount; ++round) {
+            if (round > 0) {
+                vk::MemoryBarrier previousRound(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eTransferWrite);
+                submission.commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer,
+                                                         {}, previousRound, nullptr, nullptr);
+            }
+            for (size_t i = 0; i < m_copies.size();) {
+                vk::Buffer destination = m_copies[i].destination;
+                regions.clear();
+                for (; i < m_copies.size() && m_copies[i].destination == destination; ++i) {
+                    if (rounds[i] == round) {
+                        regions.push_back(m_copies[i].region);
+                    }
+                }
+                if (!regions.empty()) {
+                    submission.commandBuffer.copyBuffer(m_staging.buffer(), destination, regions);
+                }
+            }
+        }
+        submission.commandBuffer.end();
+        m_copies.clear();
+
+        submission.stagingBatch = m_staging.close();
+        submission.ticket = m_timeline.next();
+
+        vk::Semaphore signal = m_timeline.handle();
+        vk::TimelineSemaphoreSubmitInfo timelineInfo({}, submission.ticket);
+        vk::SubmitInfo submitInfo({}, {}, submission.commandBuffer, signal, &timelineInfo);
+        m_queue.submit(submitInfo, submission.fence);
+
+        m_inFlight.push_back(submission);
+        ++m_submissionCount;
+        return submission.ticket;
+    }
+
+    void UploadQueue::collect() {
+        while (!m_inFlight.empty() && m_device.getFenceStatus(m_inFlight.front().fence) == vk::Result::eSuccess) {
+            retire(m_inFlight.front());
+            m_inFlight.pop_front();
+        }
+    }
+
+    void UploadQueue::wait(uint64_t ticket) {
+        while (!m_inFlight.empty() && m_inFlight.front().ticket <= ticket) {
+            waitOldest();
+        }
+    }
+
+    UploadQueue::Submission UploadQueue::acquireSubmission() {
+        collect();
+        if (!m_idle.empty()) {
+            Submission submission = m_idle.back();
+            m_idle.pop_back();
+            return submission;
+        }
+
+        Submission submission;
+        submission.commandBuffer = m_device.allocateCommandBuffers(
+            vk::CommandBufferAllocateInfo(m_commandPool, vk::CommandBufferLevel::ePrimary, 1)).front();
+        submission.fence = m_device.createFence({});
+        return submission;
+    }
+
+    void UploadQueue::retire(Submission& submission) {
+        // Batches retire in submission order, which is the order m_inFlight holds them in
+        m_staging.retire(submission.stagingBatch);
+        m_device.resetFences(submission.fence);
+        submission.stagingBatch = 0;
+        submission.ticket = 0;
+        m_idle.push_back(submission);
+    }
+
+    void UploadQueue::waitOldest() {
+        Submission& oldest = m_inFlight.front();
+        if (m_device.waitForFences(oldest.fence, VK_TRUE, UINT64_MAX) != vk::Result::eSuccess) {
+            throw std::runtime_error("Failed to wait for upload submission");
+        }
+        retire(oldest);
+        m_inFlight.pop_front();
+    }
+
+} // namespace Renderer
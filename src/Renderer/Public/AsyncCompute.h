@@ -0,0 +1,77 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#ifndef ASYNCCOMPUTE_H
+#define ASYNCCOMPUTE_H
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include "QueueFamilies.h"
+#include "TimelineSemaphore.h"
+#include <cstdint>
+#include <vector>
+
+namespace Renderer {
+
+    // A semaphore a submission waits on; value 0 means a binary semaphore (swapchain acquire etc.)
+    struct SemaphoreWait {
+        vk::Semaphore          semaphore;
+        uint64_t               value = 0;
+        vk::PipelineStageFlags stages = vk::PipelineStageFlagBits::eAllCommands;
+    };
+
+    // Submits compute work to its own queue, ordered by a timeline semaphore instead of fences
+    // and binary semaphore chains.
+    //
+    // Every submission signals the next value on the compute timeline. Graphics work that
+    // consumes the results waits on (computeTimeline(), value) only at the stages that read
+    // them, e.g. through a SemaphoreWait in its own submission, so a compute pass for frame N+1
+    // runs while frame N is still rendering.
+    //
+    // Resources written on one queue and read on the other need either
+    // vk::SharingMode::eConcurrent over QueueFamilies::uniqueFamilies() or an ownership
+    // transfer; the scheduler only orders execution.
+    class AsyncComputeScheduler {
+    public:
+        // graphicsQueue and computeQueue may be the same queue when the device has no async compute
+        AsyncComputeScheduler(vk::Device device, const QueueFamilies& families, vk::Queue graphicsQueue, vk::Queue computeQueue);
+        // Waits for everything it submitted
+        ~AsyncComputeScheduler();
+
+        AsyncComputeScheduler(const AsyncComputeScheduler&) = delete;
+        AsyncComputeScheduler& operator=(const AsyncComputeScheduler&) = delete;
+
+        // A primary command buffer on the compute family, already begun; buffers are
+        // recycled once the compute timeline passes their last submission
+        vk::CommandBuffer beginCompute();
+
+        // End and submit a buffer from beginCompute(), after any waits (e.g. on a graphics
+        // timeline whose output it reads). Returns the compute timeline value signaled on completion.
+        uint64_t submitCompute(vk::CommandBuffer commandBuffer, const std::vector<SemaphoreWait>& waits = {});
+
+        TimelineSemaphore& computeTimeline() { return m_computeTimeline; }
+
+        // False when both kinds of work land on the same queue and overlap is up to the driver
+        bool asyncCompute() const { return m_graphicsQueue != m_computeQueue; }
+
+        void waitIdle();
+
+    private:
+        struct ComputeBuffer {
+            vk::CommandBuffer commandBuffer;
+            uint64_t          retireValue = 0;  // compute timeline value after which it can be reused
+            bool              inUse = false;
+        };
+
+        vk::Device        m_device;
+        vk::Queue         m_graphicsQueue;
+        vk::Queue         m_computeQueue;
+        TimelineSemaphore m_computeTimeline;
+        vk::CommandPool   m_computePool;
+        std::vector<ComputeBuffer> m_computeBuffers;
+    };
+
+} // namespace Renderer
+
+#endif //ASYNCCOMPUTE_H
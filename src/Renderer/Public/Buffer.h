@@ -0,0 +1,39 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#ifndef BUFFER_H
+#define BUFFER_H
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+
+namespace Renderer {
+
+    // A buffer bound to its own dedicated allocation
+    struct Buffer {
+        vk::Buffer       buffer;
+        vk::DeviceMemory memory;
+        vk::DeviceSize   size = 0;
+        void*            mapped = nullptr;  // persistently mapped when the memory is host-visible
+        vk::MemoryPropertyFlags properties;
+    };
+
+    // Pick a memory type allowed by typeBits that has every required flag,
+    // preferring one that also has the preferred flags
+    // returns UINT32_MAX if nothing matches
+    uint32_t findMemoryType(const vk::PhysicalDeviceMemoryProperties& memoryProperties, uint32_t typeBits,
+                            vk::MemoryPropertyFlags required, vk::MemoryPropertyFlags preferred = {});
+
+    // throws std::runtime_error if no memory type fits or allocation fails
+    Buffer createBuffer(vk::PhysicalDevice physicalDevice, vk::Device device, vk::DeviceSize size,
+                        vk::BufferUsageFlags usage, vk::MemoryPropertyFlags required,
+                        vk::MemoryPropertyFlags preferred = {});
+
+    // Safe to call on an empty buffer; leaves it empty
+    void destroyBuffer(vk::Device device, Buffer& buffer);
+
+} // namespace Renderer
+
+#endif //BUFFER_H
@@ -0,0 +1,113 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#ifndef COMMANDCACHE_H
+#define COMMANDCACHE_H
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Renderer {
+
+    // What a recorded command buffer depends on. The target is the handle the recording
+    // renders into: its framebuffer, or the image view when rendering dynamically. The pipeline
+    // set is a hash of every pipeline the recording binds; the draw list version is bumped by
+    // whoever edits the draws. Recordings that bind per-frame-slot resources (e.g. a uniform
+    // ring region through a dynamic offset) set frameSlot and get one entry per (target, slot).
+    struct CommandCacheKey {
+        uint64_t target = 0;
+        uint32_t frameSlot = 0;
+        uint64_t pipelineSet = 0;
+        uint64_t drawListVersion = 0;
+
+        static uint64_t targetOf(vk::Framebuffer framebuffer) {
+            return reinterpret_cast<uint64_t>(static_cast<VkFramebuffer>(framebuffer));
+        }
+        static uint64_t targetOf(vk::ImageView view) {
+            return reinterpret_cast<uint64_t>(static_cast<VkImageView>(view));
+        }
+
+        bool operator==(const CommandCacheKey& other) const {
+            return target == other.target && frameSlot == other.frameSlot &&
+                   pipelineSet == other.pipelineSet && drawListVersion == other.drawListVersion;
+        }
+    };
+
+    // Primary command buffers recorded once per target and resubmitted until their
+    // key changes. One entry is kept per (target, frame slot): asking with a new pipeline
+    // set or draw list version re-records just that entry's buffer, the others stay valid.
+    //
+    // Buffers are recorded with simultaneous use, since a swapchain image can come back
+    // before its last submission has retired. A stale buffer is never reset while the GPU
+    // may still run it: it parks until collect() sees its timeline value complete.
+    class CommandBufferCache {
+    public:
+        using RecordFunction = std::function<void(vk::CommandBuffer)>;
+
+        // throws std::runtime_error if the command pool can't be created
+        CommandBufferCache(vk::Device device, uint32_t queueFamily);
+        ~CommandBufferCache();
+
+        CommandBufferCache(const CommandBufferCache&) = delete;
+        CommandBufferCache& operator=(const CommandBufferCache&) = delete;
+
+        // The buffer for key; record() fills in the commands between begin and end on a miss
+        vk::CommandBuffer get(const CommandCacheKey& key, const RecordFunction& record);
+
+        // The buffer last returned for key's target and slot will have finished once
+        // the submitting queue's timeline reaches value
+        void markSubmitted(const CommandCacheKey& key, uint64_t value);
+
+        // Recycle parked buffers whose submissions completed at or before completedValue
+        void collect(uint64_t completedValue);
+
+        // Drop every entry, e.g. when framebuffers or views are recreated and handles may be reused
+        void invalidateAll();
+
+        static uint64_t hashPipelines(std::initializer_list<vk::Pipeline> pipelines);
+
+        size_t hits() const { return m_hits; }
+        size_t recordings() const { return m_recordings; }
+
+    private:
+        struct Entry {
+            CommandCacheKey   key;
+            vk::CommandBuffer commandBuffer;
+            uint64_t          lastSubmitted = 0;
+        };
+
+        struct Parked {
+            vk::CommandBuffer commandBuffer;
+            uint64_t          lastSubmitted;
+        };
+
+        using Target = std::pair<uint64_t, uint32_t>;
+
+        struct TargetHash {
+            size_t operator()(const Target& target) const {
+                return std::hash<uint64_t>()(target.first ^ (static_cast<uint64_t>(target.second) << 56));
+            }
+        };
+
+        vk::CommandBuffer acquire();
+        void park(Entry& entry);
+
+        vk::Device      m_device;
+        vk::CommandPool m_pool;
+        std::unordered_map<Target, Entry, TargetHash> m_entries;
+        std::vector<Parked>            m_parked;
+        std::vector<vk::CommandBuffer> m_free;
+        size_t m_hits = 0;
+        size_t m_recordings = 0;
+    };
+
+} // namespace Renderer
+
+#endif //COMMANDCACHE_H
@@ -0,0 +1,120 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#ifndef COMPUTERUNNER_H
+#define COMPUTERUNNER_H
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include "Buffer.h"
+#include "DescriptorAllocator.h"
+#include "IShaderCompiler.h"
+#include "Specialization.h"
+#include "StagingRing.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Renderer {
+
+    // One storage buffer of a compute run, bound at (set 0, binding)
+    struct ComputeBinding {
+        uint32_t    binding = 0;
+        size_t      size = 0;           // bytes
+        const void* input = nullptr;    // uploaded before the dispatch; null starts the buffer zeroed
+        void*       output = nullptr;   // written after the dispatch, may alias input; null skips the readback
+    };
+
+    // Runs a compute shader over host arrays: batch number-crunching without a frame loop.
+    //
+    // Device buffers are kept per binding and grown on demand, so repeated runs of the same
+    // shape only record commands. On devices with cached host-visible device-local memory
+    // (integrated GPUs, software ICDs) the buffers are mapped and written directly; elsewhere
+    // data moves through a staging ring in chunks, double buffered over two submissions so
+    // arrays larger than the ring still stream. The only host waits are on those submissions' fences.
+    class ComputeRunner {
+    public:
+        // throws std::runtime_error if the staging ring or command pool can't be created
+        ComputeRunner(vk::PhysicalDevice physicalDevice, vk::Device device, vk::Queue queue, uint32_t queueFamily,
+                      vk::DeviceSize stagingSize = vk::DeviceSize{16} << 20);
+        ~ComputeRunner();
+
+        ComputeRunner(const ComputeRunner&) = delete;
+        ComputeRunner& operator=(const ComputeRunner&) = delete;
+
+        // Dispatch enough workgroups to cover invocations in each dimension, using the module's
+        // reflected workgroup size (after constants are applied), and wait for the outputs.
+        // throws std::runtime_error for non-compute modules, oversized dispatches and Vulkan failures
+        void run(const ShaderLoader::ShaderModule& module, const std::vector<ComputeBinding>& bindings,
+                 std::array<uint32_t, 3> invocations, const SpecializationConstants& constants = {});
+
+        // One buffer at binding 0, one invocation per element, results written back in place
+        template<typename T>
+        void runInPlace(const ShaderLoader::ShaderModule& module, std::vector<T>& data,
+                        const SpecializationConstants& constants = {}) {
+            ComputeBinding binding{0, data.size() * sizeof(T), data.data(), data.data()};
+            run(module, {binding}, {static_cast<uint32_t>(data.size()), 1, 1}, constants);
+        }
+
+        // False when buffers are mapped directly and no staging copies are recorded
+        bool usesStaging() const { return m_staging != nullptr; }
+
+    private:
+        struct Readback {
+            void*       destination;
+            const void* source;
+            size_t      size;
+        };
+
+        struct Submission {
+            vk::CommandBuffer     commandBuffer;
+            vk::Fence             fence;
+            uint64_t              stagingBatch = 0;
+            bool                  recording = false;
+            bool                  hasWork = false;
+            bool                  pending = false;
+            std::vector<Readback> readbacks;
+        };
+
+        struct Layouts {
+            vk::DescriptorSetLayout setLayout;
+            vk::PipelineLayout      pipelineLayout;
+        };
+
+        const Layouts& layoutsFor(const std::vector<ComputeBinding>& bindings);
+        vk::DescriptorSet writeDescriptorSet(const Layouts& layouts, const std::vector<ComputeBinding>& bindings);
+        Buffer& deviceBuffer(uint32_t binding, vk::DeviceSize size);
+
+        vk::CommandBuffer recordingCommandBuffer();
+        void submit();
+        void complete(Submission& submission, bool copyResults);
+        void completeAll(bool copyResults);
+        StagingRing::Region stage(vk::DeviceSize size);
+        void upload(const Buffer& buffer, const void* data, size_t size);
+        void readBack(const Buffer& buffer, void* data, size_t size);
+
+        vk::PhysicalDevice m_physicalDevice;
+        vk::Device         m_device;
+        vk::Queue          m_queue;
+        vk::PhysicalDeviceLimits m_limits;
+        vk::MemoryPropertyFlags  m_bufferMemory;
+
+        std::unique_ptr<StagingRing> m_staging;
+        vk::DeviceSize     m_chunkSize = 0;
+
+        vk::CommandPool    m_commandPool;
+        std::array<Submission, 2> m_submissions;
+        size_t             m_current = 0;
+
+        DescriptorAllocator m_descriptors;
+        std::unordered_map<uint64_t, Layouts> m_layouts;
+        std::unordered_map<uint32_t, Buffer>  m_buffers;
+        SpecializedPipelineCache m_pipelines;
+    };
+
+} // namespace Renderer
+
+#endif //COMPUTERUNNER_H
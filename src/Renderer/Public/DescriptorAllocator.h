@@ -0,0 +1,116 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#ifndef DESCRIPTORALLOCATOR_H
+#define DESCRIPTORALLOCATOR_H
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Renderer {
+
+    // One binding's contents: a buffer range or an image, depending on type
+    struct DescriptorWrite {
+        uint32_t                 binding = 0;
+        vk::DescriptorType       type = vk::DescriptorType::eStorageBuffer;
+        vk::DescriptorBufferInfo bufferInfo;
+        vk::DescriptorImageInfo  imageInfo;
+
+        static DescriptorWrite buffer(uint32_t binding, vk::DescriptorType type, vk::Buffer buffer,
+                                      vk::DeviceSize offset = 0, vk::DeviceSize range = VK_WHOLE_SIZE) {
+            DescriptorWrite write;
+            write.binding = binding;
+            write.type = type;
+            write.bufferInfo = vk::DescriptorBufferInfo(buffer, offset, range);
+            return write;
+        }
+
+        static DescriptorWrite image(uint32_t binding, vk::DescriptorType type, vk::Sampler sampler, vk::ImageView view,
+                                     vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal) {
+            DescriptorWrite write;
+            write.binding = binding;
+            write.type = type;
+            write.imageInfo = vk::DescriptorImageInfo(sampler, view, layout);
+            return write;
+        }
+    };
+
+    // How many descriptors of a type to provision per set in each pool
+    struct DescriptorPoolRatio {
+        vk::DescriptorType type;
+        float              perSet;
+    };
+
+    // Descriptor sets without per-set frees.
+    //
+    // Each frame slot owns a growing list of pools: allocate() takes sets from the slot's
+    // current pool and opens a bigger one when it runs out, and beginFrame() resets all the
+    // slot's pools wholesale with vkResetDescriptorPool. Sets that never change go through
+    // getImmutable(), which writes a set once per distinct (layout, contents) and hands the
+    // same set back for every later request with equal contents.
+    //
+    // Thread-safe.
+    class DescriptorAllocator {
+    public:
+        // Ratios cover the common types; pass your own when a layout needs others
+        DescriptorAllocator(vk::Device device, uint32_t framesInFlight, std::vector<DescriptorPoolRatio> ratios = {},
+                            uint32_t initialSetsPerPool = 64);
+        ~DescriptorAllocator();
+
+        DescriptorAllocator(const DescriptorAllocator&) = delete;
+        DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+        // Reset the slot's pools; the GPU must be done with the frame that last used this slot
+        void beginFrame(uint32_t frameSlot);
+
+        // A set valid until the current slot's next beginFrame()
+        // throws std::runtime_error if a fresh pool still can't hold the layout
+        vk::DescriptorSet allocate(vk::DescriptorSetLayout layout);
+        vk::DescriptorSet allocate(vk::DescriptorSetLayout layout, const std::vector<DescriptorWrite>& writes);
+
+        // A set with these contents, written on first request and cached by content hash.
+        // Lives until resetImmutable(); never update it after the fact.
+        vk::DescriptorSet getImmutable(vk::DescriptorSetLayout layout, const std::vector<DescriptorWrite>& writes);
+
+        // Drop every immutable set, e.g. after destroying resources they point at;
+        // the device must not be using any of them
+        void resetImmutable();
+
+        size_t immutableCount() const;
+        size_t immutableHits() const { return m_immutableHits; }
+
+    private:
+        struct PoolList {
+            std::vector<vk::DescriptorPool> full;
+            std::vector<vk::DescriptorPool> ready;
+            uint32_t setsPerPool = 0;
+        };
+
+        vk::DescriptorSet allocateFrom(PoolList& pools, vk::DescriptorSetLayout layout);
+        // A new pool of pools.setsPerPool sets, made the current one
+        vk::DescriptorPool createPool(PoolList& pools);
+        void resetPools(PoolList& pools);
+        void destroyPools(PoolList& pools);
+        void write(vk::DescriptorSet set, const std::vector<DescriptorWrite>& writes);
+
+        vk::Device m_device;
+        std::vector<DescriptorPoolRatio> m_ratios;
+        uint32_t   m_initialSetsPerPool;
+
+        mutable std::mutex m_mutex;
+        std::vector<PoolList> m_frames;
+        uint32_t   m_currentFrame = 0;
+
+        PoolList   m_immutablePools;
+        std::unordered_map<uint64_t, vk::DescriptorSet> m_immutableSets;
+        size_t     m_immutableHits = 0;
+    };
+
+} // namespace Renderer
+
+#endif //DESCRIPTORALLOCATOR_H
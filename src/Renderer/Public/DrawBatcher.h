@@ -0,0 +1,138 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#ifndef DRAWBATCHER_H
+#define DRAWBATCHER_H
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include "GpuAllocator.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Renderer {
+
+    // Indirect-draw capabilities worth using; enable the ones the device reports
+    struct IndirectDrawFeatures {
+        bool multiDrawIndirect = false;           // VkPhysicalDeviceFeatures, several commands per call
+        bool drawIndirectFirstInstance = false;   // VkPhysicalDeviceFeatures, non-zero firstInstance in commands
+        bool drawIndirectCount = false;           // VkPhysicalDeviceVulkan12Features, draw count read from a buffer
+    };
+
+    IndirectDrawFeatures queryIndirectDrawFeatures(vk::PhysicalDevice physicalDevice);
+
+    // Part of the bound index buffer drawn for one object
+    struct MeshRange {
+        uint32_t indexCount = 0;
+        uint32_t firstIndex = 0;
+        int32_t  vertexOffset = 0;
+
+        bool operator==(const MeshRange& other) const {
+            return indexCount == other.indexCount && firstIndex == other.firstIndex && vertexOffset == other.vertexOffset;
+        }
+    };
+
+    // Turns a frame's worth of per-object draws into as few GPU draws as possible.
+    //
+    // Objects sharing a pipeline and mesh range become one instanced draw; their per-instance
+    // data is packed back to back into a vertex buffer read at instanceBinding with
+    // vk::VertexInputRate::eInstance. Every draw of the frame is a vk::DrawIndexedIndirectCommand
+    // in one host-visible buffer, issued with one vkCmdDrawIndexedIndirectCount (or
+    // vkCmdDrawIndexedIndirect) per pipeline, so CPU cost scales with pipelines, not objects.
+    // Per-pipeline draw counts also live in a buffer, where a GPU culling pass could lower them.
+    //
+    // Buffers are kept per frame slot and grown on demand; steady-state frames allocate nothing.
+    // Not thread-safe.
+    class DrawBatcher {
+    public:
+        // instanceStride is the size of one object's per-instance data
+        DrawBatcher(GpuAllocator& allocator, uint32_t framesInFlight, uint32_t instanceStride, uint32_t instanceBinding,
+                    const IndirectDrawFeatures& features);
+        ~DrawBatcher();
+
+        DrawBatcher(const DrawBatcher&) = delete;
+        DrawBatcher& operator=(const DrawBatcher&) = delete;
+
+        // Start collecting for a frame slot; the GPU must be done with the frame that last used it
+        void begin(uint32_t frameSlot);
+
+        // instances points at count * instanceStride bytes
+        void add(vk::Pipeline pipeline, const MeshRange& mesh, const void* instances, uint32_t count = 1);
+
+        template<typename T>
+        void add(vk::Pipeline pipeline, const MeshRange& mesh, const std::vector<T>& instances) {
+            add(pipeline, mesh, instances.data(), static_cast<uint32_t>(instances.size()));
+        }
+
+        // Write the slot's instance, command and count buffers
+        void end();
+
+        // Bind each pipeline and issue its draws. The vertex and index buffers for the meshes
+        // must be bound; this binds the instance buffer and leaves the last pipeline bound.
+        void record(vk::CommandBuffer commandBuffer) const;
+
+        uint32_t instanceCount() const { return m_instanceCount; }
+        uint32_t drawCount() const { return static_cast<uint32_t>(m_commands.size()); }
+        uint32_t drawCallCount() const;
+
+    private:
+        struct BatchKey {
+            vk::Pipeline pipeline;
+            MeshRange    mesh;
+
+            bool operator==(const BatchKey& other) const { return pipeline == other.pipeline && mesh == other.mesh; }
+        };
+
+        struct BatchKeyHash {
+            size_t operator()(const BatchKey& key) const;
+        };
+
+        struct Batch {
+            BatchKey             key;
+            std::vector<uint8_t> instances;
+            uint32_t             count = 0;
+        };
+
+        struct PipelineGroup {
+            vk::Pipeline pipeline;
+            uint32_t     firstCommand = 0;
+            uint32_t     commandCount = 0;
+        };
+
+        struct GrowableBuffer {
+            AllocatedBuffer buffer;
+            vk::DeviceSize  capacity = 0;
+        };
+
+        struct FrameBuffers {
+            GrowableBuffer instances;
+            GrowableBuffer commands;
+            GrowableBuffer counts;
+        };
+
+        // Returns the mapped pointer
+        void* reserve(GrowableBuffer& buffer, vk::DeviceSize size, vk::BufferUsageFlags usage);
+
+        GpuAllocator&        m_allocator;
+        uint32_t             m_instanceStride;
+        uint32_t             m_instanceBinding;
+        IndirectDrawFeatures m_features;
+
+        std::vector<FrameBuffers> m_frames;
+        uint32_t                  m_currentFrame = 0;
+
+        // Batches persist across frames so their instance storage is reused
+        std::unordered_map<BatchKey, uint32_t, BatchKeyHash> m_batchIndex;
+        std::vector<Batch>         m_batches;
+        std::vector<uint32_t>      m_order;
+
+        std::vector<vk::DrawIndexedIndirectCommand> m_commands;
+        std::vector<PipelineGroup> m_groups;
+        uint32_t                   m_instanceCount = 0;
+    };
+
+} // namespace Renderer
+
+#endif //DRAWBATCHER_H
@@ -0,0 +1,44 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#ifndef DYNAMICRENDERING_H
+#define DYNAMICRENDERING_H
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+namespace Renderer {
+
+    // VK_KHR_dynamic_rendering is present and its feature bit is set
+    bool supportsDynamicRendering(vk::PhysicalDevice physicalDevice);
+
+    // Renders straight into an image view without render pass or framebuffer objects.
+    // Pipelines chain a vk::PipelineRenderingCreateInfo naming the attachment formats instead
+    // of a render pass; secondaries chain a vk::CommandBufferInheritanceRenderingInfo.
+    //
+    // The commands are loaded from the device since the loader only exports core entry points.
+    // Layout transitions a render pass would do are recorded as barriers around the pass,
+    // for a single color attachment that is cleared and then presented.
+    class DynamicRendering {
+    public:
+        // The device must have been created with the extension and feature enabled;
+        // throws std::runtime_error if the commands can't be loaded
+        explicit DynamicRendering(vk::Device device);
+
+        // Transition image for color output, discarding its contents, and begin rendering into view.
+        // Pass eContentsSecondaryCommandBuffers in flags when the pass body is executed from secondaries.
+        void begin(vk::CommandBuffer commandBuffer, vk::Image image, vk::ImageView view, vk::Extent2D extent,
+                   const vk::ClearValue& clearValue, vk::RenderingFlags flags = {}) const;
+
+        // End rendering and transition image for presentation
+        void end(vk::CommandBuffer commandBuffer, vk::Image image) const;
+
+    private:
+        PFN_vkCmdBeginRenderingKHR m_beginRendering = nullptr;
+        PFN_vkCmdEndRenderingKHR   m_endRendering = nullptr;
+    };
+
+} // namespace Renderer
+
+#endif //DYNAMICRENDERING_H
@@ -0,0 +1,80 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include "TimelineSemaphore.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace Renderer {
+
+    struct FramePacingStats {
+        uint64_t frame = 0;             // frames submitted so far
+        uint32_t framesInFlight = 0;
+        double   cpuFrameMs = 0.0;      // beginFrame to beginFrame
+        double   cpuWaitMs = 0.0;       // blocked in beginFrame on the GPU; high means GPU-bound
+        double   gpuLatencyMs = 0.0;    // submit until the host saw the frame's value on the timeline
+    };
+
+    // Paces the CPU against the GPU with one timeline semaphore on the graphics queue.
+    //
+    // Frame n signals value n. Before recording frame n the CPU waits for value
+    // n - framesInFlight, which also frees that frame's slot (command buffer, acquire
+    // semaphore, per-frame data) for reuse, so no per-frame fences are needed.
+    // Raising framesInFlight lets a CPU-bound renderer queue 3-4 frames ahead.
+    //
+    // Stats are smoothed with an exponential moving average; gpuLatencyMs is measured
+    // at the points the host polls the timeline, so it is an upper bound.
+    class FramePacer {
+    public:
+        static constexpr uint32_t kMaxFramesInFlight = 8;
+
+        // framesInFlight is clamped to [1, kMaxFramesInFlight]; needs the timelineSemaphore feature
+        FramePacer(vk::Device device, uint32_t framesInFlight);
+
+        uint32_t framesInFlight() const { return m_framesInFlight; }
+
+        // Wait until the slot for the next frame is free and return its index in [0, framesInFlight)
+        uint32_t beginFrame();
+
+        // Timeline and value the frame's last submission must signal
+        vk::Semaphore timeline() const { return m_timeline.handle(); }
+        uint64_t signalValue() const { return m_submitted + 1; }
+
+        // Highest frame value the GPU has finished, for retiring per-frame resources
+        uint64_t completedValue() const { return m_timeline.completed(); }
+
+        // Call once the frame's submission (signaling signalValue()) is queued.
+        // A frame abandoned before submitting (e.g. out-of-date swapchain) simply skips this.
+        void endFrame();
+
+        // Wait for every submitted frame, e.g. before destroying per-frame resources
+        void waitIdle();
+
+        const FramePacingStats& stats() const { return m_stats; }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        void observeCompleted();
+        static void smooth(double& average, double sample);
+
+        TimelineSemaphore m_timeline;
+        uint32_t          m_framesInFlight;
+        uint64_t          m_submitted = 0;
+        uint64_t          m_observed = 0;   // highest value whose latency was recorded
+        std::vector<Clock::time_point> m_submitTimes;   // indexed by value % kMaxFramesInFlight
+        Clock::time_point m_lastBegin;
+        bool              m_haveLastBegin = false;
+        FramePacingStats  m_stats;
+    };
+
+} // namespace Renderer
+
+#endif //FRAMEPACER_H
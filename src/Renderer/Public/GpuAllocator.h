@@ -0,0 +1,142 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#ifndef GPUALLOCATOR_H
+#define GPUALLOCATOR_H
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include "TlsfAllocator.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Renderer {
+
+    // Buffers and linear images vs optimal-tiling images. They get separate blocks so
+    // bufferImageGranularity never has to be honoured between neighbours.
+    enum class ResourceKind {
+        Linear,
+        Optimal
+    };
+
+    struct Allocation {
+        vk::DeviceMemory memory;
+        vk::DeviceSize   offset = 0;
+        vk::DeviceSize   size = 0;
+        void*            mapped = nullptr;      // persistently mapped when the memory is host-visible
+        uint32_t         memoryType = UINT32_MAX;
+        uint32_t         block = UINT32_MAX;
+        uint32_t         node = TlsfAllocator::kInvalidNode;   // kInvalidNode for dedicated allocations
+
+        explicit operator bool() const { return static_cast<bool>(memory); }
+    };
+
+    struct AllocatedBuffer {
+        vk::Buffer buffer;
+        Allocation allocation;
+    };
+
+    struct AllocatedImage {
+        vk::Image  image;
+        Allocation allocation;
+    };
+
+    struct HeapBudget {
+        uint32_t       heapIndex = 0;
+        vk::DeviceSize heapSize = 0;
+        vk::DeviceSize budget = 0;          // from VK_EXT_memory_budget, else 80% of the heap
+        vk::DeviceSize usage = 0;           // whole-process usage from the driver, else our blocks
+        vk::DeviceSize blockBytes = 0;      // device memory we hold
+        vk::DeviceSize allocatedBytes = 0;  // handed out from it
+        uint32_t       blockCount = 0;
+        uint32_t       allocationCount = 0;
+    };
+
+    // One resource relocation proposed by GpuAllocator::beginDefragmentation
+    struct DefragmentationMove {
+        Allocation source;
+        Allocation destination;
+        bool       skip = false;    // set to keep the resource where it is
+    };
+
+    struct GpuAllocatorConfig {
+        vk::DeviceSize blockSize = vk::DeviceSize{64} << 20;
+        bool           memoryBudgetExtension = false;   // VK_EXT_memory_budget is enabled on the device
+    };
+
+    // Sub-allocates device memory: one large vk::DeviceMemory block at a time per memory type
+    // and resource kind, carved into aligned ranges by a TlsfAllocator. Requests over half a
+    // block get a dedicated allocation. This keeps the number of live vk::DeviceMemory objects
+    // far below maxMemoryAllocationCount and makes most allocations a bitmap lookup.
+    //
+    // Thread-safe. Empty blocks are released, except one per pool kept to absorb churn.
+    class GpuAllocator {
+    public:
+        GpuAllocator(vk::PhysicalDevice physicalDevice, vk::Device device, const GpuAllocatorConfig& config = {});
+        // Every allocation must have been freed; remaining blocks are released regardless
+        ~GpuAllocator();
+
+        GpuAllocator(const GpuAllocator&) = delete;
+        GpuAllocator& operator=(const GpuAllocator&) = delete;
+
+        // throws std::runtime_error if no memory type fits or the device is out of memory
+        Allocation allocate(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags required,
+                            vk::MemoryPropertyFlags preferred = {}, ResourceKind kind = ResourceKind::Linear);
+        // Leaves allocation empty; safe to call on an empty one
+        void free(Allocation& allocation);
+
+        // Buffers listing more than one queue family are created with vk::SharingMode::eConcurrent
+        AllocatedBuffer createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags required,
+                                     vk::MemoryPropertyFlags preferred = {}, const std::vector<uint32_t>& queueFamilies = {});
+        void destroyBuffer(AllocatedBuffer& buffer);
+
+        AllocatedImage createImage(const vk::ImageCreateInfo& createInfo,
+                                   vk::MemoryPropertyFlags required = vk::MemoryPropertyFlagBits::eDeviceLocal);
+        void destroyImage(AllocatedImage& image);
+
+        // One entry per memory heap
+        std::vector<HeapBudget> budgets() const;
+
+        // Defragmentation hooks. beginDefragmentation plans moves (up to maxBytes) that empty
+        // the sparsest blocks into fuller ones of the same pool; destinations are already
+        // allocated and sparse blocks take no new allocations until endDefragmentation.
+        // The caller copies each resource, rebinds it to the destination (or sets skip), and
+        // once the GPU is done with the sources calls endDefragmentation to free the side
+        // that lost, releasing blocks that emptied.
+        std::vector<DefragmentationMove> beginDefragmentation(vk::DeviceSize maxBytes);
+        void endDefragmentation(const std::vector<DefragmentationMove>& moves);
+
+    private:
+        struct Block {
+            vk::DeviceMemory memory;
+            vk::DeviceSize   size = 0;
+            void*            mapped = nullptr;
+            uint32_t         memoryType = 0;
+            ResourceKind     kind = ResourceKind::Linear;
+            std::unique_ptr<TlsfAllocator> ranges;   // null for a dedicated allocation
+            bool             evacuating = false;
+        };
+
+        bool allocateFromBlock(uint32_t blockIndex, const vk::MemoryRequirements& requirements, Allocation& allocation);
+        uint32_t createBlock(uint32_t memoryType, ResourceKind kind, vk::DeviceSize size, bool dedicated);
+        void releaseBlock(uint32_t blockIndex);
+        void freeLocked(Allocation& allocation);
+        bool isSpareEmptyBlock(uint32_t blockIndex) const;
+
+        vk::PhysicalDevice m_physicalDevice;
+        vk::Device         m_device;
+        GpuAllocatorConfig m_config;
+        vk::PhysicalDeviceMemoryProperties m_memoryProperties;
+        uint32_t           m_maxAllocationCount;
+        uint32_t           m_deviceAllocationCount = 0;
+
+        mutable std::mutex m_mutex;
+        std::vector<std::unique_ptr<Block>> m_blocks;    // null slots are reused
+    };
+
+} // namespace Renderer
+
+#endif //GPUALLOCATOR_H
@@ -0,0 +1,215 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#ifndef GRAPHICSPIPELINELIBRARY_H
+#define GRAPHICSPIPELINELIBRARY_H
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include "PipelineCache.h"
+#include "WorkStealingPool.h"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Renderer {
+
+    // VK_EXT_graphics_pipeline_library (and the VK_KHR_pipeline_library it needs) is present
+    // and its feature bit is set
+    bool supportsGraphicsPipelineLibrary(vk::PhysicalDevice physicalDevice);
+
+    // Everything a graphics pipeline is built from, grouped by the library part it belongs to.
+    // Viewport and scissor are always dynamic; every color attachment is written without blending.
+    // Shader parts are cached by the SPIR-V content hashes, since module handles are reused once
+    // destroyed; a zero hash falls back to the handle.
+    struct GraphicsPipelineDesc {
+        // Vertex input interface
+        std::vector<vk::VertexInputBindingDescription>   bindings;
+        std::vector<vk::VertexInputAttributeDescription> attributes;
+        vk::PrimitiveTopology topology = vk::PrimitiveTopology::eTriangleList;
+
+        // Pre-rasterization shaders
+        vk::ShaderModule    vertexShader;
+        uint64_t            vertexShaderHash = 0;
+        std::string         vertexEntryPoint = "main";
+        vk::PolygonMode     polygonMode = vk::PolygonMode::eFill;
+        vk::CullModeFlags   cullMode = vk::CullModeFlagBits::eBack;
+        vk::FrontFace       frontFace = vk::FrontFace::eClockwise;
+
+        // Fragment shader
+        vk::ShaderModule    fragmentShader;
+        uint64_t            fragmentShaderHash = 0;
+        std::string         fragmentEntryPoint = "main";
+
+        // Fragment output interface: a render pass whose subpass writes one color attachment,
+        // or the color formats for dynamic rendering
+        vk::RenderPass          renderPass;
+        uint32_t                subpass = 0;
+        std::vector<vk::Format> colorFormats;
+
+        // Used by both shader parts and the linked pipeline
+        vk::PipelineLayout  layout;
+    };
+
+    // Canonical key for desc's contents: shader content hashes and every piece of state, but no
+    // handles, so it is stable across runs. Bindings and attributes are keyed in binding and
+    // location order. usesRenderPass stands in for desc.renderPass.
+    uint64_t hashPipelineState(const GraphicsPipelineDesc& desc, bool usesRenderPass);
+    inline uint64_t hashPipelineState(const GraphicsPipelineDesc& desc) {
+        return hashPipelineState(desc, static_cast<bool>(desc.renderPass));
+    }
+
+    class PipelineManifest;
+
+    // Graphics pipelines assembled from separately compiled parts.
+    //
+    // With the extension, each of the four parts (vertex input, pre-rasterization, fragment
+    // shader, fragment output) is compiled once as a library and shared by every pipeline
+    // whose description matches it; a new combination costs only a fast link. The same
+    // combination is then linked again with link-time optimization on a background thread,
+    // and update() swaps it in once ready. The fast-linked pipeline it replaces is destroyed
+    // once the caller's timeline shows the frames that bound it have completed. A library no
+    // pipeline was last built from, e.g. the old shader part after a hot reload, is retired the
+    // same way.
+    //
+    // Without the extension add() builds a complete pipeline right away, as before, and
+    // update() has nothing to do. Callers use the same ids either way.
+    //
+    // add(), replace() and pipeline() may be called from any thread; update() from one at a time.
+    //
+    // warmUp() builds the complete pipelines a previous run recorded on a pool of its own, into
+    // the pipeline cache; add() and replace() take a prebuilt pipeline for the same state, layout
+    // and render pass instead of compiling. One still queued is built by the caller instead, and
+    // one already compiling is waited for.
+    class GraphicsPipelineLibrary {
+    public:
+        using PipelineId = uint32_t;
+
+        // Shader modules only have to outlive the add() call that uses them
+        GraphicsPipelineLibrary(vk::Device device, vk::PipelineCache pipelineCache, bool useLibraries);
+        // Waits for background builds; the device must be done with every pipeline
+        ~GraphicsPipelineLibrary();
+
+        GraphicsPipelineLibrary(const GraphicsPipelineLibrary&) = delete;
+        GraphicsPipelineLibrary& operator=(const GraphicsPipelineLibrary&) = delete;
+
+        // A usable pipeline for desc, fast-linked from cached parts when libraries are in use.
+        // A description whose state matches one already added returns that id without touching
+        // the driver or taking a lock; ids are shared, so replace() changes the pipeline for
+        // every holder.
+        // throws std::runtime_error if a part or the pipeline fails to build
+        PipelineId add(const GraphicsPipelineDesc& desc);
+
+        // Rebuild id from desc, e.g. after a shader reload; only parts whose state changed compile.
+        // The pipeline it replaces goes once the timeline reaches retireValue.
+        void replace(PipelineId id, const GraphicsPipelineDesc& desc, uint64_t retireValue);
+
+        // Build every pipeline in manifest on the warm-up pool. resolve fills in the shader modules,
+        // layout and render pass from the entry's shader paths, and returns false to skip it (e.g.
+        // the shaders no longer match the recorded hashes). The modules must stay alive until
+        // finishWarmUp() or destruction.
+        void warmUp(const PipelineManifest& manifest,
+                    const std::function<bool(GraphicsPipelineDesc& desc, const std::string& vertexPath,
+                                             const std::string& fragmentPath)>& resolve);
+        // Block until every warm-up build has finished
+        void finishWarmUp();
+
+        // The best pipeline built so far for id; changes after update() swaps in an optimized one
+        vk::Pipeline pipeline(PipelineId id) const { return entryAt(id).current.load(std::memory_order_acquire); }
+
+        // Swap in finished optimized builds, retiring what they replace at retireValue, and destroy
+        // pipelines retired at or before completedValue. Returns whether any pipeline changed.
+        bool update(uint64_t retireValue, uint64_t completedValue);
+
+        bool usesLibraries() const { return m_useLibraries; }
+        size_t libraryCount() const;
+        size_t pendingOptimizations() const;
+        size_t prebuiltHits() const { return m_prebuiltHits.load(std::memory_order_relaxed); }
+        size_t sharedHits() const { return m_sharedHits.load(std::memory_order_relaxed); }
+
+    private:
+        enum Part { VertexInput, PreRasterization, FragmentShader, FragmentOutput, PartCount };
+        using LibraryKeys = std::array<uint64_t, PartCount>;
+
+        // Left in m_ids under a state no id is built from any more
+        static constexpr PipelineId kNoPipeline = ~PipelineId{0};
+
+        // Entries live in fixed-size chunks that never move, so pipeline() can read one while
+        // another thread's add() appends
+        static constexpr size_t kEntryChunkSize = 256;
+        static constexpr size_t kMaxEntryChunks = 1024;
+
+        struct Entry {
+            std::atomic<VkPipeline> current{VK_NULL_HANDLE};   // written under m_mutex, read without it
+            vk::Pipeline optimized;     // set by the background build, guarded by m_mutex
+            bool         pending = false;
+            uint32_t     version = 0;   // bumped by replace(); stale background builds are dropped
+            uint64_t     key = 0;       // the state it was last built from, see m_ids
+            LibraryKeys  parts{};       // the libraries it was last linked from, one use each; 0 if none
+        };
+
+        struct Library {
+            vk::Pipeline pipeline;
+            uint32_t     users = 0;     // entries and queued optimized links using it
+        };
+
+        struct Retired {
+            vk::Pipeline pipeline;
+            uint64_t     retireValue;
+        };
+
+        Entry& entryAt(PipelineId id) const {
+            return m_entryChunks[id / kEntryChunkSize].load(std::memory_order_acquire)[id % kEntryChunkSize];
+        }
+        // A new entry's id; m_mutex must be held
+        PipelineId appendEntry();
+
+        // The current pipeline for desc; with libraries, also queues its optimized link and fills
+        // in parts with the libraries it took a use of
+        vk::Pipeline build(PipelineId id, const GraphicsPipelineDesc& desc, LibraryKeys& parts);
+        // Drop whatever the background is building for id's previous state; returns the new version
+        uint32_t restart(PipelineId id, bool optimizing);
+        // A warmed-up pipeline for desc, waiting for it if its build is underway
+        vk::Pipeline takePrebuilt(const GraphicsPipelineDesc& desc);
+        // The library for part of desc, with one more use taken; key is what releases it
+        vk::Pipeline getLibrary(Part part, const GraphicsPipelineDesc& desc, uint64_t& key);
+        // Take or drop a use of each library in keys; one left unused is retired at retireValue.
+        // m_mutex must be held
+        void retainLibraries(const LibraryKeys& keys);
+        void releaseLibraries(const LibraryKeys& keys, uint64_t retireValue);
+        vk::Pipeline link(const std::array<vk::Pipeline, PartCount>& libraries, vk::PipelineLayout layout, bool optimize);
+        vk::Pipeline buildComplete(const GraphicsPipelineDesc& desc);
+
+        vk::Device        m_device;
+        vk::PipelineCache m_pipelineCache;
+        bool              m_useLibraries;
+
+        std::unordered_map<uint64_t, Library> m_libraries;   // guarded by m_mutex
+        std::array<std::atomic<Entry*>, kMaxEntryChunks> m_entryChunks{};
+        size_t               m_entryCount = 0;   // guarded by m_mutex
+        LockFreeTable<PipelineId> m_ids;   // by runtimeKey; writes also hold m_mutex
+        std::vector<Retired> m_retired;
+        std::unordered_map<uint64_t, vk::Pipeline> m_prebuilt;   // by runtimeKey, guarded by m_mutex
+        std::unordered_map<uint64_t, bool> m_warming;   // queued warm-ups by runtimeKey, true once building
+        std::condition_variable m_warmed;               // a warm-up build left m_warming
+        std::atomic<size_t>  m_prebuiltHits{0};
+        std::atomic<size_t>  m_sharedHits{0};
+        mutable std::mutex   m_mutex;
+
+        // Declared last so their threads stop before the state they write to goes away; the
+        // warm-up pool is only started by warmUp()
+        std::unique_ptr<ShaderLoader::WorkStealingPool> m_warmUp;
+        ShaderLoader::WorkStealingPool m_optimizer;
+    };
+
+} // namespace Renderer
+
+#endif //GRAPHICSPIPELINELIBRARY_H
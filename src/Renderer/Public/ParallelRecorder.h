@@ -0,0 +1,79 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#ifndef PARALLELRECORDER_H
+#define PARALLELRECORDER_H
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include "WorkStealingPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace Renderer {
+
+    // Records a large draw list on several threads.
+    //
+    // Each frame slot owns one command pool per recording context plus one for the primary
+    // buffer. A draw list is cut into at most one slice per context; slice i always records
+    // with context i into a secondary buffer, so no pool is ever touched by two threads at
+    // once. The primary buffer then executes the secondaries in slice order.
+    //
+    // Pools are transient and reset wholesale in beginFrame(); buffers stay allocated and
+    // are handed out again, so steady-state frames allocate nothing.
+    class ParallelRecorder {
+    public:
+        // Record draws [begin, end) of the draw list into a secondary buffer that is already
+        // begun inside the render pass; bind state is not inherited, so bind what the slice needs
+        using RecordSlice = std::function<void(vk::CommandBuffer commandBuffer, size_t begin, size_t end)>;
+
+        // threadCount 0 means one worker per hardware thread
+        ParallelRecorder(vk::Device device, uint32_t queueFamily, uint32_t framesInFlight, unsigned threadCount = 0);
+        ~ParallelRecorder();
+
+        ParallelRecorder(const ParallelRecorder&) = delete;
+        ParallelRecorder& operator=(const ParallelRecorder&) = delete;
+
+        // Reset the slot's pools; the GPU must be done with the frame that last used this slot
+        void beginFrame(uint32_t frameSlot);
+
+        // A primary buffer from the current slot, not yet begun
+        vk::CommandBuffer primary();
+
+        // Record drawCount draws in parallel slices of at least minDrawsPerSlice draws.
+        // inheritance names the render pass, subpass and framebuffer the secondaries continue, or
+        // chains a vk::CommandBufferInheritanceRenderingInfo when they continue dynamic rendering.
+        // Returns the secondaries in draw order, ready for executeCommands; valid until the next call.
+        const std::vector<vk::CommandBuffer>& record(const vk::CommandBufferInheritanceInfo& inheritance, size_t drawCount,
+                                                     const RecordSlice& recordSlice, size_t minDrawsPerSlice = 256);
+
+        unsigned contextCount() const { return m_contextCount; }
+
+    private:
+        struct Context {
+            vk::CommandPool                pool;
+            std::vector<vk::CommandBuffer> buffers;
+            size_t                         used = 0;
+        };
+
+        struct FrameSlot {
+            Context              primary;
+            std::vector<Context> contexts;
+        };
+
+        vk::CommandBuffer next(Context& context, vk::CommandBufferLevel level);
+
+        vk::Device m_device;
+        ShaderLoader::WorkStealingPool m_workers;
+        unsigned   m_contextCount;
+        std::vector<FrameSlot> m_slots;
+        uint32_t   m_currentSlot = 0;
+        std::vector<vk::CommandBuffer> m_recorded;
+    };
+
+} // namespace Renderer
+
+#endif //PARALLELRECORDER_H
@@ -0,0 +1,205 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#ifndef PIPELINECACHE_H
+#define PIPELINECACHE_H
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace Renderer {
+
+    // 64-bit keys to small trivially copyable values (handles, ids), never removed.
+    //
+    // Lookups are lock-free: an open-addressed table of atomic slots, published through an
+    // atomic pointer. Writes take a mutex, and growing copies into a new table; superseded
+    // tables stay allocated until clear() or destruction so a reader never touches freed memory.
+    template <typename Value>
+    class LockFreeTable {
+    public:
+        explicit LockFreeTable(size_t initialCapacity = 256)
+            : m_capacity(std::bit_ceil(std::max<size_t>(initialCapacity, 16)))
+        {
+            publish(std::make_unique<Table>(m_capacity));
+        }
+
+        LockFreeTable(const LockFreeTable&) = delete;
+        LockFreeTable& operator=(const LockFreeTable&) = delete;
+
+        // The value stored under key, if any; never blocks
+        std::optional<Value> find(uint64_t key) const {
+            key = slotKey(key);
+            const Table* table = m_table.load(std::memory_order_acquire);
+            for (size_t i = key & table->mask;; i = (i + 1) & table->mask) {
+                uint64_t slot = table->slots[i].key.load(std::memory_order_acquire);
+                if (slot == key) {
+                    return table->slots[i].value.load(std::memory_order_acquire);
+                }
+                if (slot == 0) {
+                    // Tables are never more than half full, so every probe ends at an empty slot
+                    return std::nullopt;
+                }
+            }
+        }
+
+        // Store value under key unless the key is already there. Returns the stored value and
+        // whether it is the one passed in.
+        std::pair<Value, bool> insert(uint64_t key, Value value) {
+            return write(key, value, false);
+        }
+
+        // Store value under key, replacing any earlier one
+        void assign(uint64_t key, Value value) {
+            write(key, value, true);
+        }
+
+        // Every stored value, under the write lock
+        template <typename Fn>
+        void forEach(Fn&& fn) const {
+            std::lock_guard lock(m_mutex);
+            const Table* table = m_table.load(std::memory_order_relaxed);
+            for (size_t i = 0; i <= table->mask; ++i) {
+                if (table->slots[i].key.load(std::memory_order_relaxed) != 0) {
+                    fn(table->slots[i].value.load(std::memory_order_relaxed));
+                }
+            }
+        }
+
+        size_t size() const { return m_size.load(std::memory_order_relaxed); }
+
+        // Drop every entry; no lookup may run meanwhile
+        void clear() {
+            std::lock_guard lock(m_mutex);
+            m_tables.clear();
+            publish(std::make_unique<Table>(m_capacity));
+            m_size.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        struct Slot {
+            std::atomic<uint64_t> key{0};       // 0 marks an empty slot
+            std::atomic<Value>    value{};
+        };
+
+        struct Table {
+            explicit Table(size_t capacity)
+                : mask(capacity - 1)
+                , slots(new Slot[capacity])
+            {}
+            size_t                  mask;
+            std::unique_ptr<Slot[]> slots;
+        };
+
+        static uint64_t slotKey(uint64_t key) { return key ? key : 1; }
+
+        // The slot holding key, or the empty slot it would go in
+        static Slot& probe(Table& table, uint64_t key) {
+            for (size_t i = key & table.mask;; i = (i + 1) & table.mask) {
+                uint64_t slot = table.slots[i].key.load(std::memory_order_relaxed);
+                if (slot == key || slot == 0) {
+                    return table.slots[i];
+                }
+            }
+        }
+
+        static void fill(Slot& slot, uint64_t key, Value value) {
+            // Value first, then the key that makes the slot visible
+            slot.value.store(value, std::memory_order_relaxed);
+            slot.key.store(key, std::memory_order_release);
+        }
+
+        void publish(std::unique_ptr<Table> table) {
+            m_table.store(table.get(), std::memory_order_release);
+            m_tables.push_back(std::move(table));
+        }
+
+        std::pair<Value, bool> write(uint64_t key, Value value, bool replace) {
+            key = slotKey(key);
+            std::lock_guard lock(m_mutex);
+            Table* table = m_table.load(std::memory_order_relaxed);
+            Slot& existing = probe(*table, key);
+            if (existing.key.load(std::memory_order_relaxed) == key) {
+                if (!replace) {
+                    return {existing.value.load(std::memory_order_relaxed), false};
+                }
+                existing.value.store(value, std::memory_order_release);
+                return {value, true};
+            }
+
+            size_t size = m_size.load(std::memory_order_relaxed) + 1;
+            if (size * 2 > table->mask + 1) {
+                // Readers keep using the old table until the new one is published, fully filled
+                auto grown = std::make_unique<Table>((table->mask + 1) * 2);
+                for (size_t i = 0; i <= table->mask; ++i) {
+                    uint64_t slot = table->slots[i].key.load(std::memory_order_relaxed);
+                    if (slot != 0) {
+                        fill(probe(*grown, slot), slot, table->slots[i].value.load(std::memory_order_relaxed));
+                    }
+                }
+                fill(probe(*grown, key), key, value);
+                publish(std::move(grown));
+            } else {
+                fill(existing, key, value);
+            }
+            m_size.store(size, std::memory_order_relaxed);
+            return {value, true};
+        }
+
+        size_t                              m_capacity;
+        std::atomic<Table*>                 m_table{nullptr};
+        std::vector<std::unique_ptr<Table>> m_tables;   // every table ever published, guarded by m_mutex
+        mutable std::mutex                  m_mutex;
+        std::atomic<size_t>                 m_size{0};
+    };
+
+    // Built pipelines by a 64-bit key the caller derives from canonical state (shader content
+    // hashes plus fixed-function state, e.g. hashPipelineState). Not the driver's
+    // VkPipelineCache, which only speeds up compiles: a hit here skips the driver entirely.
+    //
+    // Lookups are lock-free (see LockFreeTable); only inserts take a lock. Pipelines are never
+    // evicted, only dropped all at once by clear().
+    class PipelineCache {
+    public:
+        explicit PipelineCache(vk::Device device, size_t initialCapacity = 256);
+        // Destroys every pipeline; the device must not be using them
+        ~PipelineCache();
+
+        PipelineCache(const PipelineCache&) = delete;
+        PipelineCache& operator=(const PipelineCache&) = delete;
+
+        // The pipeline stored under key, or null; never blocks
+        vk::Pipeline find(uint64_t key) const;
+
+        // find(), building with create() on a miss. The build runs outside any lock, so unrelated
+        // pipelines compile concurrently; if two threads race on one key, the loser's pipeline
+        // is destroyed and both get the winner's.
+        vk::Pipeline getOrCreate(uint64_t key, const std::function<vk::Pipeline()>& create);
+
+        size_t size() const { return m_pipelines.size(); }
+        size_t hits() const { return m_hits.load(std::memory_order_relaxed); }
+        size_t misses() const { return m_misses.load(std::memory_order_relaxed); }
+
+        // Destroy every pipeline; the device must not be using them and no lookup may run meanwhile
+        void clear();
+
+    private:
+        vk::Device                  m_device;
+        LockFreeTable<VkPipeline>   m_pipelines;
+        mutable std::atomic<size_t> m_hits{0};
+        std::atomic<size_t>         m_misses{0};
+    };
+
+} // namespace Renderer
+
+#endif //PIPELINECACHE_H
@@ -0,0 +1,55 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#ifndef PIPELINEMANIFEST_H
+#define PIPELINEMANIFEST_H
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include "GraphicsPipelineLibrary.h"
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace Renderer {
+
+    // Every graphics pipeline description created at runtime, saved so the next launch can
+    // build them in the background before they're asked for (GraphicsPipelineLibrary::warmUp).
+    // Entries hold the shader files and their content hashes plus the fixed-function state and
+    // attachment formats; handles (modules, layout, render pass) don't survive a restart and
+    // are filled back in by the caller when warming up.
+    class PipelineManifest {
+    public:
+        struct Entry {
+            std::string          vertexPath;
+            std::string          fragmentPath;
+            GraphicsPipelineDesc desc;      // shader hashes set, handles null
+            bool                 usesRenderPass = false;
+        };
+
+        // Note a pipeline built from the shaders at these paths; desc must carry both shader hashes.
+        // returns true if it wasn't in the manifest yet
+        bool record(const GraphicsPipelineDesc& desc, const std::string& vertexPath, const std::string& fragmentPath);
+
+        const std::vector<Entry>& entries() const { return m_entries; }
+        bool dirty() const { return m_dirty; }
+
+        bool load(const std::string& path);
+        bool save(const std::string& path);
+
+    private:
+        std::vector<Entry>           m_entries;
+        std::unordered_set<uint64_t> m_keys;
+        bool                         m_dirty = false;
+    };
+
+    // A pipeline cache seeded from path when the file was written by this device and driver, empty otherwise.
+    // throws std::runtime_error if the cache can't be created
+    vk::PipelineCache loadPipelineCache(vk::PhysicalDevice physicalDevice, vk::Device device, const std::string& path);
+    bool savePipelineCache(vk::Device device, vk::PipelineCache pipelineCache, const std::string& path);
+
+} // namespace Renderer
+
+#endif //PIPELINEMANIFEST_H
@@ -0,0 +1,43 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#ifndef QUEUEFAMILIES_H
+#define QUEUEFAMILIES_H
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace Renderer {
+
+    // Queue families picked for each kind of work. Families may coincide;
+    // compute is only asynchronous when it gets a queue of its own.
+    struct QueueFamilies {
+        uint32_t graphics = UINT32_MAX;     // also presents when selected against a surface
+        uint32_t compute = UINT32_MAX;
+        uint32_t transfer = UINT32_MAX;
+        uint32_t computeQueueIndex = 0;     // 1 when compute shares the graphics family but has a second queue
+
+        bool complete() const { return graphics != UINT32_MAX && compute != UINT32_MAX && transfer != UINT32_MAX; }
+        bool asyncCompute() const { return compute != graphics || computeQueueIndex != 0; }
+        bool dedicatedTransfer() const { return transfer != graphics && transfer != compute; }
+
+        // Distinct family indices, e.g. for vk::SharingMode::eConcurrent buffers used on several queues
+        std::vector<uint32_t> uniqueFamilies() const;
+    };
+
+    // Prefers a compute family without graphics (async compute hardware) and a
+    // transfer-only family (DMA engines); falls back to sharing the graphics family.
+    // With a surface the graphics family must also support presenting to it, and one that
+    // supports compute as well is chosen when there is one.
+    // Check complete() on the result.
+    QueueFamilies selectQueueFamilies(vk::PhysicalDevice physicalDevice, vk::SurfaceKHR surface = nullptr);
+
+    // One create info per family with as many queues as the selection uses
+    std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos(const QueueFamilies& families);
+
+} // namespace Renderer
+
+#endif //QUEUEFAMILIES_H
@@ -0,0 +1,59 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#ifndef SHADERMODULECACHE_H
+#define SHADERMODULECACHE_H
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include "ShaderLoader.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Renderer {
+
+    // VkShaderModules for the shaders a ShaderLoader holds, keyed by SPIR-V content hash, so
+    // every pipeline built from the same bytes shares one module and the driver parses it once.
+    // Paths with identical contents share a module too.
+    //
+    // After ShaderLoader::reloadChanged(), pass the reloaded paths to invalidate(); modules whose
+    // contents were replaced are destroyed and the next get() creates them from the new SPIR-V.
+    // Pipelines don't reference their modules once created, so nothing else has to wait.
+    class ShaderModuleCache {
+    public:
+        // loader must outlive the cache
+        ShaderModuleCache(vk::Device device, const ShaderLoader::ShaderLoader& loader);
+        ~ShaderModuleCache();
+
+        ShaderModuleCache(const ShaderModuleCache&) = delete;
+        ShaderModuleCache& operator=(const ShaderModuleCache&) = delete;
+
+        // The module for path's currently loaded SPIR-V, created on first use. Thread-safe.
+        // throws std::runtime_error if path isn't loaded
+        vk::ShaderModule get(const std::string& path);
+
+        // Destroy the modules paths were last resolved to, unless their contents are unchanged
+        // or another path still uses them
+        void invalidate(const std::vector<std::string>& paths);
+
+        size_t size() const;
+        size_t hits() const { return m_hits; }
+        size_t creations() const { return m_creations; }
+
+    private:
+        vk::Device                            m_device;
+        const ShaderLoader::ShaderLoader&     m_loader;
+        std::unordered_map<uint64_t, vk::ShaderModule> m_modules;   // by content hash
+        std::unordered_map<std::string, uint64_t>      m_paths;     // hash each path was last resolved to
+        size_t                                m_hits = 0;
+        size_t                                m_creations = 0;
+        mutable std::mutex                    m_mutex;
+    };
+
+} // namespace Renderer
+
+#endif //SHADERMODULECACHE_H
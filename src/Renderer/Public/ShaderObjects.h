@@ -0,0 +1,84 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#ifndef SHADEROBJECTS_H
+#define SHADEROBJECTS_H
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include "GraphicsPipelineLibrary.h"
+#include "IShaderCompiler.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Renderer {
+
+    // VK_EXT_shader_object is present and its feature bit is set. Shader objects render with
+    // dynamic rendering only, so the caller needs that too.
+    bool supportsShaderObject(vk::PhysicalDevice physicalDevice);
+
+    // A vertex and a fragment shader bound without a pipeline. Each stage is its own unlinked
+    // VkShaderEXT, so replacing one (a hot-reloaded fragment shader, say) costs a single
+    // shader compile and leaves the other as it is.
+    //
+    // Everything a pipeline would bake in is set as dynamic state by setState(), from the same
+    // GraphicsPipelineDesc the pipeline path is built from. Replaced shaders are destroyed once
+    // the caller's timeline passes the value given when they were replaced.
+    class ShaderObjects {
+    public:
+        // setLayouts and pushConstantRanges must match the pipeline layout used to bind resources.
+        // throws std::runtime_error if the device lacks the commands
+        ShaderObjects(vk::Device device, std::vector<vk::DescriptorSetLayout> setLayouts,
+                      std::vector<vk::PushConstantRange> pushConstantRanges);
+        // The device must be done with every shader
+        ~ShaderObjects();
+
+        ShaderObjects(const ShaderObjects&) = delete;
+        ShaderObjects& operator=(const ShaderObjects&) = delete;
+
+        // Create stage (vertex or fragment) from module, replacing the current shader once created.
+        // The old shader goes once the timeline reaches retireValue.
+        // throws std::runtime_error if the shader fails to build; the current one stays bound then
+        void setStage(vk::ShaderStageFlagBits stage, const ShaderLoader::ShaderModule& module, uint64_t retireValue = 0,
+                      const std::string& entryPoint = "main");
+
+        // Destroy replaced shaders retired at or before completedValue
+        void collect(uint64_t completedValue);
+
+        bool ready() const { return m_vertex && m_fragment; }
+
+        // Bind both stages; other graphics stages stay unbound
+        void bind(vk::CommandBuffer commandBuffer) const;
+
+        // Set every piece of state the shaders draw with: vertex input, rasterization, viewport and
+        // scissor covering extent, and no depth, stencil or blending on desc's color attachments
+        void setState(vk::CommandBuffer commandBuffer, const GraphicsPipelineDesc& desc, vk::Extent2D extent) const;
+
+        // Changes whenever a stage is replaced; fold it into anything keyed on the bound shaders
+        uint64_t generation() const { return m_generation; }
+
+    private:
+        struct Commands;
+
+        struct Retired {
+            VkShaderEXT shader;
+            uint64_t    retireValue;
+        };
+
+        vk::Device m_device;
+        std::unique_ptr<Commands> m_commands;
+        std::vector<vk::DescriptorSetLayout> m_setLayouts;
+        std::vector<vk::PushConstantRange>   m_pushConstantRanges;
+
+        VkShaderEXT m_vertex = VK_NULL_HANDLE;
+        VkShaderEXT m_fragment = VK_NULL_HANDLE;
+        std::vector<Retired> m_retired;
+        uint64_t m_generation = 0;
+    };
+
+} // namespace Renderer
+
+#endif //SHADEROBJECTS_H
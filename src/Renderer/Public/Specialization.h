@@ -0,0 +1,98 @@
+//
+// Created by charlie on 8/7/25.
+//
+
+#ifndef SPECIALIZATION_H
+#define SPECIALIZATION_H
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include "IShaderCompiler.h"
+#include "SpirvReflection.h"
+#include "PipelineCache.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Renderer {
+
+    // A set of specialization constant values, kept sorted by spec id so that
+    // equal sets hash and compare equal regardless of the order they were set in.
+    // Values are stored as they'll be read by the driver: bools as 32-bit VkBool32.
+    class SpecializationConstants {
+    public:
+        SpecializationConstants& set(uint32_t specId, uint32_t value) { return setRaw(specId, &value, sizeof(value)); }
+        SpecializationConstants& set(uint32_t specId, int32_t value)  { return setRaw(specId, &value, sizeof(value)); }
+        SpecializationConstants& set(uint32_t specId, float value)    { return setRaw(specId, &value, sizeof(value)); }
+        SpecializationConstants& set(uint32_t specId, uint64_t value) { return setRaw(specId, &value, sizeof(value)); }
+        SpecializationConstants& set(uint32_t specId, int64_t value)  { return setRaw(specId, &value, sizeof(value)); }
+        SpecializationConstants& set(uint32_t specId, double value)   { return setRaw(specId, &value, sizeof(value)); }
+        SpecializationConstants& set(uint32_t specId, bool value) {
+            VkBool32 flag = value ? VK_TRUE : VK_FALSE;
+            return setRaw(specId, &flag, sizeof(flag));
+        }
+
+        bool empty() const { return m_entries.empty(); }
+        uint64_t hash() const { return m_hash; }
+
+        // Read back a 32-bit value; returns false if specId isn't set or isn't 32 bits wide
+        bool get(uint32_t specId, uint32_t& value) const;
+
+        // Points into this object; only valid while it is alive and unmodified
+        vk::SpecializationInfo info() const {
+            return vk::SpecializationInfo(static_cast<uint32_t>(m_entries.size()), m_entries.data(),
+                                          m_data.size(), m_data.data());
+        }
+
+        // Check every value against the module's reflected spec constants (id exists, size matches)
+        bool validate(const ShaderLoader::ShaderReflection& reflection, std::string& error) const;
+
+        bool operator==(const SpecializationConstants& other) const {
+            return m_hash == other.m_hash && m_entries == other.m_entries && m_data == other.m_data;
+        }
+
+    private:
+        SpecializationConstants& setRaw(uint32_t specId, const void* value, size_t size);
+        void rehash();
+
+        std::vector<vk::SpecializationMapEntry> m_entries;
+        std::vector<uint8_t> m_data;
+        uint64_t m_hash = 0;
+    };
+
+    // Compute pipelines specialized from loaded modules, cached by
+    // (module content hash, pipeline layout, entry point, constant values).
+    // Lookups are lock-free (see PipelineCache); pipelines live until clear() or destruction.
+    class SpecializedPipelineCache {
+    public:
+        explicit SpecializedPipelineCache(vk::Device device, vk::PipelineCache pipelineCache = nullptr);
+
+        SpecializedPipelineCache(const SpecializedPipelineCache&) = delete;
+        SpecializedPipelineCache& operator=(const SpecializedPipelineCache&) = delete;
+
+        // throws std::runtime_error if pipeline creation fails
+        vk::Pipeline getComputePipeline(const ShaderLoader::ShaderModule& module, vk::PipelineLayout layout,
+                                        const SpecializationConstants& constants = {},
+                                        const std::string& entryPoint = "main");
+
+        // Generic form for graphics pipelines: the caller folds every shader hash and
+        // constant set into key and create() builds the pipeline on a miss
+        vk::Pipeline getOrCreate(uint64_t key, const std::function<vk::Pipeline()>& create);
+
+        size_t size() const { return m_pipelines.size(); }
+        size_t hits() const { return m_pipelines.hits(); }
+        size_t misses() const { return m_pipelines.misses(); }
+
+        // Destroy every cached pipeline; the device must not be using them and no lookup may run meanwhile
+        void clear() { m_pipelines.clear(); }
+
+    private:
+        vk::Device m_device;
+        vk::PipelineCache m_pipelineCache;
+        PipelineCache m_pipelines;
+    };
+
+} // namespace Renderer
+
+#endif //SPECIALIZATION_H
@@ -0,0 +1,70 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#ifndef STAGINGRING_H
+#define STAGINGRING_H
+#pragma once
+
+#include "Buffer.h"
+#include <cstdint>
+#include <deque>
+
+namespace Renderer {
+
+    // A persistently mapped host-visible buffer handed out front to back as a ring.
+    //
+    // Allocations are grouped into batches: close() ends the current batch and returns its id,
+    // and once the GPU work reading or writing those regions has completed (fence, timeline value, ...)
+    // retire(id) gives the batch and every older one back. Batches retire in order, so the free
+    // space is always one contiguous run after the head and allocation is a pointer bump.
+    class StagingRing {
+    public:
+        struct Region {
+            vk::Buffer     buffer;
+            vk::DeviceSize offset = 0;
+            vk::DeviceSize size = 0;
+            void*          data = nullptr;
+        };
+
+        // throws std::runtime_error if the buffer can't be created
+        StagingRing(vk::PhysicalDevice physicalDevice, vk::Device device, vk::DeviceSize capacity,
+                    vk::BufferUsageFlags usage = vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst);
+        ~StagingRing();
+
+        StagingRing(const StagingRing&) = delete;
+        StagingRing& operator=(const StagingRing&) = delete;
+
+        // returns false if there is no room until older batches retire
+        bool allocate(vk::DeviceSize size, vk::DeviceSize alignment, Region& region);
+
+        // End the current batch; returns the id to pass to retire() once the GPU is done with it
+        uint64_t close();
+
+        // Release every closed batch with an id <= batchId
+        void retire(uint64_t batchId);
+
+        vk::Buffer buffer() const { return m_buffer.buffer; }
+        vk::DeviceSize capacity() const { return m_buffer.size; }
+        vk::DeviceSize used() const { return m_used; }
+        bool hasPendingBatches() const { return !m_batches.empty(); }
+        uint64_t oldestPendingBatch() const { return m_batches.empty() ? 0 : m_batches.front().id; }
+
+    private:
+        struct Batch {
+            uint64_t       id;
+            vk::DeviceSize bytes;
+        };
+
+        vk::Device     m_device;
+        Buffer         m_buffer;
+        vk::DeviceSize m_head = 0;
+        vk::DeviceSize m_used = 0;       // bytes owned by open or closed batches, padding included
+        vk::DeviceSize m_openBytes = 0;
+        uint64_t       m_nextBatch = 1;
+        std::deque<Batch> m_batches;
+    };
+
+} // namespace Renderer
+
+#endif //STAGINGRING_H
@@ -0,0 +1,100 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#ifndef SWAPCHAINMANAGER_H
+#define SWAPCHAINMANAGER_H
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+namespace Renderer {
+
+    struct SwapchainConfig {
+        vk::SurfaceFormatKHR preferredFormat{vk::Format::eB8G8R8A8Srgb, vk::ColorSpaceKHR::eSrgbNonlinear};
+        vk::PresentModeKHR   preferredPresentMode = vk::PresentModeKHR::eMailbox;   // FIFO when unavailable
+        vk::ImageUsageFlags  usage = vk::ImageUsageFlagBits::eColorAttachment;
+    };
+
+    // Owns the swapchain and everything sized by it: image views, optional framebuffers and
+    // one present semaphore per image.
+    //
+    // recreate() builds the new swapchain with the current one as oldSwapchain, so the
+    // presentation engine can hand over without a gap, and moves the old swapchain and its
+    // per-image objects to a retired list instead of destroying them. They are destroyed by
+    // collect() once the caller's timeline passes the value given at retirement, i.e. once
+    // the first frame rendered to the new swapchain has completed. Nothing waits for the device.
+    class SwapchainManager {
+    public:
+        using FramebufferFactory = std::function<vk::Framebuffer(vk::ImageView view, vk::Extent2D extent)>;
+
+        // Creates the first swapchain; windowExtent is used when the surface leaves the size to us
+        // throws std::runtime_error on failure
+        SwapchainManager(vk::PhysicalDevice physicalDevice, vk::Device device, vk::SurfaceKHR surface,
+                         vk::Extent2D windowExtent, const SwapchainConfig& config = {});
+        // The device must be idle
+        ~SwapchainManager();
+
+        SwapchainManager(const SwapchainManager&) = delete;
+        SwapchainManager& operator=(const SwapchainManager&) = delete;
+
+        // Build one framebuffer per image now and after every recreate(); unset means none
+        void setFramebufferFactory(FramebufferFactory factory);
+
+        // Replace the swapchain. The old one is destroyed by collect() once the caller's
+        // timeline reaches retireValue, which should be the next frame's signal value.
+        void recreate(vk::Extent2D windowExtent, uint64_t retireValue);
+
+        // Destroy retired swapchains whose value the timeline has reached
+        void collect(uint64_t completedValue);
+
+        vk::SwapchainKHR handle() const { return m_current.swapchain; }
+        vk::Format format() const { return m_format.format; }
+        vk::Extent2D extent() const { return m_extent; }
+        uint32_t imageCount() const { return static_cast<uint32_t>(m_images.size()); }
+        vk::Image image(uint32_t index) const { return m_images[index]; }
+        vk::ImageView imageView(uint32_t index) const { return m_current.views[index]; }
+        vk::Framebuffer framebuffer(uint32_t index) const { return m_current.framebuffers[index]; }
+        const std::vector<vk::Framebuffer>& framebuffers() const { return m_current.framebuffers; }
+
+        // Signalled by the frame rendering to image index, waited on by its present
+        vk::Semaphore presentSemaphore(uint32_t index) const { return m_current.presentSemaphores[index]; }
+
+        // Bumped by every recreate()
+        uint64_t generation() const { return m_generation; }
+        size_t retiredCount() const { return m_retired.size(); }
+
+    private:
+        struct Generation {
+            vk::SwapchainKHR             swapchain;
+            std::vector<vk::ImageView>   views;
+            std::vector<vk::Framebuffer> framebuffers;
+            std::vector<vk::Semaphore>   presentSemaphores;
+            uint64_t                     retireValue = 0;
+        };
+
+        void create(vk::Extent2D windowExtent, vk::SwapchainKHR oldSwapchain);
+        void createFramebuffers();
+        void destroy(Generation& generation);
+
+        vk::PhysicalDevice   m_physicalDevice;
+        vk::Device           m_device;
+        vk::SurfaceKHR       m_surface;
+        SwapchainConfig      m_config;
+        FramebufferFactory   m_framebufferFactory;
+
+        vk::SurfaceFormatKHR m_format;
+        vk::Extent2D         m_extent;
+        std::vector<vk::Image> m_images;
+        Generation           m_current;
+        std::deque<Generation> m_retired;
+        uint64_t             m_generation = 0;
+    };
+
+} // namespace Renderer
+
+#endif //SWAPCHAINMANAGER_H
@@ -0,0 +1,50 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#ifndef TIMELINESEMAPHORE_H
+#define TIMELINESEMAPHORE_H
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+
+namespace Renderer {
+
+    // A Vulkan 1.2 timeline semaphore plus the last value handed out for signaling.
+    // Values only grow, so "is submission N done" is one comparison against the counter.
+    // Reserving values (next()) must happen on the submitting thread; queries are thread-safe.
+    class TimelineSemaphore {
+    public:
+        // Requires the timelineSemaphore device feature; throws on creation failure
+        explicit TimelineSemaphore(vk::Device device, uint64_t initialValue = 0);
+        ~TimelineSemaphore();
+
+        TimelineSemaphore(const TimelineSemaphore&) = delete;
+        TimelineSemaphore& operator=(const TimelineSemaphore&) = delete;
+
+        vk::Semaphore handle() const { return m_semaphore; }
+
+        // Reserve the value the next submission signals
+        uint64_t next() { return ++m_lastReserved; }
+        uint64_t lastReserved() const { return m_lastReserved; }
+
+        // Current counter value on the device
+        uint64_t completed() const;
+        bool isComplete(uint64_t value) const { return value <= completed(); }
+
+        // returns false on timeout
+        bool wait(uint64_t value, uint64_t timeoutNs = UINT64_MAX) const;
+
+        // Signal from the host, e.g. to release work queued behind a value
+        void signal(uint64_t value);
+
+    private:
+        vk::Device    m_device;
+        vk::Semaphore m_semaphore;
+        uint64_t      m_lastReserved;
+    };
+
+} // namespace Renderer
+
+#endif //TIMELINESEMAPHORE_H
@@ -0,0 +1,84 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#ifndef TLSFALLOCATOR_H
+#define TLSFALLOCATOR_H
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Renderer {
+
+    // Two-level segregated fit allocator over an abstract range [0, size).
+    //
+    // It never touches the memory it manages, so bookkeeping lives in a side table of nodes
+    // and GPU memory blocks can be carved up without being mapped. Free ranges are binned
+    // by size class (power of two, then 32 linear steps); two bitmaps find the first
+    // non-empty bin that fits in O(1), and freed ranges merge with free neighbours at once.
+    class TlsfAllocator {
+    public:
+        static constexpr uint32_t kInvalidNode = UINT32_MAX;
+
+        struct Range {
+            uint64_t offset = 0;
+            uint64_t size = 0;
+            uint32_t node = kInvalidNode;   // pass to free()
+        };
+
+        explicit TlsfAllocator(uint64_t size);
+
+        // returns false if no free range can hold size bytes at the alignment
+        bool allocate(uint64_t size, uint64_t alignment, Range& range);
+        void free(uint32_t node);
+
+        uint64_t size() const { return m_size; }
+        uint64_t freeBytes() const { return m_freeBytes; }
+        uint32_t allocationCount() const { return m_allocationCount; }
+        bool empty() const { return m_allocationCount == 0; }
+
+        // Size of the largest free range, for fragmentation reporting
+        uint64_t largestFreeRange() const;
+
+        // Allocated ranges in address order
+        std::vector<Range> allocations() const;
+
+    private:
+        static constexpr uint32_t kSecondLevelBits = 5;
+        static constexpr uint32_t kSecondLevelCount = 1u << kSecondLevelBits;
+        static constexpr uint32_t kFirstLevelCount = 64 - kSecondLevelBits + 1;
+
+        struct Node {
+            uint64_t offset = 0;
+            uint64_t size = 0;
+            uint32_t prevPhysical = kInvalidNode;
+            uint32_t nextPhysical = kInvalidNode;
+            uint32_t prevFree = kInvalidNode;
+            uint32_t nextFree = kInvalidNode;
+            bool     isFree = false;
+        };
+
+        static void mapping(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel);
+        uint32_t findFreeNode(uint64_t size) const;
+        uint32_t newNode();
+        void releaseNode(uint32_t node);
+        void insertFree(uint32_t node);
+        void removeFree(uint32_t node);
+        // Cut the first size bytes of node off into a new node placed before it; returns the new node
+        uint32_t splitFront(uint32_t node, uint64_t size);
+
+        uint64_t m_size;
+        uint64_t m_freeBytes;
+        uint32_t m_allocationCount = 0;
+        uint64_t m_firstLevelBitmap = 0;
+        uint32_t m_secondLevelBitmaps[kFirstLevelCount] = {};
+        uint32_t m_heads[kFirstLevelCount][kSecondLevelCount];
+        std::vector<Node>     m_nodes;
+        std::vector<uint32_t> m_unusedNodes;
+        uint32_t m_firstPhysical = kInvalidNode;
+    };
+
+} // namespace Renderer
+
+#endif //TLSFALLOCATOR_H
@@ -0,0 +1,64 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#ifndef UNIFORMRING_H
+#define UNIFORMRING_H
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include "GpuAllocator.h"
+#include <cstdint>
+#include <vector>
+
+namespace Renderer {
+
+    // Per-frame uniform blocks in one persistently mapped buffer, read through a single
+    // vk::DescriptorType::eUniformBufferDynamic descriptor that is written once.
+    //
+    // The buffer holds one region per frame slot. begin(slot) rewinds that region and push()
+    // copies a block in and returns the dynamic offset to bind it at, so per-draw parameters
+    // cost a memcpy and an offset: no descriptor writes, no allocation. A region is only
+    // rewritten after the frame pacer has waited for the frame that last used the slot.
+    //
+    // The first push() of a frame always lands at slotOffset(slot), so command buffers
+    // recorded once per slot can keep binding that offset and still see each frame's globals.
+    class UniformRing {
+    public:
+        // blockRange is the descriptor's range and the largest block push() accepts
+        // throws std::runtime_error if the buffer can't be created
+        UniformRing(vk::PhysicalDevice physicalDevice, GpuAllocator& allocator, uint32_t framesInFlight,
+                    vk::DeviceSize bytesPerFrame = vk::DeviceSize{64} << 10, vk::DeviceSize blockRange = 256);
+        ~UniformRing();
+
+        UniformRing(const UniformRing&) = delete;
+        UniformRing& operator=(const UniformRing&) = delete;
+
+        void begin(uint32_t frameSlot);
+
+        // throws std::runtime_error if size exceeds blockRange or the slot's region is full
+        uint32_t push(const void* data, vk::DeviceSize size);
+
+        template<typename T>
+        uint32_t push(const T& value) { return push(&value, sizeof(T)); }
+
+        uint32_t slotOffset(uint32_t frameSlot) const { return static_cast<uint32_t>(m_regionSize * (frameSlot % m_frameCount)); }
+
+        // For the dynamic uniform buffer descriptor
+        vk::DescriptorBufferInfo descriptorInfo() const { return {m_buffer.buffer, 0, m_blockRange}; }
+        vk::DeviceSize usedBytes() const { return m_head - m_regionStart; }
+
+    private:
+        GpuAllocator&   m_allocator;
+        AllocatedBuffer m_buffer;
+        vk::DeviceSize  m_alignment;
+        vk::DeviceSize  m_blockRange;
+        vk::DeviceSize  m_regionSize;
+        uint32_t        m_frameCount;
+        vk::DeviceSize  m_regionStart = 0;
+        vk::DeviceSize  m_head = 0;
+    };
+
+} // namespace Renderer
+
+#endif //UNIFORMRING_H
@@ -0,0 +1,101 @@
+//
+// Created by charlie on 8/9/25.
+//
+
+#ifndef UPLOADQUEUE_H
+#define UPLOADQUEUE_H
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include "StagingRing.h"
+#include "TimelineSemaphore.h"
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace Renderer {
+
+    // Streams data into device-local buffers through a persistently mapped staging ring.
+    //
+    // upload() is a memcpy into the ring plus a queued copy region; flush() records every
+    // queued copy into one command buffer and submits it with a single vkQueueSubmit, on the
+    // transfer-only queue when the device has one. Uploads that overwrite each other land in
+    // upload order. Each submission carries a fence, and
+    // collect() reclaims the ring space and command buffers of submissions whose fence has
+    // signalled, so meshes stream in without the frame ever waiting on them. The host only
+    // blocks when the ring is full.
+    //
+    // Every flush also signals a timeline semaphore with its ticket: graphics submissions wait
+    // on (semaphore(), ticket) at the vertex input stage before drawing from the data.
+    // Destination buffers used on another queue family need vk::SharingMode::eConcurrent.
+    // Not thread-safe.
+    class UploadQueue {
+    public:
+        // throws std::runtime_error if the staging ring can't be created
+        UploadQueue(vk::PhysicalDevice physicalDevice, vk::Device device, vk::Queue queue, uint32_t queueFamily,
+                    vk::DeviceSize stagingSize = vk::DeviceSize{32} << 20);
+        // Waits for submissions still in flight
+        ~UploadQueue();
+
+        UploadQueue(const UploadQueue&) = delete;
+        UploadQueue& operator=(const UploadQueue&) = delete;
+
+        // Queue size bytes for destination at offset. Uploads larger than the ring are split
+        // into chunks; when the ring is full this flushes and waits for the oldest submission.
+        void upload(vk::Buffer destination, vk::DeviceSize offset, const void* data, vk::DeviceSize size);
+
+        template<typename T>
+        void upload(vk::Buffer destination, const std::vector<T>& data, vk::DeviceSize offset = 0) {
+            upload(destination, offset, data.data(), data.size() * sizeof(T));
+        }
+
+        // Submit everything queued since the last flush; returns the ticket the data is
+        // ready at (the previous ticket when nothing was queued)
+        uint64_t flush();
+
+        // Reclaim finished submissions; never blocks, call once a frame
+        void collect();
+
+        vk::Semaphore semaphore() const { return m_timeline.handle(); }
+        uint64_t lastTicket() const { return m_timeline.lastReserved(); }
+        bool isComplete(uint64_t ticket) const { return m_timeline.isComplete(ticket); }
+        void wait(uint64_t ticket);
+
+        vk::DeviceSize bytesUploaded() const { return m_bytesUploaded; }
+        uint64_t submissions() const { return m_submissionCount; }
+
+    private:
+        struct Copy {
+            vk::Buffer     destination;
+            vk::BufferCopy region;
+        };
+
+        struct Submission {
+            vk::CommandBuffer commandBuffer;
+            vk::Fence         fence;
+            uint64_t          stagingBatch = 0;
+            uint64_t          ticket = 0;
+        };
+
+        Submission acquireSubmission();
+        void retire(Submission& submission);
+        void waitOldest();
+
+        vk::Device        m_device;
+        vk::Queue         m_queue;
+        StagingRing       m_staging;
+        vk::DeviceSize    m_chunkSize;
+        vk::CommandPool   m_commandPool;
+        TimelineSemaphore m_timeline;
+
+        std::vector<Copy>       m_copies;
+        std::deque<Submission> m_inFlight;
+        std::vector<Submission> m_idle;
+        vk::DeviceSize          m_bytesUploaded = 0;
+        uint64_t                m_submissionCount = 0;
+    };
+
+} // namespace Renderer
+
+#endif //UPLOADQUEUE_H
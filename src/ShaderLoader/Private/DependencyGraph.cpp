@@ -0,0 +1,220 @@
+//
+// Created by charlie on 8/4/25.
+//
+
+#include "../Public/DependencyGraph.h"
+#include "../Public/ContentHash.h"
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace ShaderLoader {
+
+    namespace {
+        namespace fs = std::filesystem;
+
+        bool hashFile(const std::string& path, uint64_t& hash) {
+            std::ifstream file(path, std::ios::binary);
+            if (!file) {
+                return false;
+            }
+            std::ostringstream ss;
+            ss << file.rdbuf();
+            auto contents = ss.str();
+            hash = hashBytes(contents.data(), contents.size());
+            return true;
+        }
+
+        // The whole of text as a number; false on anything else, including overflow
+        template <typename T>
+        bool parseNumber(const std::string& text, T& value, int base = 10) {
+            const char* end = text.data() + text.size();
+            auto [ptr, ec] = std::from_chars(text.data(), end, value, base);
+            return ec == std::errc() && ptr == end && !text.empty();
+        }
+    }
+
+    bool DependencyGraph::stampFile(const std::string& path, FileStamp& stamp) {
+        std::error_code ec;
+        auto mtime = fs::last_write_time(path, ec);
+        if (ec) {
+            return false;
+        }
+        auto size = fs::file_size(path, ec);
+        if (ec) {
+            return false;
+        }
+        stamp.mtime = mtime.time_since_epoch().count();
+        stamp.size = size;
+        return hashFile(path, stamp.hash);
+    }
+
+    void DependencyGraph::record(const std::string& source, const std::vector<std::string>& includes) {
+        remove(source);
+
+        m_sources[source] = includes;
+        m_dependents[source].insert(source);
+        for (const auto& include : includes) {
+            m_dependents[include].insert(source);
+        }
+
+        FileStamp stamp;
+        if (stampFile(source, stamp)) {
+            m_stamps[source] = stamp;
+        }
+        for (const auto& include : includes) {
+            if (stampFile(include, stamp)) {
+                m_stamps[include] = stamp;
+            }
+        }
+    }
+
+    void DependencyGraph::remove(const std::string& source) {
+        auto it = m_sources.find(source);
+        if (it == m_sources.end()) {
+            return;
+        }
+
+        auto release = [&](const std::string& file) {
+            auto dep = m_dependents.find(file);
+            if (dep == m_dependents.end()) {
+                return;
+            }
+            dep->second.erase(source);
+            if (dep->second.empty()) {
+                m_dependents.erase(dep);
+                m_stamps.erase(file);
+            }
+        };
+
+        release(source);
+        for (const auto& include : it->second) {
+            release(include);
+        }
+        m_sources.erase(it);
+    }
+
+    void DependencyGraph::clear() {
+        m_sources.clear();
+        m_dependents.clear();
+        m_stamps.clear();
+    }
+
+    bool DependencyGraph::fileChanged(const std::string& path) const {
+        auto it = m_stamps.find(path);
+        if (it == m_stamps.end()) {
+            return true;
+        }
+
+        std::error_code ec;
+        auto mtime = fs::last_write_time(path, ec);
+        if (ec) {
+            return true;
+        }
+        auto size = fs::file_size(path, ec);
+        if (ec) {
+            return true;
+        }
+        if (mtime.time_since_epoch().count() == it->second.mtime && size == it->second.size) {
+            return false;
+        }
+
+        uint64_t hash = 0;
+        return !hashFile(path, hash) || hash != it->second.hash;
+    }
+
+    std::vector<std::string> DependencyGraph::dirtySources() const {
+        std::set<std::string> dirty;
+        for (const auto& [file, sources] : m_dependents) {
+            if (fileChanged(file)) {
+                dirty.insert(sources.begin(), sources.end());
+            }
+        }
+        return {dirty.begin(), dirty.end()};
+    }
+
+    std::vector<std::string> DependencyGraph::dependents(const std::string& file) const {
+        std::error_code ec;
+        auto canonical = fs::weakly_canonical(file, ec).string();
+        for (const auto& key : {file, canonical}) {
+            auto it = m_dependents.find(key);
+            if (it != m_dependents.end()) {
+                return {it->second.begin(), it->second.end()};
+            }
+        }
+        return {};
+    }
+
+    // Tab-separated text, one record per line:
+    //   S <source>                      compiled source
+    //   I <source> <include>            include of the preceding source
+    //   F <file> <mtime> <size> <hash>  file stamp
+    bool DependencyGraph::save(const std::string& path) const {
+        auto tempPath = path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::trunc);
+            if (!file) {
+                return false;
+            }
+            for (const auto& [source, includes] : m_sources) {
+                file << "S\t" << source << "\n";
+                for (const auto& include : includes) {
+                    file << "I\t" << source << "\t" << include << "\n";
+                }
+            }
+            for (const auto& [name, stamp] : m_stamps) {
+                file << "F\t" << name << "\t" << stamp.mtime << "\t" << stamp.size << "\t" << toHex(stamp.hash) << "\n";
+            }
+            if (!file) {
+                return false;
+            }
+        }
+        std::error_code ec;
+        fs::rename(tempPath, path, ec);
+        return !ec;
+    }
+
+    bool DependencyGraph::load(const std::string& path) {
+        std::ifstream file(path);
+        if (!file) {
+            return false;
+        }
+
+        clear();
+
+        // A corrupt file leaves the graph empty, so every shader is treated as untracked
+        std::string line;
+        while (std::getline(file, line)) {
+            std::vector<std::string> fields;
+            std::istringstream ss(line);
+            for (std::string field; std::getline(ss, field, '\t');) {
+                fields.push_back(field);
+            }
+            if (fields.empty()) {
+                continue;
+            }
+
+            if (fields[0] == "S" && fields.size() == 2) {
+                m_sources[fields[1]];
+                m_dependents[fields[1]].insert(fields[1]);
+            } else if (fields[0] == "I" && fields.size() == 3) {
+                m_sources[fields[1]].push_back(fields[2]);
+                m_dependents[fields[2]].insert(fields[1]);
+            } else if (fields[0] == "F" && fields.size() == 5) {
+                FileStamp stamp;
+                if (!parseNumber(fields[2], stamp.mtime) || !parseNumber(fields[3], stamp.size) ||
+                    !parseNumber(fields[4], stamp.hash, 16)) {
+                    clear();
+                    return false;
+                }
+                m_stamps[fields[1]] = stamp;
+            } else {
+                clear();
+                return false;
+            }
+        }
+        return true;
+    }
+
+} // namespace ShaderLoader
@@ -0,0 +1,246 @@
+//
+// Created by charlie on 8/2/25.
+//
+
+#include "../Public/ShaderCache.h"
+#include "../Public/ContentHash.h"
+#include "../Public/ShaderPreprocessor.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ShaderLoader {
+
+    namespace {
+
+        namespace fs = std::filesystem;
+
+        constexpr uint32_t kEntryMagic = 0x31434C53; // "SLC1"
+        constexpr const char* kEntryExtension = ".spvc";
+
+        struct EntryHeader {
+            uint32_t magic;
+            uint32_t wordCount;
+            uint64_t key;
+        };
+
+    } // namespace
+
+    ShaderCache::ShaderCache(ShaderCacheConfig config)
+        : m_config(std::move(config))
+    {
+        std::error_code ec;
+        fs::create_directories(m_config.directory, ec);
+        for (const auto& entry : fs::directory_iterator(m_config.directory, ec)) {
+            if (entry.path().extension() == kEntryExtension) {
+                m_totalSize += entry.file_size(ec);
+            }
+        }
+    }
+
+    std::string ShaderCache::entryPath(uint64_t key) const {
+        return (fs::path(m_config.directory) / (toHex(key) + kEntryExtension)).string();
+    }
+
+    std::optional<std::vector<uint32_t>> ShaderCache::load(uint64_t key) {
+        auto path = entryPath(key);
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            ++m_misses;
+            return std::nullopt;
+        }
+
+        struct stat info{};
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(EntryHeader)) {
+            close(fd);
+            ++m_misses;
+            return std::nullopt;
+        }
+
+        size_t size = static_cast<size_t>(info.st_size);
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            ++m_misses;
+            return std::nullopt;
+        }
+
+        EntryHeader header;
+        memcpy(&header, mapped, sizeof(header));
+        bool valid = header.magic == kEntryMagic && header.key == key &&
+                     size == sizeof(EntryHeader) + static_cast<size_t>(header.wordCount) * sizeof(uint32_t);
+
+        std::vector<uint32_t> spirv;
+        if (valid) {
+            spirv.resize(header.wordCount);
+            memcpy(spirv.data(), static_cast<const char*>(mapped) + sizeof(EntryHeader), header.wordCount * sizeof(uint32_t));
+        }
+        munmap(mapped, size);
+
+        if (!valid) {
+            // Corrupt or foreign entry: drop it so the next compile replaces it
+            std::error_code ec;
+            fs::remove(path, ec);
+            ++m_misses;
+            return std::nullopt;
+        }
+
+        // Refresh mtime so pruning sees this entry as recently used
+        std::error_code ec;
+        fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+        ++m_hits;
+        return spirv;
+    }
+
+    bool ShaderCache::store(uint64_t key, const std::vector<uint32_t>& spirv) {
+        uint64_t entrySize = sizeof(EntryHeader) + spirv.size() * sizeof(uint32_t);
+        if (spirv.empty() || entrySize > m_config.maxSizeBytes) {
+            return false;
+        }
+
+        static std::atomic<uint32_t> counter{0};
+        auto finalPath = entryPath(key);
+        auto tempPath = finalPath + ".tmp." + std::to_string(getpid()) + "." + std::to_string(counter++);
+
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file) {
+                return false;
+            }
+            EntryHeader header{kEntryMagic, static_cast<uint32_t>(spirv.size()), key};
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(spirv.data()), spirv.size() * sizeof(uint32_t));
+            if (!file) {
+                file.close();
+                std::error_code ec;
+                fs::remove(tempPath, ec);
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        bool replaced = fs::exists(finalPath, ec);
+        fs::rename(tempPath, finalPath, ec);
+        if (ec) {
+            fs::remove(tempPath, ec);
+            return false;
+        }
+
+        bool overLimit;
+        {
+            std::lock_guard lock(m_sizeMutex);
+            if (!replaced) {
+                m_totalSize += entrySize;
+            }
+            overLimit = m_totalSize > m_config.maxSizeBytes;
+        }
+        if (overLimit) {
+            prune();
+        }
+        return true;
+    }
+
+    void ShaderCache::prune() {
+        struct Entry {
+            fs::path            path;
+            fs::file_time_type  lastUse;
+            uint64_t            size;
+        };
+
+        std::lock_guard lock(m_sizeMutex);
+
+        std::error_code ec;
+        std::vector<Entry> entries;
+        uint64_t total = 0;
+        for (const auto& entry : fs::directory_iterator(m_config.directory, ec)) {
+            if (entry.path().extension() != kEntryExtension) {
+                continue;
+            }
+            Entry e{entry.path(), entry.last_write_time(ec), entry.file_size(ec)};
+            total += e.size;
+            entries.push_back(std::move(e));
+        }
+
+        // Prune to 90% of the limit so a full cache doesn't rescan on every store
+        uint64_t target = m_config.maxSizeBytes / 10 * 9;
+        if (total > m_config.maxSizeBytes) {
+            std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+                return a.lastUse < b.lastUse;
+            });
+            for (const auto& entry : entries) {
+                if (total <= target) {
+                    break;
+                }
+                if (fs::remove(entry.path, ec)) {
+                    total -= entry.size;
+                }
+            }
+        }
+        m_totalSize = total;
+    }
+
+    uint64_t computeCompileKey(const std::string& expandedSource, const std::string& path,
+                               const CompileOptions& options, const std::string& compilerVersion) {
+        ContentHasher hasher;
+        hasher.update(expandedSource);
+        hasher.update(fs::path(path).extension().string());
+        hasher.updateValue(static_cast<uint32_t>(options.language));
+        hasher.updateValue(static_cast<uint64_t>(options.defines.size()));
+        for (const auto& define : options.defines) {
+            hasher.update(define.name);
+            hasher.update(define.value);
+        }
+        hasher.update(options.targetEnv);
+        hasher.updateValue(options.optimize);
+        hasher.updateValue(options.debugInfo);
+        hasher.update(compilerVersion);
+        return hasher.digest();
+    }
+
+    CachingShaderCompiler::CachingShaderCompiler(std::unique_ptr<IShaderCompiler> compiler, ShaderCacheConfig config)
+        : m_compiler(std::move(compiler))
+        , m_cache(std::move(config))
+    {}
+
+    ShaderModule CachingShaderCompiler::loadSpirvFromFile(const std::string& path) {
+        return m_compiler->loadSpirvFromFile(path);
+    }
+
+    ShaderModule CachingShaderCompiler::compileFromFile(const std::string& path, const CompileOptions& options) {
+        auto source = expandIncludes(path, options.includeDirs);
+        if (!source.success) {
+            // Let the real compiler produce the diagnostic
+            return m_compiler->compileFromFile(path, options);
+        }
+
+        uint64_t key = computeCompileKey(source.text, path, options, m_compiler->version());
+        if (auto cached = m_cache.load(key)) {
+            size_t words = cached->size();
+            return {std::move(*cached), "Loaded cached shader: " + path + " (" + std::to_string(words) + " words, key " + toHex(key) + ")",
+                    std::move(source.includes)};
+        }
+
+        auto module = m_compiler->compileFromFile(path, options);
+        module.dependencies = std::move(source.includes);
+        if (!module.spirv.empty() && !m_cache.store(key, module.spirv)) {
+            module.infoLog += "\nWarning: failed to write shader cache entry for: " + path;
+        }
+        return module;
+    }
+
+    std::string CachingShaderCompiler::version() const {
+        return m_compiler->version();
+    }
+
+    std::unique_ptr<IShaderCompiler> createCachingCompiler(std::unique_ptr<IShaderCompiler> compiler,
+                                                           ShaderCacheConfig config) {
+        return std::make_unique<CachingShaderCompiler>(std::move(compiler), std::move(config));
+    }
+
+} // namespace ShaderLoader
@@ -3,13 +3,52 @@
 //
 
 #include "../Public/IShaderCompiler.h"
+#include "../Public/ShaderPreprocessor.h"
 #include <memory>
 #include <fstream>
 #include <iostream>
 #include <cstring>
+#include <cstdio>
+#include <atomic>
+#include <mutex>
+#include <filesystem>
+#include <unistd.h>
 
 namespace ShaderLoader {
 
+    namespace {
+
+        // Quote an argument for /bin/sh
+        std::string shellQuote(const std::string& arg) {
+            std::string quoted = "'";
+            for (char c : arg) {
+                if (c == '\'') {
+                    quoted += "'\\''";
+                } else {
+                    quoted += c;
+                }
+            }
+            quoted += "'";
+            return quoted;
+        }
+
+        // Run a command and capture its stdout and stderr
+        int runCommand(const std::string& command, std::string& output) {
+            FILE* pipe = popen((command + " 2>&1").c_str(), "r");
+            if (!pipe) {
+                output = "Failed to run: " + command;
+                return -1;
+            }
+            char chunk[4096];
+            size_t n;
+            while ((n = fread(chunk, 1, sizeof(chunk), pipe)) > 0) {
+                output.append(chunk, n);
+            }
+            return pclose(pipe);
+        }
+
+    } // namespace
+
     class ShaderCompiler : public IShaderCompiler {
     public:
         ShaderModule loadSpirvFromFile(const std::string& path) override {
@@ -93,6 +132,66 @@ namespace ShaderLoader {
 
             return {std::move(spirvData), "Successfully loaded shader: " + path};
         }
+
+        // Compile GLSL by invoking glslc, the same tool the shader workflow uses by hand
+        ShaderModule compileFromFile(const std::string& path, const CompileOptions& options) override {
+            if (options.language != ShaderLanguage::GLSL) {
+                return {.spirv = {}, .infoLog = "Only GLSL compilation is supported: " + path};
+            }
+
+            static std::atomic<uint32_t> counter{0};
+            auto outputPath = std::filesystem::temp_directory_path() /
+                ("shaderloader-" + std::to_string(getpid()) + "-" + std::to_string(counter++) + ".spv");
+
+            std::string command = "glslc";
+            command += options.optimize ? " -O" : " -O0";
+            if (options.debugInfo) {
+                command += " -g";
+            }
+            command += " --target-env=" + shellQuote(options.targetEnv);
+            for (const auto& define : options.defines) {
+                command += " -D" + shellQuote(define.value.empty() ? define.name : define.name + "=" + define.value);
+            }
+            for (const auto& dir : options.includeDirs) {
+                command += " -I " + shellQuote(dir);
+            }
+            command += " " + shellQuote(path) + " -o " + shellQuote(outputPath.string());
+
+            std::string output;
+            int status = runCommand(command, output);
+            if (status != 0) {
+                std::filesystem::remove(outputPath);
+                return {.spirv = {}, .infoLog = "Failed to compile shader: " + path + "\n" + output};
+            }
+
+            auto module = loadSpirvFromFile(outputPath.string());
+            std::filesystem::remove(outputPath);
+            if (module.spirv.empty()) {
+                return module;
+            }
+
+            module.dependencies = expandIncludes(path, options.includeDirs).includes;
+            module.infoLog = "Successfully compiled shader: " + path +
+                " (" + std::to_string(module.spirv.size()) + " words)";
+            if (!output.empty()) {
+                module.infoLog += "\n" + output;
+            }
+            return module;
+        }
+
+        std::string version() const override {
+            std::call_once(m_versionOnce, [this] {
+                std::string output;
+                if (runCommand("glslc --version", output) == 0) {
+                    m_version = output;
+                }
+            });
+            return m_version;
+        }
+
+    private:
+        mutable std::once_flag m_versionOnce;
+        mutable std::string    m_version;
     };
 
     // Factory function to get the default compiler
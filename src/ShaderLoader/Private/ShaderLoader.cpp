@@ -3,6 +3,10 @@
 //
 
 #include "../Public/ShaderLoader.h"
+#include "../Public/ContentHash.h"
+#include "../Public/SpirvStrip.h"
+#include "../Public/VariantCompiler.h"
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 
@@ -12,6 +16,10 @@ namespace ShaderLoader {
         : m_compiler(std::move(compiler))
     {}
 
+    ShaderLoader::~ShaderLoader() {
+        saveDependencies();
+    }
+
     bool ShaderLoader::loadShader(const std::string& path) {
         // Load SPIR-V directly from file
         auto module = m_compiler->loadSpirvFromFile(path);
@@ -22,14 +30,158 @@ namespace ShaderLoader {
             return false;
         }
 
+        prepareModule(module);
         std::cout << module.infoLog << std::endl; // Success message
+        trackDependencies(path, {});
         m_modules[path] = std::move(module);
         return true;
     }
 
+    bool ShaderLoader::compileShader(const std::string& path, const CompileOptions& options) {
+        auto module = m_compiler->compileFromFile(path, options);
+
+        if (module.spirv.empty()) {
+            std::cout << "Failed to compile shader: " << module.infoLog << std::endl;
+            return false;
+        }
+
+        prepareModule(module);
+        std::cout << module.infoLog << std::endl;
+        trackDependencies(path, module.dependencies);
+        m_compileOptions[path] = options;
+        m_modules[path] = std::move(module);
+        return true;
+    }
+
+    bool ShaderLoader::loadVariants(const std::string& directory) {
+        auto indexPath = std::filesystem::path(directory) / kVariantIndexFile;
+        std::ifstream index(indexPath);
+        if (!index) {
+            std::cout << "Failed to open variant index: " << indexPath.string() << std::endl;
+            return false;
+        }
+
+        std::string line, source;
+        if (!std::getline(index, line) || line.rfind("source ", 0) != 0) {
+            std::cout << "Invalid variant index: " << indexPath.string() << std::endl;
+            return false;
+        }
+        source = line.substr(7);
+
+        // Deduplicated variants share a file, so read each file only once
+        std::unordered_map<std::string, const ShaderModule*> loadedFiles;
+        bool success = true;
+        size_t count = 0;
+        while (std::getline(index, line)) {
+            auto tab = line.find('\t');
+            if (tab == std::string::npos) {
+                continue;
+            }
+            auto name = variantModuleName(source, line.substr(0, tab));
+            auto file = line.substr(tab + 1);
+
+            if (auto it = loadedFiles.find(file); it != loadedFiles.end()) {
+                m_modules[name] = *it->second;
+                ++count;
+                continue;
+            }
+
+            auto module = m_compiler->loadSpirvFromFile((std::filesystem::path(directory) / file).string());
+            if (module.spirv.empty()) {
+                std::cout << "Failed to load shader variant: " << module.infoLog << std::endl;
+                success = false;
+                continue;
+            }
+            prepareModule(module);
+            auto& stored = m_modules[name] = std::move(module);
+            loadedFiles[file] = &stored;
+            ++count;
+        }
+
+        std::cout << "Loaded " << count << " variants of " << source << " from " << directory << std::endl;
+        return success;
+    }
+
     const ShaderModule* ShaderLoader::getModule(const std::string& path) const {
         auto it = m_modules.find(path);
         return (it != m_modules.end() ? &it->second : nullptr);
     }
 
+    bool ShaderLoader::reflectModule(const std::string& path, ShaderReflection& reflection, std::string& error) const {
+        auto module = getModule(path);
+        if (!module) {
+            error = "Shader not loaded: " + path;
+            return false;
+        }
+        return reflectSpirv(module->spirv, reflection, error);
+    }
+
+    void ShaderLoader::prepareModule(ShaderModule& module) const {
+        if (m_stripDebugInfo) {
+            size_t removed = stripDebugInfo(module.spirv);
+            if (removed > 0) {
+                module.infoLog += " (stripped " + std::to_string(removed) + " debug words)";
+            }
+        }
+        module.hash = hashSpirv(module.spirv);
+    }
+
+    void ShaderLoader::enableDependencyTracking(const std::string& graphPath) {
+        m_dependencies = std::make_unique<DependencyGraph>();
+        m_dependencyGraphPath = graphPath;
+        if (m_dependencies->load(graphPath)) {
+            std::cout << "Loaded shader dependency graph: " << graphPath << std::endl;
+        }
+    }
+
+    void ShaderLoader::trackDependencies(const std::string& path, const std::vector<std::string>& includes) {
+        if (!m_dependencies) {
+            return;
+        }
+        m_dependencies->record(path, includes);
+        m_dependenciesDirty = true;
+    }
+
+    bool ShaderLoader::saveDependencies() {
+        if (!m_dependencies || !m_dependenciesDirty) {
+            return true;
+        }
+        if (!m_dependencies->save(m_dependencyGraphPath)) {
+            std::cout << "Failed to save shader dependency graph: " << m_dependencyGraphPath << std::endl;
+            return false;
+        }
+        m_dependenciesDirty = false;
+        return true;
+    }
+
+    std::vector<std::string> ShaderLoader::reloadChanged() {
+        std::vector<std::string> reloaded;
+        if (!m_dependencies) {
+            return reloaded;
+        }
+
+        for (const auto& path : m_dependencies->dirtySources()) {
+            // The persisted graph can name shaders this run never loaded
+            auto loaded = m_modules.find(path);
+            if (loaded == m_modules.end()) {
+                continue;
+            }
+
+            auto options = m_compileOptions.find(path);
+            bool success = options != m_compileOptions.end()
+                ? compileShader(path, options->second)
+                : loadShader(path);
+
+            if (success) {
+                reloaded.push_back(path);
+            } else {
+                // Keep the last good module and re-stamp, so a broken edit is reported once
+                trackDependencies(path, loaded->second.dependencies);
+            }
+        }
+        // Also picks up loads made since the last poll
+        saveDependencies();
+        return reloaded;
+    }
+
 } // namespace ShaderLoader
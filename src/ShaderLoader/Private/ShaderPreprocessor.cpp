@@ -0,0 +1,138 @@
+//
+// Created by charlie on 8/2/25.
+//
+
+#include "../Public/ShaderPreprocessor.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unordered_set>
+
+namespace ShaderLoader {
+
+    namespace {
+
+        namespace fs = std::filesystem;
+
+        struct IncludeState {
+            const std::vector<std::string>& includeDirs;
+            std::unordered_set<std::string> visited;
+            PreprocessedSource&             result;
+        };
+
+        bool readText(const fs::path& path, std::string& out) {
+            std::ifstream file(path, std::ios::binary);
+            if (!file) {
+                return false;
+            }
+            std::ostringstream ss;
+            ss << file.rdbuf();
+            out = ss.str();
+            return true;
+        }
+
+        // Parse `#include "name"` or `#include <name>`; returns false for any other line
+        bool parseInclude(const std::string& line, std::string& name, bool& quoted) {
+            size_t i = line.find_first_not_of(" \t");
+            if (i == std::string::npos || line[i] != '#') {
+                return false;
+            }
+            i = line.find_first_not_of(" \t", i + 1);
+            if (i == std::string::npos || line.compare(i, 7, "include") != 0) {
+                return false;
+            }
+            i = line.find_first_not_of(" \t", i + 7);
+            if (i == std::string::npos || (line[i] != '"' && line[i] != '<')) {
+                return false;
+            }
+            quoted = line[i] == '"';
+            size_t end = line.find(quoted ? '"' : '>', i + 1);
+            if (end == std::string::npos) {
+                return false;
+            }
+            name = line.substr(i + 1, end - i - 1);
+            return true;
+        }
+
+        fs::path resolveInclude(const std::string& name, bool quoted, const fs::path& includer,
+                                const std::vector<std::string>& includeDirs) {
+            std::error_code ec;
+            if (quoted) {
+                auto candidate = includer.parent_path() / name;
+                if (fs::is_regular_file(candidate, ec)) {
+                    return candidate;
+                }
+            }
+            for (const auto& dir : includeDirs) {
+                auto candidate = fs::path(dir) / name;
+                if (fs::is_regular_file(candidate, ec)) {
+                    return candidate;
+                }
+            }
+            return {};
+        }
+
+        bool expandFile(const fs::path& path, IncludeState& state) {
+            std::string source;
+            if (!readText(path, source)) {
+                state.result.infoLog = "Failed to open shader source: " + path.string();
+                return false;
+            }
+
+            std::istringstream lines(source);
+            std::string line;
+            bool inBlockComment = false;
+            while (std::getline(lines, line)) {
+                std::string name;
+                bool quoted = false;
+                if (!inBlockComment && parseInclude(line, name, quoted)) {
+                    auto resolved = resolveInclude(name, quoted, path, state.includeDirs);
+                    if (resolved.empty()) {
+                        state.result.infoLog = path.string() + ": cannot find include file: " + name;
+                        return false;
+                    }
+                    std::error_code ec;
+                    auto canonical = fs::weakly_canonical(resolved, ec).string();
+                    if (state.visited.insert(canonical).second) {
+                        state.result.includes.push_back(canonical);
+                        if (!expandFile(resolved, state)) {
+                            return false;
+                        }
+                    }
+                    continue;
+                }
+
+                // Track block comments so commented-out includes aren't followed
+                for (size_t i = 0; i + 1 < line.size(); ++i) {
+                    if (!inBlockComment && line[i] == '/' && line[i + 1] == '/') {
+                        break;
+                    }
+                    if (!inBlockComment && line[i] == '/' && line[i + 1] == '*') {
+                        inBlockComment = true;
+                        ++i;
+                    } else if (inBlockComment && line[i] == '*' && line[i + 1] == '/') {
+                        inBlockComment = false;
+                        ++i;
+                    }
+                }
+
+                state.result.text += line;
+                state.result.text += '\n';
+            }
+            return true;
+        }
+
+    } // namespace
+
+    PreprocessedSource expandIncludes(const std::string& path, const std::vector<std::string>& includeDirs) {
+        PreprocessedSource result;
+        IncludeState state{includeDirs, {}, result};
+
+        std::error_code ec;
+        state.visited.insert(fs::weakly_canonical(path, ec).string());
+
+        result.success = expandFile(path, state);
+        return result;
+    }
+
+} // namespace ShaderLoader
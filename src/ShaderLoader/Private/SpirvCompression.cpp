@@ -0,0 +1,376 @@
+//
+// Created by charlie on 8/6/25.
+//
+
+#include "../Public/SpirvCompression.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#ifdef SHADERLOADER_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+namespace ShaderLoader {
+
+    namespace {
+
+        constexpr uint32_t kSpirvMagic     = 0x07230203;
+        constexpr size_t   kHeaderWords    = 5;
+        constexpr uint32_t kDeltaOpcodes   = 512;
+        constexpr uint32_t kDeltaSlots     = 4;
+        constexpr size_t   kReadChunkBytes = 64 * 1024;
+
+        inline bool usesDelta(uint32_t opcode, uint32_t operand) {
+            return opcode < kDeltaOpcodes && operand < kDeltaSlots;
+        }
+
+        inline uint32_t zigzagEncode(uint32_t delta) {
+            auto d = static_cast<int32_t>(delta);
+            return (static_cast<uint32_t>(d) << 1) ^ static_cast<uint32_t>(d >> 31);
+        }
+
+        inline uint32_t zigzagDecode(uint32_t value) {
+            return (value >> 1) ^ (0u - (value & 1));
+        }
+
+        void writeVarint(std::vector<uint8_t>& out, uint32_t value) {
+            while (value >= 0x80) {
+                out.push_back(static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<uint8_t>(value));
+        }
+
+        // Fails both on truncated input and on varints longer than 5 bytes
+        inline bool readVarint(const uint8_t*& cursor, const uint8_t* end, uint32_t& out) {
+            // Most deltas and opcodes fit in one byte
+            if (cursor != end && *cursor < 0x80) {
+                out = *cursor++;
+                return true;
+            }
+            uint32_t value = 0;
+            for (uint32_t shift = 0; shift < 35; shift += 7) {
+                if (cursor == end) {
+                    return false;
+                }
+                uint8_t byte = *cursor++;
+                value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) {
+                    out = value;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        std::vector<uint8_t> encodeStream(const std::vector<uint32_t>& spirv) {
+            std::vector<uint8_t> out;
+            out.reserve(spirv.size() * 2);
+
+            for (size_t i = 0; i < kHeaderWords; ++i) {
+                writeVarint(out, spirv[i]);
+            }
+
+            std::vector<uint32_t> previous(kDeltaOpcodes * kDeltaSlots, 0);
+            size_t i = kHeaderWords;
+            while (i < spirv.size()) {
+                uint32_t opcode = spirv[i] & 0xFFFF;
+                uint32_t count = spirv[i] >> 16;
+                writeVarint(out, opcode);
+                writeVarint(out, count);
+                for (uint32_t k = 0; k + 1 < count; ++k) {
+                    uint32_t word = spirv[i + 1 + k];
+                    if (usesDelta(opcode, k)) {
+                        uint32_t& prev = previous[opcode * kDeltaSlots + k];
+                        writeVarint(out, zigzagEncode(word - prev));
+                        prev = word;
+                    } else {
+                        writeVarint(out, word);
+                    }
+                }
+                i += count;
+            }
+            return out;
+        }
+
+    } // namespace
+
+    std::vector<uint8_t> encodeSpirvZ(const std::vector<uint32_t>& spirv, bool compress) {
+        if (spirv.size() < kHeaderWords || spirv[0] != kSpirvMagic) {
+            return {};
+        }
+
+        // Validate the instruction stream up front so the encoder never reads past the end
+        for (size_t i = kHeaderWords; i < spirv.size();) {
+            uint32_t count = spirv[i] >> 16;
+            if (count == 0 || i + count > spirv.size()) {
+                return {};
+            }
+            i += count;
+        }
+
+        SpirvZHeader header{kSpirvZMagic, kSpirvZVersion, 0, 0, static_cast<uint32_t>(spirv.size())};
+        auto stream = encodeStream(spirv);
+
+#ifdef SHADERLOADER_HAS_ZSTD
+        if (compress) {
+            std::vector<uint8_t> compressed(ZSTD_compressBound(stream.size()));
+            size_t size = ZSTD_compress(compressed.data(), compressed.size(), stream.data(), stream.size(), 19);
+            if (!ZSTD_isError(size) && size < stream.size()) {
+                compressed.resize(size);
+                stream = std::move(compressed);
+                header.flags |= kSpirvZFlagZstd;
+            }
+        }
+#else
+        (void)compress;
+#endif
+
+        std::vector<uint8_t> out(sizeof(SpirvZHeader) + stream.size());
+        memcpy(out.data(), &header, sizeof(header));
+        memcpy(out.data() + sizeof(header), stream.data(), stream.size());
+        return out;
+    }
+
+    bool writeSpirvZ(const std::string& path, const std::vector<uint32_t>& spirv, bool compress, std::string& error) {
+        auto encoded = encodeSpirvZ(spirv, compress);
+        if (encoded.empty()) {
+            error = "Invalid SPIR-V, cannot encode: " + path;
+            return false;
+        }
+
+        auto tempPath = path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+            if (!file) {
+                error = "Failed to write: " + path;
+                return false;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(tempPath, path, ec);
+        if (ec) {
+            error = "Failed to write: " + path + " (" + ec.message() + ")";
+            return false;
+        }
+        return true;
+    }
+
+    SpirvZDecoder::SpirvZDecoder(uint32_t* output, size_t wordCount)
+        : m_output(output)
+        , m_wordCount(wordCount)
+        , m_previous(kDeltaOpcodes * kDeltaSlots, 0)
+    {}
+
+    bool SpirvZDecoder::acceptValue(uint32_t value) {
+        switch (m_state) {
+            case State::Header:
+                if (m_written >= m_wordCount) {
+                    return false;
+                }
+                m_output[m_written++] = value;
+                if (m_written == kHeaderWords) {
+                    m_state = State::Opcode;
+                }
+                return true;
+
+            case State::Opcode:
+                if (value > 0xFFFF) {
+                    return false;
+                }
+                m_opcode = value;
+                m_state = State::Count;
+                return true;
+
+            case State::Count:
+                if (value == 0 || value > 0xFFFF || m_written + value > m_wordCount) {
+                    return false;
+                }
+                m_output[m_written++] = (value << 16) | m_opcode;
+                m_operandCount = value - 1;
+                m_operandIndex = 0;
+                m_state = m_operandCount ? State::Operand : State::Opcode;
+                return true;
+
+            case State::Operand: {
+                uint32_t word = value;
+                if (usesDelta(m_opcode, m_operandIndex)) {
+                    uint32_t& prev = m_previous[m_opcode * kDeltaSlots + m_operandIndex];
+                    word = prev + zigzagDecode(value);
+                    prev = word;
+                }
+                m_output[m_written++] = word;
+                if (++m_operandIndex == m_operandCount) {
+                    m_state = State::Opcode;
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Decode one whole instruction straight from the buffer; leaves all state untouched
+    // if the instruction isn't complete so the byte-wise path can take over
+    bool SpirvZDecoder::decodeInstructionFast(const uint8_t*& cursor, const uint8_t* end) {
+        const uint8_t* p = cursor;
+        uint32_t opcode, count;
+        if (!readVarint(p, end, opcode) || !readVarint(p, end, count)) {
+            return false;
+        }
+        if (opcode > 0xFFFF || count == 0 || count > 0xFFFF || m_written + count > m_wordCount) {
+            return false;
+        }
+
+        uint32_t* out = m_output + m_written;
+        uint32_t* previous = opcode < kDeltaOpcodes ? &m_previous[opcode * kDeltaSlots] : nullptr;
+        uint32_t saved[kDeltaSlots] = {};
+        if (previous) {
+            std::copy(previous, previous + kDeltaSlots, saved);
+        }
+
+        out[0] = (count << 16) | opcode;
+        for (uint32_t k = 0; k + 1 < count; ++k) {
+            uint32_t value;
+            if (!readVarint(p, end, value)) {
+                if (previous) {
+                    std::copy(saved, saved + kDeltaSlots, previous);
+                }
+                return false;
+            }
+            if (previous && k < kDeltaSlots) {
+                value = previous[k] + zigzagDecode(value);
+                previous[k] = value;
+            }
+            out[1 + k] = value;
+        }
+
+        m_written += count;
+        cursor = p;
+        return true;
+    }
+
+    bool SpirvZDecoder::feed(const uint8_t* data, size_t size) {
+        const uint8_t* cursor = data;
+        const uint8_t* end = data + size;
+
+        while (cursor < end) {
+            while (m_state == State::Opcode && m_shift == 0 && decodeInstructionFast(cursor, end)) {
+            }
+            if (cursor == end) {
+                break;
+            }
+
+            // Byte-wise path for the header and for instructions split across chunks
+            uint8_t byte = *cursor++;
+            m_value |= static_cast<uint64_t>(byte & 0x7F) << m_shift;
+            if (byte & 0x80) {
+                m_shift += 7;
+                if (m_shift >= 35) {
+                    return false;
+                }
+                continue;
+            }
+            if (m_value > 0xFFFFFFFFull) {
+                return false;
+            }
+            uint32_t value = static_cast<uint32_t>(m_value);
+            m_value = 0;
+            m_shift = 0;
+            if (!acceptValue(value)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    ShaderModule loadSpirvZ(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            return {.spirv = {}, .infoLog = "Failed to open compressed SPIR-V file: " + path};
+        }
+
+        SpirvZHeader header{};
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            header.magic != kSpirvZMagic || header.version != kSpirvZVersion || header.wordCount < kHeaderWords) {
+            return {.spirv = {}, .infoLog = "Invalid compressed SPIR-V header in file: " + path};
+        }
+
+        std::vector<uint32_t> spirv(header.wordCount);
+        SpirvZDecoder decoder(spirv.data(), spirv.size());
+        std::vector<uint8_t> chunk(kReadChunkBytes);
+        bool ok = true;
+
+        if (header.flags & kSpirvZFlagZstd) {
+#ifdef SHADERLOADER_HAS_ZSTD
+            std::unique_ptr<ZSTD_DStream, size_t (*)(ZSTD_DStream*)> stream(ZSTD_createDStream(), ZSTD_freeDStream);
+            std::vector<uint8_t> decompressed(ZSTD_DStreamOutSize());
+            size_t remaining = 1;
+            while (ok && file) {
+                file.read(reinterpret_cast<char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+                ZSTD_inBuffer input{chunk.data(), static_cast<size_t>(file.gcount()), 0};
+                if (input.size == 0) {
+                    break;
+                }
+                while (ok && input.pos < input.size) {
+                    ZSTD_outBuffer output{decompressed.data(), decompressed.size(), 0};
+                    remaining = ZSTD_decompressStream(stream.get(), &output, &input);
+                    ok = !ZSTD_isError(remaining) && decoder.feed(decompressed.data(), output.pos);
+                }
+            }
+            ok = ok && remaining == 0;
+#else
+            return {.spirv = {}, .infoLog = "Compressed SPIR-V needs zstd, which this build lacks: " + path};
+#endif
+        } else {
+            while (ok && file) {
+                file.read(reinterpret_cast<char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+                ok = decoder.feed(chunk.data(), static_cast<size_t>(file.gcount()));
+            }
+        }
+
+        if (!ok || !decoder.finished() || spirv[0] != kSpirvMagic) {
+            return {.spirv = {}, .infoLog = "Corrupt compressed SPIR-V file: " + path};
+        }
+
+        std::string info = "Successfully loaded compressed SPIR-V from: " + path +
+            " (" + std::to_string(spirv.size()) + " words)";
+        return {std::move(spirv), std::move(info)};
+    }
+
+    namespace {
+
+        class CompressedSpirvCompiler : public IShaderCompiler {
+        public:
+            explicit CompressedSpirvCompiler(std::unique_ptr<IShaderCompiler> compiler)
+                : m_compiler(std::move(compiler))
+            {}
+
+            ShaderModule loadSpirvFromFile(const std::string& path) override {
+                if (path.size() > 6 && path.compare(path.size() - 6, 6, ".spv.z") == 0) {
+                    return loadSpirvZ(path);
+                }
+                return m_compiler->loadSpirvFromFile(path);
+            }
+
+            ShaderModule compileFromFile(const std::string& path, const CompileOptions& options) override {
+                return m_compiler->compileFromFile(path, options);
+            }
+
+            std::string version() const override {
+                return m_compiler->version();
+            }
+
+        private:
+            std::unique_ptr<IShaderCompiler> m_compiler;
+        };
+
+    } // namespace
+
+    std::unique_ptr<IShaderCompiler> createCompressedSpirvCompiler(std::unique_ptr<IShaderCompiler> compiler) {
+        return std::make_unique<CompressedSpirvCompiler>(std::move(compiler));
+    }
+
+} // namespace ShaderLoader
@@ -0,0 +1,2095 @@
+//
+// Created by charlie on 8/8/25.
+//
+
+#include "../Public/SpirvInterpreter.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+
+namespace ShaderLoader {
+
+    namespace {
+
+        constexpr uint32_t kSpirvMagic  = 0x07230203;
+        constexpr size_t   kHeaderWords = 5;
+        constexpr uint32_t kLanes       = ComputeInterpreter::kSubgroupSize;
+        constexpr uint32_t kAllLanes    = (1u << kLanes) - 1;
+        constexpr uint32_t kNoSlot      = 0xFFFFFFFF;
+        constexpr uint32_t kNullOffset  = 0xFFFFFFFF;
+
+        static_assert(kLanes <= 32, "lane masks are 32-bit");
+
+        enum Op : uint16_t {
+            OpNop = 0, OpUndef = 1, OpSourceContinued = 2, OpSource = 3, OpSourceExtension = 4,
+            OpName = 5, OpMemberName = 6, OpString = 7, OpLine = 8, OpExtension = 10,
+            OpExtInstImport = 11, OpExtInst = 12, OpMemoryModel = 14, OpEntryPoint = 15,
+            OpExecutionMode = 16, OpCapability = 17,
+            OpTypeVoid = 19, OpTypeBool = 20, OpTypeInt = 21, OpTypeFloat = 22, OpTypeVector = 23,
+            OpTypeMatrix = 24, OpTypeArray = 28, OpTypeRuntimeArray = 29, OpTypeStruct = 30,
+            OpTypePointer = 32, OpTypeFunction = 33,
+            OpConstantTrue = 41, OpConstantFalse = 42, OpConstant = 43, OpConstantComposite = 44,
+            OpConstantNull = 46, OpSpecConstantTrue = 48, OpSpecConstantFalse = 49, OpSpecConstant = 50,
+            OpSpecConstantComposite = 51, OpSpecConstantOp = 52,
+            OpFunction = 54, OpFunctionParameter = 55, OpFunctionEnd = 56, OpFunctionCall = 57,
+            OpVariable = 59, OpLoad = 61, OpStore = 62, OpCopyMemory = 63, OpAccessChain = 65,
+            OpInBoundsAccessChain = 66, OpArrayLength = 68,
+            OpDecorate = 71, OpMemberDecorate = 72,
+            OpVectorExtractDynamic = 77, OpVectorInsertDynamic = 78, OpVectorShuffle = 79,
+            OpCompositeConstruct = 80, OpCompositeExtract = 81, OpCompositeInsert = 82,
+            OpCopyObject = 83, OpTranspose = 84,
+            OpConvertFToU = 109, OpConvertFToS = 110, OpConvertSToF = 111, OpConvertUToF = 112,
+            OpUConvert = 113, OpSConvert = 114, OpFConvert = 115, OpBitcast = 124,
+            OpSNegate = 126, OpFNegate = 127, OpIAdd = 128, OpFAdd = 129, OpISub = 130, OpFSub = 131,
+            OpIMul = 132, OpFMul = 133, OpUDiv = 134, OpSDiv = 135, OpFDiv = 136, OpUMod = 137,
+            OpSRem = 138, OpSMod = 139, OpFRem = 140, OpFMod = 141, OpVectorTimesScalar = 142,
+            OpMatrixTimesScalar = 143, OpVectorTimesMatrix = 144, OpMatrixTimesVector = 145,
+            OpMatrixTimesMatrix = 146, OpOuterProduct = 147, OpDot = 148,
+            OpAny = 154, OpAll = 155, OpIsNan = 156, OpIsInf = 157,
+            OpLogicalEqual = 164, OpLogicalNotEqual = 165, OpLogicalOr = 166, OpLogicalAnd = 167,
+            OpLogicalNot = 168, OpSelect = 169, OpIEqual = 170, OpINotEqual = 171,
+            OpUGreaterThan = 172, OpSGreaterThan = 173, OpUGreaterThanEqual = 174,
+            OpSGreaterThanEqual = 175, OpULessThan = 176, OpSLessThan = 177, OpULessThanEqual = 178,
+            OpSLessThanEqual = 179, OpFOrdEqual = 180, OpFUnordEqual = 181, OpFOrdNotEqual = 182,
+            OpFUnordNotEqual = 183, OpFOrdLessThan = 184, OpFUnordLessThan = 185,
+            OpFOrdGreaterThan = 186, OpFUnordGreaterThan = 187, OpFOrdLessThanEqual = 188,
+            OpFUnordLessThanEqual = 189, OpFOrdGreaterThanEqual = 190, OpFUnordGreaterThanEqual = 191,
+            OpShiftRightLogical = 194, OpShiftRightArithmetic = 195, OpShiftLeftLogical = 196,
+            OpBitwiseOr = 197, OpBitwiseXor = 198, OpBitwiseAnd = 199, OpNot = 200,
+            OpBitReverse = 204, OpBitCount = 205,
+            OpControlBarrier = 224, OpMemoryBarrier = 225,
+            OpAtomicLoad = 227, OpAtomicStore = 228, OpAtomicExchange = 229,
+            OpAtomicCompareExchange = 230, OpAtomicIIncrement = 232, OpAtomicIDecrement = 233,
+            OpAtomicIAdd = 234, OpAtomicISub = 235, OpAtomicSMin = 236, OpAtomicUMin = 237,
+            OpAtomicSMax = 238, OpAtomicUMax = 239, OpAtomicAnd = 240, OpAtomicOr = 241,
+            OpAtomicXor = 242,
+            OpPhi = 245, OpLoopMerge = 246, OpSelectionMerge = 247, OpLabel = 248, OpBranch = 249,
+            OpBranchConditional = 250, OpSwitch = 251, OpKill = 252, OpReturn = 253,
+            OpReturnValue = 254, OpUnreachable = 255,
+            OpNoLine = 317, OpModuleProcessed = 330, OpCopyLogical = 400,
+            OpDecorateString = 5632, OpMemberDecorateString = 5633,
+        };
+
+        enum StorageClass : uint32_t {
+            StorageInput = 1, StorageUniform = 2, StorageWorkgroup = 4, StoragePrivate = 6,
+            StorageFunction = 7, StoragePushConstant = 9, StorageStorageBuffer = 12,
+        };
+
+        enum Decoration : uint32_t {
+            DecorationSpecId = 1, DecorationRowMajor = 4, DecorationArrayStride = 6,
+            DecorationMatrixStride = 7, DecorationBuiltIn = 11, DecorationBinding = 33,
+            DecorationDescriptorSet = 34, DecorationOffset = 35,
+        };
+
+        enum BuiltIn : uint32_t {
+            BuiltInNumWorkgroups = 24, BuiltInWorkgroupSize = 25, BuiltInWorkgroupId = 26,
+            BuiltInLocalInvocationId = 27, BuiltInGlobalInvocationId = 28,
+            BuiltInLocalInvocationIndex = 29, BuiltInSubgroupSize = 36, BuiltInNumSubgroups = 38,
+            BuiltInSubgroupId = 40, BuiltInSubgroupLocalInvocationId = 41,
+            BuiltInNone = 0xFFFFFFFF,
+        };
+
+        // GLSL.std.450 extended instructions
+        enum GlslOp : uint32_t {
+            GlslRound = 1, GlslRoundEven = 2, GlslTrunc = 3, GlslFAbs = 4, GlslSAbs = 5,
+            GlslFSign = 6, GlslSSign = 7, GlslFloor = 8, GlslCeil = 9, GlslFract = 10,
+            GlslRadians = 11, GlslDegrees = 12, GlslSin = 13, GlslCos = 14, GlslTan = 15,
+            GlslAsin = 16, GlslAcos = 17, GlslAtan = 18, GlslSinh = 19, GlslCosh = 20,
+            GlslTanh = 21, GlslAsinh = 22, GlslAcosh = 23, GlslAtanh = 24, GlslAtan2 = 25,
+            GlslPow = 26, GlslExp = 27, GlslLog = 28, GlslExp2 = 29, GlslLog2 = 30,
+            GlslSqrt = 31, GlslInverseSqrt = 32, GlslFMin = 37, GlslUMin = 38, GlslSMin = 39,
+            GlslFMax = 40, GlslUMax = 41, GlslSMax = 42, GlslFClamp = 43, GlslUClamp = 44,
+            GlslSClamp = 45, GlslFMix = 46, GlslStep = 48, GlslSmoothStep = 49, GlslFma = 50,
+            GlslLdexp = 53, GlslLength = 66, GlslDistance = 67, GlslCross = 68,
+            GlslNormalize = 69, GlslFaceForward = 70, GlslReflect = 71, GlslRefract = 72,
+            GlslFindILsb = 73, GlslFindSMsb = 74, GlslFindUMsb = 75, GlslNMin = 79,
+            GlslNMax = 80, GlslNClamp = 81,
+        };
+
+        enum class TypeKind { Other, Void, Bool, Int, Float, Vector, Matrix, Array, RuntimeArray, Struct, Pointer, Function };
+
+        struct Type {
+            TypeKind kind = TypeKind::Other;
+            bool     isSigned = false;
+            uint32_t element = 0;       // vector/matrix/array element, pointer pointee
+            uint32_t count = 0;         // vector components, matrix columns, array length
+            uint32_t storageClass = 0;  // pointers
+            uint32_t words = 0;         // register words when held in an SSA value
+            uint32_t size = 0;          // bytes in memory
+            uint32_t arrayStride = 0;
+            std::vector<uint32_t> members;
+            std::vector<uint32_t> memberOffsets;      // bytes
+            std::vector<uint32_t> memberMatrixStride; // 0 = natural
+            std::vector<uint32_t> memberWords;        // register word offset of each member
+        };
+
+        // Storage a pointer can refer to. Host regions are buffers bound at dispatch, workgroup
+        // regions live in the workgroup's shared block and lane regions are per invocation
+        enum class RegionKind { Host, Workgroup, Lane };
+
+        struct Region {
+            RegionKind kind = RegionKind::Lane;
+            uint32_t   storageClass = 0;
+            uint32_t   pointee = 0;
+            uint32_t   set = 0;
+            uint32_t   binding = 0;
+            uint32_t   offset = 0;         // into shared or per-lane memory
+            uint32_t   size = 0;
+            uint32_t   builtIn = BuiltInNone;
+            uint32_t   initializer = 0;
+            bool       pushConstant = false;
+        };
+
+        struct Instruction {
+            const uint32_t* op;   // operand words following the opcode word
+            uint16_t opcode;
+            uint16_t count;       // number of operand words
+            uint32_t aux = 0;     // access chain index or composite word offset
+        };
+
+        struct Block {
+            uint32_t label = 0;
+            std::vector<Instruction> instructions;
+        };
+
+        struct Function {
+            uint32_t id = 0;
+            std::vector<uint32_t> params;
+            std::vector<Block> blocks;
+        };
+
+        struct AccessStep {
+            uint32_t index;       // id of a dynamic index
+            int64_t  stride;
+            bool     isSigned;
+        };
+
+        struct AccessChain {
+            int64_t constantOffset = 0;
+            std::vector<AccessStep> steps;
+        };
+
+        struct MemberKey {
+            uint32_t id;
+            uint32_t member;
+            bool operator==(const MemberKey&) const = default;
+        };
+
+        struct MemberKeyHash {
+            size_t operator()(const MemberKey& key) const {
+                return std::hash<uint64_t>()((static_cast<uint64_t>(key.id) << 32) | key.member);
+            }
+        };
+
+        struct Decorations {
+            uint32_t specId = kNoSlot;
+            uint32_t arrayStride = 0;
+            uint32_t builtIn = BuiltInNone;
+            uint32_t set = 0;
+            uint32_t binding = 0;
+        };
+
+        struct MemberDecorations {
+            uint32_t offset = kNoSlot;
+            uint32_t matrixStride = 0;
+            bool     rowMajor = false;
+        };
+
+        inline float    asFloat(uint32_t w) { return std::bit_cast<float>(w); }
+        inline uint32_t fromFloat(float f)  { return std::bit_cast<uint32_t>(f); }
+        inline int32_t  asInt(uint32_t w)   { return static_cast<int32_t>(w); }
+        inline uint32_t fromInt(int32_t i)  { return static_cast<uint32_t>(i); }
+
+        // Runs f(lane) for every lane in mask; a full mask takes the dense loop the compiler can vectorize
+        template<typename F>
+        inline void forLanes(uint32_t mask, F&& f) {
+            if (mask == kAllLanes) {
+                for (uint32_t lane = 0; lane < kLanes; ++lane) {
+                    f(lane);
+                }
+            } else {
+                for (uint32_t m = mask; m; m &= m - 1) {
+                    f(static_cast<uint32_t>(std::countr_zero(m)));
+                }
+            }
+        }
+
+        // Float to integer conversions saturate instead of hitting undefined behaviour
+        template<typename T>
+        inline T convertFloat(float value) {
+            if (std::isnan(value)) {
+                return 0;
+            }
+            if (value <= static_cast<float>(std::numeric_limits<T>::min())) {
+                return std::numeric_limits<T>::min();
+            }
+            if (value >= static_cast<float>(std::numeric_limits<T>::max())) {
+                return std::numeric_limits<T>::max();
+            }
+            return static_cast<T>(value);
+        }
+
+        bool hasResult(uint16_t opcode) {
+            switch (opcode) {
+                case OpNop: case OpStore: case OpCopyMemory: case OpBranch: case OpBranchConditional:
+                case OpSwitch: case OpReturn: case OpReturnValue: case OpKill: case OpUnreachable:
+                case OpSelectionMerge: case OpLoopMerge: case OpControlBarrier: case OpMemoryBarrier:
+                case OpAtomicStore: case OpLine: case OpNoLine: case OpLabel: case OpFunctionEnd:
+                    return false;
+                default:
+                    return true;
+            }
+        }
+
+        bool isSupportedInstruction(uint16_t opcode) {
+            switch (opcode) {
+                case OpNop: case OpUndef: case OpLine: case OpNoLine: case OpExtInst: case OpFunctionCall:
+                case OpVariable: case OpLoad: case OpStore: case OpCopyMemory: case OpAccessChain:
+                case OpInBoundsAccessChain: case OpArrayLength:
+                case OpVectorExtractDynamic: case OpVectorInsertDynamic: case OpVectorShuffle:
+                case OpCompositeConstruct: case OpCompositeExtract: case OpCompositeInsert:
+                case OpCopyObject: case OpCopyLogical: case OpTranspose:
+                case OpConvertFToU: case OpConvertFToS: case OpConvertSToF: case OpConvertUToF:
+                case OpUConvert: case OpSConvert: case OpFConvert: case OpBitcast:
+                case OpSNegate: case OpFNegate: case OpIAdd: case OpFAdd: case OpISub: case OpFSub:
+                case OpIMul: case OpFMul: case OpUDiv: case OpSDiv: case OpFDiv: case OpUMod:
+                case OpSRem: case OpSMod: case OpFRem: case OpFMod: case OpVectorTimesScalar:
+                case OpMatrixTimesScalar: case OpVectorTimesMatrix: case OpMatrixTimesVector:
+                case OpMatrixTimesMatrix: case OpOuterProduct: case OpDot:
+                case OpAny: case OpAll: case OpIsNan: case OpIsInf:
+                case OpLogicalEqual: case OpLogicalNotEqual: case OpLogicalOr: case OpLogicalAnd:
+                case OpLogicalNot: case OpSelect: case OpIEqual: case OpINotEqual:
+                case OpUGreaterThan: case OpSGreaterThan: case OpUGreaterThanEqual:
+                case OpSGreaterThanEqual: case OpULessThan: case OpSLessThan: case OpULessThanEqual:
+                case OpSLessThanEqual: case OpFOrdEqual: case OpFUnordEqual: case OpFOrdNotEqual:
+                case OpFUnordNotEqual: case OpFOrdLessThan: case OpFUnordLessThan:
+                case OpFOrdGreaterThan: case OpFUnordGreaterThan: case OpFOrdLessThanEqual:
+                case OpFUnordLessThanEqual: case OpFOrdGreaterThanEqual: case OpFUnordGreaterThanEqual:
+                case OpShiftRightLogical: case OpShiftRightArithmetic: case OpShiftLeftLogical:
+                case OpBitwiseOr: case OpBitwiseXor: case OpBitwiseAnd: case OpNot:
+                case OpBitReverse: case OpBitCount:
+                case OpControlBarrier: case OpMemoryBarrier:
+                case OpAtomicLoad: case OpAtomicStore: case OpAtomicExchange: case OpAtomicCompareExchange:
+                case OpAtomicIIncrement: case OpAtomicIDecrement: case OpAtomicIAdd: case OpAtomicISub:
+                case OpAtomicSMin: case OpAtomicUMin: case OpAtomicSMax: case OpAtomicUMax:
+                case OpAtomicAnd: case OpAtomicOr: case OpAtomicXor:
+                case OpPhi: case OpLoopMerge: case OpSelectionMerge: case OpBranch:
+                case OpBranchConditional: case OpSwitch: case OpKill: case OpReturn:
+                case OpReturnValue: case OpUnreachable:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        bool isSupportedGlslInstruction(uint32_t instruction) {
+            return (instruction >= GlslRound && instruction <= GlslInverseSqrt) ||
+                   (instruction >= GlslFMin && instruction <= GlslFMix) ||
+                   (instruction >= GlslStep && instruction <= GlslFma) ||
+                   instruction == GlslLdexp ||
+                   (instruction >= GlslLength && instruction <= GlslFindUMsb) ||
+                   (instruction >= GlslNMin && instruction <= GlslNClamp);
+        }
+
+        std::string readString(const uint32_t* words, size_t wordCount) {
+            const char* text = reinterpret_cast<const char*>(words);
+            return std::string(text, strnlen(text, wordCount * sizeof(uint32_t)));
+        }
+
+    } // namespace
+
+    struct ComputeInterpreter::Program {
+        std::vector<uint32_t>    words;
+        uint32_t                 bound = 0;
+        std::vector<Type>        types;
+        std::vector<uint32_t>    valueType;        // result type of every value id
+        std::vector<uint32_t>    slot;             // register file offset of every value id, in words
+        std::vector<uint32_t>    slotWords;
+        std::vector<uint32_t>    ptrMatrixStride;  // matrix stride a pointer value's pointee is laid out with
+        std::vector<uint32_t>    blockIndex;       // block index of every label id
+        std::vector<uint32_t>    functionIndex;
+        std::vector<Region>      regions;
+        std::vector<Function>    functions;
+        std::vector<AccessChain> accessChains;
+        std::vector<uint32_t>    registerImage;    // constants and variable pointers, broadcast to every lane
+        std::vector<uint32_t>    privateRegions;   // private variables with an initializer
+        std::vector<uint32_t>    builtInRegions;
+        std::vector<uint32_t>    nonSemanticSets;
+        uint32_t                 glslSet = kNoSlot;
+        uint32_t                 laneMemoryBytes = 0;
+        uint32_t                 sharedMemoryBytes = 0;
+        uint32_t                 entryFunction = 0;
+        std::array<uint32_t, 3>  workgroupSize{1, 1, 1};
+
+        bool parse(const std::vector<uint32_t>& spirv, const ShaderReflection& reflection,
+                   const std::map<uint32_t, uint32_t>& specConstants, std::string& error);
+
+        // Bytes an access of type touches; matrices may be laid out with an explicit column stride
+        uint32_t accessSize(uint32_t typeId, uint32_t matrixStride) const {
+            const Type& type = types[typeId];
+            if (type.kind == TypeKind::Matrix && matrixStride) {
+                return (type.count - 1) * matrixStride + types[type.element].size;
+            }
+            return type.size;
+        }
+
+        // Register word offset of a composite member reached through literal indices
+        uint32_t wordOffset(uint32_t typeId, const uint32_t* indices, uint32_t count) const {
+            uint32_t offset = 0;
+            for (uint32_t k = 0; k < count; ++k) {
+                const Type& type = types[typeId];
+                uint32_t index = indices[k];
+                if (type.kind == TypeKind::Struct) {
+                    offset += type.memberWords[index];
+                    typeId = type.members[index];
+                } else if (type.kind == TypeKind::Vector) {
+                    offset += index;
+                    typeId = type.element;
+                } else {
+                    offset += index * types[type.element].words;
+                    typeId = type.element;
+                }
+            }
+            return offset;
+        }
+
+        // Copy a value between memory and one lane of the register file (dst/src point at word 0 of that lane)
+        void loadMemory(uint32_t typeId, const uint8_t* src, uint32_t* dst, uint32_t matrixStride) const {
+            const Type& type = types[typeId];
+            switch (type.kind) {
+                case TypeKind::Bool:
+                case TypeKind::Int:
+                case TypeKind::Float:
+                    memcpy(dst, src, sizeof(uint32_t));
+                    break;
+                case TypeKind::Vector:
+                    for (uint32_t c = 0; c < type.count; ++c) {
+                        memcpy(dst + c * kLanes, src + c * sizeof(uint32_t), sizeof(uint32_t));
+                    }
+                    break;
+                case TypeKind::Matrix: {
+                    const Type& column = types[type.element];
+                    uint32_t stride = matrixStride ? matrixStride : column.size;
+                    for (uint32_t c = 0; c < type.count; ++c) {
+                        for (uint32_t r = 0; r < column.count; ++r) {
+                            memcpy(dst + (c * column.count + r) * kLanes, src + c * stride + r * sizeof(uint32_t), sizeof(uint32_t));
+                        }
+                    }
+                    break;
+                }
+                case TypeKind::Array: {
+                    uint32_t elementWords = types[type.element].words;
+                    for (uint32_t i = 0; i < type.count; ++i) {
+                        loadMemory(type.element, src + i * type.arrayStride, dst + i * elementWords * kLanes, matrixStride);
+                    }
+                    break;
+                }
+                case TypeKind::Struct:
+                    for (size_t m = 0; m < type.members.size(); ++m) {
+                        loadMemory(type.members[m], src + type.memberOffsets[m], dst + type.memberWords[m] * kLanes,
+                                   type.memberMatrixStride[m]);
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        void storeMemory(uint32_t typeId, uint8_t* dst, const uint32_t* src, uint32_t matrixStride) const {
+            const Type& type = types[typeId];
+            switch (type.kind) {
+                case TypeKind::Bool:
+                case TypeKind::Int:
+                case TypeKind::Float:
+                    memcpy(dst, src, sizeof(uint32_t));
+                    break;
+                case TypeKind::Vector:
+                    for (uint32_t c = 0; c < type.count; ++c) {
+                        memcpy(dst + c * sizeof(uint32_t), src + c * kLanes, sizeof(uint32_t));
+                    }
+                    break;
+                case TypeKind::Matrix: {
+                    const Type& column = types[type.element];
+                    uint32_t stride = matrixStride ? matrixStride : column.size;
+                    for (uint32_t c = 0; c < type.count; ++c) {
+                        for (uint32_t r = 0; r < column.count; ++r) {
+                            memcpy(dst + c * stride + r * sizeof(uint32_t), src + (c * column.count + r) * kLanes, sizeof(uint32_t));
+                        }
+                    }
+                    break;
+                }
+                case TypeKind::Array: {
+                    uint32_t elementWords = types[type.element].words;
+                    for (uint32_t i = 0; i < type.count; ++i) {
+                        storeMemory(type.element, dst + i * type.arrayStride, src + i * elementWords * kLanes, matrixStride);
+                    }
+                    break;
+                }
+                case TypeKind::Struct:
+                    for (size_t m = 0; m < type.members.size(); ++m) {
+                        storeMemory(type.members[m], dst + type.memberOffsets[m], src + type.memberWords[m] * kLanes,
+                                    type.memberMatrixStride[m]);
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+    };
+
+    bool ComputeInterpreter::Program::parse(const std::vector<uint32_t>& spirv, const ShaderReflection& reflection,
+                                            const std::map<uint32_t, uint32_t>& specConstants, std::string& error) {
+        if (spirv.size() < kHeaderWords || spirv[0] != kSpirvMagic) {
+            error = "Not a SPIR-V module";
+            return false;
+        }
+        if (reflection.executionModel != ExecutionModel::GLCompute) {
+            error = "Entry point '" + reflection.entryPoint + "' is not a compute shader";
+            return false;
+        }
+
+        words = spirv;
+        bound = words[3];
+        types.assign(bound, {});
+        valueType.assign(bound, 0);
+        slot.assign(bound, kNoSlot);
+        slotWords.assign(bound, 0);
+        ptrMatrixStride.assign(bound, 0);
+        blockIndex.assign(bound, kNoSlot);
+        functionIndex.assign(bound, kNoSlot);
+
+        std::unordered_map<uint32_t, Decorations> decorations;
+        std::unordered_map<MemberKey, MemberDecorations, MemberKeyHash> memberDecorations;
+        std::vector<std::vector<uint32_t>> initial(bound);
+        std::vector<bool> isConstant(bound, false);
+        uint32_t registerWords = 0;
+        uint32_t entryId = 0;
+        Function* function = nullptr;
+
+        auto fail = [&](const std::string& message) {
+            error = message;
+            return false;
+        };
+        auto decorationsOf = [&](uint32_t id) {
+            auto it = decorations.find(id);
+            return it != decorations.end() ? it->second : Decorations{};
+        };
+        auto setValue = [&](uint32_t id, uint32_t typeId) {
+            valueType[id] = typeId;
+            slotWords[id] = types[typeId].words;
+            if (slotWords[id] > 0) {
+                slot[id] = registerWords * kLanes;
+                registerWords += slotWords[id];
+            }
+        };
+        auto specValue = [&](uint32_t id, uint32_t value) {
+            uint32_t specId = decorationsOf(id).specId;
+            auto it = specConstants.find(specId);
+            return it != specConstants.end() ? it->second : value;
+        };
+        auto addRegion = [&](uint32_t id, uint32_t pointerType, uint32_t storageClass, uint32_t initializer) {
+            Region region;
+            region.storageClass = storageClass;
+            region.pointee = types[pointerType].element;
+            region.size = types[region.pointee].size;
+            region.initializer = initializer;
+            auto decoration = decorationsOf(id);
+
+            switch (storageClass) {
+                case StorageStorageBuffer:
+                case StorageUniform:
+                    if (types[region.pointee].kind != TypeKind::Struct) {
+                        return fail("Arrays of buffers are not supported");
+                    }
+                    region.kind = RegionKind::Host;
+                    region.set = decoration.set;
+                    region.binding = decoration.binding;
+                    break;
+                case StoragePushConstant:
+                    region.kind = RegionKind::Host;
+                    region.pushConstant = true;
+                    break;
+                case StorageWorkgroup:
+                    region.kind = RegionKind::Workgroup;
+                    region.offset = sharedMemoryBytes;
+                    sharedMemoryBytes += region.size;
+                    break;
+                case StorageInput:
+                    switch (decoration.builtIn) {
+                        case BuiltInNumWorkgroups: case BuiltInWorkgroupId: case BuiltInLocalInvocationId:
+                        case BuiltInGlobalInvocationId: case BuiltInLocalInvocationIndex: case BuiltInSubgroupSize:
+                        case BuiltInNumSubgroups: case BuiltInSubgroupId: case BuiltInSubgroupLocalInvocationId:
+                            break;
+                        default:
+                            return fail("Unsupported compute input (BuiltIn " + std::to_string(decoration.builtIn) + ")");
+                    }
+                    region.builtIn = decoration.builtIn;
+                    [[fallthrough]];
+                case StoragePrivate:
+                case StorageFunction:
+                    region.kind = RegionKind::Lane;
+                    region.offset = laneMemoryBytes;
+                    laneMemoryBytes += region.size;
+                    break;
+                default:
+                    return fail("Unsupported storage class " + std::to_string(storageClass));
+            }
+
+            uint32_t index = static_cast<uint32_t>(regions.size());
+            if (region.builtIn != BuiltInNone) {
+                builtInRegions.push_back(index);
+            } else if (storageClass == StoragePrivate && initializer) {
+                privateRegions.push_back(index);
+            }
+            regions.push_back(region);
+            setValue(id, pointerType);
+            initial[id] = {index, 0};
+            return true;
+        };
+
+        for (size_t i = kHeaderWords; i < words.size();) {
+            uint16_t opcode = static_cast<uint16_t>(words[i] & 0xFFFF);
+            uint32_t count = words[i] >> 16;
+            if (count == 0 || i + count > words.size()) {
+                return fail("Malformed SPIR-V instruction at word " + std::to_string(i));
+            }
+            const uint32_t* op = words.data() + i + 1;
+            uint32_t n = count - 1;
+            i += count;
+
+            // Values are indexed by result id, so those must stay inside the id bound
+            bool definesValue = function ? hasResult(opcode)
+                                         : (opcode >= OpConstantTrue && opcode <= OpSpecConstantComposite) ||
+                                           opcode == OpVariable || opcode == OpUndef;
+            if (definesValue && (n < 2 || op[1] >= bound)) {
+                return fail("SPIR-V result id out of bounds");
+            }
+            bool definesId = (opcode >= OpTypeVoid && opcode <= OpTypeFunction) || opcode == OpLabel;
+            if ((definesId && (n < 1 || op[0] >= bound)) || (opcode == OpFunction && (n < 2 || op[1] >= bound))) {
+                return fail("SPIR-V result id out of bounds");
+            }
+
+            if (function) {
+                if (opcode == OpFunctionEnd) {
+                    function = nullptr;
+                    continue;
+                }
+                if (opcode == OpFunctionParameter) {
+                    function->params.push_back(op[1]);
+                    setValue(op[1], op[0]);
+                    continue;
+                }
+                if (opcode == OpLabel) {
+                    blockIndex[op[0]] = static_cast<uint32_t>(function->blocks.size());
+                    function->blocks.push_back({op[0], {}});
+                    continue;
+                }
+                if (!isSupportedInstruction(opcode)) {
+                    return fail("Unsupported SPIR-V instruction (opcode " + std::to_string(opcode) + ")");
+                }
+                if (function->blocks.empty()) {
+                    return fail("Instruction outside a block");
+                }
+
+                Instruction instruction{op, opcode, static_cast<uint16_t>(n)};
+                if (hasResult(opcode)) {
+                    setValue(op[1], op[0]);
+                }
+
+                switch (opcode) {
+                    case OpExtInst:
+                        if (op[2] == glslSet) {
+                            if (!isSupportedGlslInstruction(op[3])) {
+                                return fail("Unsupported GLSL.std.450 instruction " + std::to_string(op[3]));
+                            }
+                        } else if (std::find(nonSemanticSets.begin(), nonSemanticSets.end(), op[2]) == nonSemanticSets.end()) {
+                            return fail("Unknown extended instruction set");
+                        }
+                        break;
+
+                    case OpVariable:
+                        if (op[2] != StorageFunction) {
+                            return fail("Function-scope variable with a non-Function storage class");
+                        }
+                        if (!addRegion(op[1], op[0], op[2], n > 3 ? op[3] : 0)) {
+                            return false;
+                        }
+                        instruction.aux = initial[op[1]][0];
+                        break;
+
+                    case OpAccessChain:
+                    case OpInBoundsAccessChain: {
+                        AccessChain chain;
+                        uint32_t typeId = types[valueType[op[2]]].element;
+                        uint32_t matrixStride = ptrMatrixStride[op[2]];
+                        for (uint32_t k = 3; k < n; ++k) {
+                            uint32_t indexId = op[k];
+                            const Type& type = types[typeId];
+                            bool known = isConstant[indexId];
+                            bool isSigned = types[valueType[indexId]].isSigned;
+                            int64_t constantIndex = 0;
+                            if (known) {
+                                uint32_t raw = initial[indexId][0];
+                                constantIndex = isSigned ? static_cast<int64_t>(asInt(raw)) : static_cast<int64_t>(raw);
+                            }
+
+                            int64_t stride;
+                            switch (type.kind) {
+                                case TypeKind::Struct:
+                                    if (!known || constantIndex < 0 || constantIndex >= static_cast<int64_t>(type.members.size())) {
+                                        return fail("Struct member index must be a valid constant");
+                                    }
+                                    chain.constantOffset += type.memberOffsets[constantIndex];
+                                    matrixStride = type.memberMatrixStride[constantIndex];
+                                    typeId = type.members[constantIndex];
+                                    continue;
+                                case TypeKind::Array:
+                                case TypeKind::RuntimeArray:
+                                    stride = type.arrayStride;
+                                    break;
+                                case TypeKind::Matrix:
+                                    stride = matrixStride ? matrixStride : types[type.element].size;
+                                    break;
+                                case TypeKind::Vector:
+                                    stride = sizeof(uint32_t);
+                                    break;
+                                default:
+                                    return fail("Access chain indexes into a non-composite type");
+                            }
+                            typeId = type.element;
+                            if (known) {
+                                chain.constantOffset += constantIndex * stride;
+                            } else {
+                                chain.steps.push_back({indexId, stride, isSigned});
+                            }
+                        }
+                        ptrMatrixStride[op[1]] = matrixStride;
+                        instruction.aux = static_cast<uint32_t>(accessChains.size());
+                        accessChains.push_back(std::move(chain));
+                        break;
+                    }
+
+                    case OpCompositeExtract:
+                        instruction.aux = wordOffset(valueType[op[2]], op + 3, n - 3);
+                        break;
+
+                    case OpCompositeInsert:
+                        instruction.aux = wordOffset(op[0], op + 4, n - 4);
+                        break;
+
+                    case OpControlBarrier:
+                        if (function->id != entryId) {
+                            return fail("Barriers are only supported in the entry point function");
+                        }
+                        break;
+
+                    case OpUndef:
+                        initial[op[1]].assign(slotWords[op[1]], 0);
+                        break;
+
+                    default:
+                        break;
+                }
+                function->blocks.back().instructions.push_back(instruction);
+                continue;
+            }
+
+            switch (opcode) {
+                case OpExtInstImport: {
+                    auto name = readString(op + 1, n - 1);
+                    if (name == "GLSL.std.450") {
+                        glslSet = op[0];
+                    } else if (name.rfind("NonSemantic.", 0) == 0) {
+                        nonSemanticSets.push_back(op[0]);
+                    } else {
+                        return fail("Unsupported extended instruction set " + name);
+                    }
+                    break;
+                }
+
+                case OpEntryPoint:
+                    if (!entryId && n >= 2) {
+                        entryId = op[1];
+                    }
+                    break;
+
+                case OpDecorate:
+                    if (n >= 3) {
+                        auto& decoration = decorations[op[0]];
+                        switch (op[1]) {
+                            case DecorationSpecId:        decoration.specId = op[2]; break;
+                            case DecorationArrayStride:   decoration.arrayStride = op[2]; break;
+                            case DecorationBuiltIn:       decoration.builtIn = op[2]; break;
+                            case DecorationBinding:       decoration.binding = op[2]; break;
+                            case DecorationDescriptorSet: decoration.set = op[2]; break;
+                            default: break;
+                        }
+                    }
+                    break;
+
+                case OpMemberDecorate:
+                    if (n >= 3) {
+                        auto& decoration = memberDecorations[{op[0], op[1]}];
+                        if (op[2] == DecorationOffset && n >= 4) {
+                            decoration.offset = op[3];
+                        } else if (op[2] == DecorationMatrixStride && n >= 4) {
+                            decoration.matrixStride = op[3];
+                        } else if (op[2] == DecorationRowMajor) {
+                            decoration.rowMajor = true;
+                        }
+                    }
+                    break;
+
+                case OpTypeVoid:
+                    types[op[0]].kind = TypeKind::Void;
+                    break;
+
+                case OpTypeBool:
+                    types[op[0]] = {.kind = TypeKind::Bool, .words = 1, .size = 4};
+                    break;
+
+                case OpTypeInt:
+                    if (op[1] != 32) {
+                        return fail("Only 32-bit integer types are supported");
+                    }
+                    types[op[0]] = {.kind = TypeKind::Int, .isSigned = op[2] != 0, .words = 1, .size = 4};
+                    break;
+
+                case OpTypeFloat:
+                    if (op[1] != 32) {
+                        return fail("Only 32-bit float types are supported");
+                    }
+                    types[op[0]] = {.kind = TypeKind::Float, .words = 1, .size = 4};
+                    break;
+
+                case OpTypeVector:
+                    types[op[0]] = {.kind = TypeKind::Vector, .isSigned = types[op[1]].isSigned, .element = op[1],
+                                    .count = op[2], .words = op[2], .size = 4 * op[2]};
+                    break;
+
+                case OpTypeMatrix: {
+                    const Type& column = types[op[1]];
+                    types[op[0]] = {.kind = TypeKind::Matrix, .element = op[1], .count = op[2],
+                                    .words = op[2] * column.words, .size = op[2] * column.size};
+                    break;
+                }
+
+                case OpTypeArray:
+                case OpTypeRuntimeArray: {
+                    const Type& element = types[op[1]];
+                    uint32_t stride = decorationsOf(op[0]).arrayStride;
+                    if (!stride) {
+                        stride = element.size;
+                    }
+                    Type type{.kind = TypeKind::RuntimeArray, .element = op[1], .arrayStride = stride};
+                    if (opcode == OpTypeArray) {
+                        if (!isConstant[op[2]]) {
+                            return fail("Array length must be a constant");
+                        }
+                        type.kind = TypeKind::Array;
+                        type.count = initial[op[2]][0];
+                        type.words = type.count * element.words;
+                        type.size = type.count * stride;
+                    }
+                    types[op[0]] = std::move(type);
+                    break;
+                }
+
+                case OpTypeStruct: {
+                    Type type{.kind = TypeKind::Struct};
+                    uint32_t running = 0;
+                    for (uint32_t m = 1; m < n; ++m) {
+                        MemberDecorations decoration;
+                        if (auto it = memberDecorations.find({op[0], m - 1}); it != memberDecorations.end()) {
+                            decoration = it->second;
+                        }
+                        if (decoration.rowMajor) {
+                            return fail("Row-major matrices are not supported");
+                        }
+                        uint32_t offset = decoration.offset != kNoSlot ? decoration.offset : running;
+                        type.members.push_back(op[m]);
+                        type.memberOffsets.push_back(offset);
+                        type.memberMatrixStride.push_back(decoration.matrixStride);
+                        type.memberWords.push_back(type.words);
+                        type.words += types[op[m]].words;
+                        running = offset + accessSize(op[m], decoration.matrixStride);
+                        type.size = std::max(type.size, running);
+                    }
+                    types[op[0]] = std::move(type);
+                    break;
+                }
+
+                case OpTypePointer:
+                    types[op[0]] = {.kind = TypeKind::Pointer, .element = op[2], .storageClass = op[1], .words = 2};
+                    break;
+
+                case OpTypeFunction:
+                    types[op[0]].kind = TypeKind::Function;
+                    break;
+
+                case OpConstantTrue:
+                case OpConstantFalse:
+                case OpSpecConstantTrue:
+                case OpSpecConstantFalse: {
+                    uint32_t value = (opcode == OpConstantTrue || opcode == OpSpecConstantTrue) ? 1 : 0;
+                    if (opcode == OpSpecConstantTrue || opcode == OpSpecConstantFalse) {
+                        value = specValue(op[1], value) ? 1 : 0;
+                    }
+                    setValue(op[1], op[0]);
+                    initial[op[1]] = {value};
+                    isConstant[op[1]] = true;
+                    break;
+                }
+
+                case OpConstant:
+                case OpSpecConstant:
+                    if (n != 3) {
+                        return fail("Only 32-bit constants are supported");
+                    }
+                    setValue(op[1], op[0]);
+                    initial[op[1]] = {opcode == OpSpecConstant ? specValue(op[1], op[2]) : op[2]};
+                    isConstant[op[1]] = true;
+                    break;
+
+                case OpConstantComposite:
+                case OpSpecConstantComposite: {
+                    setValue(op[1], op[0]);
+                    auto& value = initial[op[1]];
+                    for (uint32_t k = 2; k < n; ++k) {
+                        value.insert(value.end(), initial[op[k]].begin(), initial[op[k]].end());
+                    }
+                    isConstant[op[1]] = true;
+                    break;
+                }
+
+                case OpConstantNull:
+                case OpUndef:
+                    setValue(op[1], op[0]);
+                    initial[op[1]].assign(slotWords[op[1]], 0);
+                    isConstant[op[1]] = opcode == OpConstantNull;
+                    break;
+
+                case OpVariable:
+                    if (!addRegion(op[1], op[0], op[2], n > 3 ? op[3] : 0)) {
+                        return false;
+                    }
+                    break;
+
+                case OpFunction:
+                    functionIndex[op[1]] = static_cast<uint32_t>(functions.size());
+                    functions.push_back({op[1], {}, {}});
+                    function = &functions.back();
+                    break;
+
+                case OpSpecConstantOp:
+                    return fail("OpSpecConstantOp is not supported");
+
+                default:
+                    break;
+            }
+        }
+
+        if (!entryId || functionIndex[entryId] == kNoSlot) {
+            return fail("Entry point function not found");
+        }
+        entryFunction = functionIndex[entryId];
+
+        registerImage.assign(static_cast<size_t>(registerWords) * kLanes, 0);
+        for (uint32_t id = 0; id < bound; ++id) {
+            if (slot[id] == kNoSlot || initial[id].size() != slotWords[id]) {
+                continue;
+            }
+            for (uint32_t w = 0; w < slotWords[id]; ++w) {
+                std::fill_n(registerImage.begin() + slot[id] + w * kLanes, kLanes, initial[id][w]);
+            }
+        }
+
+        for (size_t d = 0; d < 3; ++d) {
+            workgroupSize[d] = reflection.localSize[d];
+            if (reflection.localSizeSpecIds[d] >= 0) {
+                if (auto it = specConstants.find(static_cast<uint32_t>(reflection.localSizeSpecIds[d])); it != specConstants.end()) {
+                    workgroupSize[d] = it->second;
+                }
+            }
+            if (workgroupSize[d] == 0) {
+                return fail("Workgroup size must be non-zero");
+            }
+        }
+        return true;
+    }
+
+    // Execution state for one workgroup at a time; each pool task owns one and reuses it
+    struct ComputeInterpreter::Workgroup {
+        struct Span {
+            uint8_t* data = nullptr;
+            size_t   size = 0;
+        };
+
+        // Per-lane program counters of one function activation
+        struct Frame {
+            uint32_t function = 0;
+            uint32_t running = 0;   // lanes that haven't returned
+            uint32_t waiting = 0;   // lanes parked at a barrier
+            uint32_t returnId = 0;  // call result that OpReturnValue writes
+            std::array<uint32_t, kLanes> block{};
+            std::array<uint32_t, kLanes> instruction{};
+            std::array<uint32_t, kLanes> previous{};  // label the lane branched from, for OpPhi
+        };
+
+        struct Subgroup {
+            std::vector<uint32_t> regs;        // value id slot + word * kLanes + lane
+            std::vector<uint8_t>  laneMemory;  // private/function/input variables, laneMemoryBytes per lane
+            uint32_t              live = 0;
+            uint32_t              firstInvocation = 0;
+            Frame                 frame;
+        };
+
+        const Program&           program;
+        const std::vector<Span>& spans;
+        std::array<uint32_t, 3>  groupCount;
+        std::vector<uint8_t>     shared;
+        std::vector<Subgroup>    subgroups;
+        std::vector<uint32_t>    scratch;
+
+        Workgroup(const Program& program, const std::vector<Span>& spans, std::array<uint32_t, 3> groupCount)
+            : program(program)
+            , spans(spans)
+            , groupCount(groupCount)
+            , shared(program.sharedMemoryBytes)
+        {
+            uint32_t invocations = program.workgroupSize[0] * program.workgroupSize[1] * program.workgroupSize[2];
+            subgroups.resize((invocations + kLanes - 1) / kLanes);
+            for (size_t s = 0; s < subgroups.size(); ++s) {
+                auto& subgroup = subgroups[s];
+                subgroup.regs = program.registerImage;
+                subgroup.laneMemory.assign(static_cast<size_t>(program.laneMemoryBytes) * kLanes, 0);
+                subgroup.firstInvocation = static_cast<uint32_t>(s * kLanes);
+                uint32_t lanes = std::min(kLanes, invocations - subgroup.firstInvocation);
+                subgroup.live = lanes == 32 ? 0xFFFFFFFFu : (1u << lanes) - 1;
+            }
+        }
+
+        uint32_t* reg(Subgroup& subgroup, uint32_t id) {
+            return subgroup.regs.data() + program.slot[id];
+        }
+
+        uint8_t* laneMemory(Subgroup& subgroup, uint32_t lane) {
+            return subgroup.laneMemory.data() + static_cast<size_t>(lane) * program.laneMemoryBytes;
+        }
+
+        // Memory behind a pointer value, or nullptr when the access would leave its region
+        uint8_t* resolve(Subgroup& subgroup, uint32_t lane, uint32_t region, uint32_t offset, uint32_t size) {
+            if (offset == kNullOffset || region >= program.regions.size()) {
+                return nullptr;
+            }
+            const Region& r = program.regions[region];
+            size_t limit = r.kind == RegionKind::Host ? spans[region].size : r.size;
+            if (offset > limit || size > limit - offset) {
+                return nullptr;
+            }
+            switch (r.kind) {
+                case RegionKind::Host:      return spans[region].data + offset;
+                case RegionKind::Workgroup: return shared.data() + r.offset + offset;
+                default:                    return laneMemory(subgroup, lane) + r.offset + offset;
+            }
+        }
+
+        void run(std::array<uint32_t, 3> groupId) {
+            for (uint32_t s = 0; s < subgroups.size(); ++s) {
+                auto& subgroup = subgroups[s];
+                writeBuiltIns(subgroup, s, groupId);
+                for (uint32_t index : program.privateRegions) {
+                    const Region& region = program.regions[index];
+                    const uint32_t* value = reg(subgroup, region.initializer);
+                    forLanes(subgroup.live, [&](uint32_t lane) {
+                        program.storeMemory(region.pointee, laneMemory(subgroup, lane) + region.offset, value + lane, 0);
+                    });
+                }
+                subgroup.frame = {};
+                subgroup.frame.function = program.entryFunction;
+                subgroup.frame.running = subgroup.live;
+            }
+
+            // Run every subgroup until it finishes or all its lanes wait at a barrier,
+            // then release the barrier once the whole workgroup has arrived
+            for (;;) {
+                bool running = false;
+                for (auto& subgroup : subgroups) {
+                    if (subgroup.frame.running) {
+                        runFrame(subgroup, subgroup.frame);
+                        running |= subgroup.frame.running != 0;
+                    }
+                }
+                if (!running) {
+                    break;
+                }
+                for (auto& subgroup : subgroups) {
+                    subgroup.frame.waiting = 0;
+                }
+            }
+        }
+
+        void writeBuiltIns(Subgroup& subgroup, uint32_t subgroupIndex, std::array<uint32_t, 3> groupId) {
+            const auto& size = program.workgroupSize;
+            for (uint32_t index : program.builtInRegions) {
+                const Region& region = program.regions[index];
+                forLanes(subgroup.live, [&](uint32_t lane) {
+                    uint32_t local = subgroup.firstInvocation + lane;
+                    std::array<uint32_t, 3> localId{local % size[0], (local / size[0]) % size[1], local / (size[0] * size[1])};
+                    std::array<uint32_t, 3> value{0, 0, 0};
+                    switch (region.builtIn) {
+                        case BuiltInNumWorkgroups:        value = groupCount; break;
+                        case BuiltInWorkgroupId:          value = groupId; break;
+                        case BuiltInLocalInvocationId:    value = localId; break;
+                        case BuiltInGlobalInvocationId:
+                            for (size_t d = 0; d < 3; ++d) {
+                                value[d] = groupId[d] * size[d] + localId[d];
+                            }
+                            break;
+                        case BuiltInLocalInvocationIndex: value[0] = local; break;
+                        case BuiltInSubgroupSize:         value[0] = kLanes; break;
+                        case BuiltInNumSubgroups:         value[0] = static_cast<uint32_t>(subgroups.size()); break;
+                        case BuiltInSubgroupId:           value[0] = subgroupIndex; break;
+                        case BuiltInSubgroupLocalInvocationId: value[0] = lane; break;
+                        default: break;
+                    }
+                    memcpy(laneMemory(subgroup, lane) + region.offset, value.data(), std::min<size_t>(region.size, sizeof(value)));
+                });
+            }
+        }
+
+        // Run a frame's lanes until they all return or wait at a barrier. Lanes sharing the
+        // lowest program counter go together, so diverged lanes rejoin at merge blocks
+        void runFrame(Subgroup& subgroup, Frame& frame) {
+            for (;;) {
+                uint32_t ready = frame.running & ~frame.waiting;
+                if (!ready) {
+                    return;
+                }
+                uint64_t lowest = UINT64_MAX;
+                for (uint32_t m = ready; m; m &= m - 1) {
+                    uint32_t lane = static_cast<uint32_t>(std::countr_zero(m));
+                    lowest = std::min(lowest, (static_cast<uint64_t>(frame.block[lane]) << 32) | frame.instruction[lane]);
+                }
+                uint32_t mask = 0;
+                for (uint32_t m = ready; m; m &= m - 1) {
+                    uint32_t lane = static_cast<uint32_t>(std::countr_zero(m));
+                    if (((static_cast<uint64_t>(frame.block[lane]) << 32) | frame.instruction[lane]) == lowest) {
+                        mask |= 1u << lane;
+                    }
+                }
+                executeBlock(subgroup, frame, mask, static_cast<uint32_t>(lowest >> 32), static_cast<uint32_t>(lowest));
+            }
+        }
+
+        void jump(Frame& frame, uint32_t mask, uint32_t label, uint32_t from) {
+            uint32_t target = program.blockIndex[label];
+            forLanes(mask, [&](uint32_t lane) {
+                frame.block[lane] = target;
+                frame.instruction[lane] = 0;
+                frame.previous[lane] = from;
+            });
+        }
+
+        void executeBlock(Subgroup& subgroup, Frame& frame, uint32_t mask, uint32_t blockIndex, uint32_t start) {
+            const Block& block = program.functions[frame.function].blocks[blockIndex];
+            const auto& instructions = block.instructions;
+
+            for (size_t i = start; i < instructions.size(); ++i) {
+                const Instruction& instruction = instructions[i];
+                const uint32_t* op = instruction.op;
+
+                switch (instruction.opcode) {
+                    case OpPhi:
+                        i = executePhis(subgroup, frame, mask, instructions, i) - 1;
+                        break;
+
+                    case OpBranch:
+                        jump(frame, mask, op[0], block.label);
+                        return;
+
+                    case OpBranchConditional: {
+                        const uint32_t* condition = reg(subgroup, op[0]);
+                        uint32_t taken = 0;
+                        forLanes(mask, [&](uint32_t lane) {
+                            taken |= condition[lane] ? 1u << lane : 0u;
+                        });
+                        jump(frame, taken, op[1], block.label);
+                        jump(frame, mask & ~taken, op[2], block.label);
+                        return;
+                    }
+
+                    case OpSwitch: {
+                        const uint32_t* selector = reg(subgroup, op[0]);
+                        forLanes(mask, [&](uint32_t lane) {
+                            uint32_t target = op[1];
+                            for (uint32_t k = 2; k + 1 < instruction.count; k += 2) {
+                                if (selector[lane] == op[k]) {
+                                    target = op[k + 1];
+                                    break;
+                                }
+                            }
+                            jump(frame, 1u << lane, target, block.label);
+                        });
+                        return;
+                    }
+
+                    case OpReturnValue:
+                        if (frame.returnId && program.slot[frame.returnId] != kNoSlot) {
+                            copyValue(subgroup, frame.returnId, op[0], mask);
+                        }
+                        frame.running &= ~mask;
+                        return;
+
+                    case OpReturn:
+                    case OpKill:
+                    case OpUnreachable:
+                        frame.running &= ~mask;
+                        return;
+
+                    case OpControlBarrier:
+                        forLanes(mask, [&](uint32_t lane) {
+                            frame.instruction[lane] = static_cast<uint32_t>(i + 1);
+                        });
+                        frame.waiting |= mask;
+                        return;
+
+                    case OpFunctionCall:
+                        call(subgroup, mask, instruction);
+                        break;
+
+                    default:
+                        execute(subgroup, mask, instruction);
+                        break;
+                }
+            }
+        }
+
+        // A block's leading phis read every incoming value before any is written, like one parallel copy
+        size_t executePhis(Subgroup& subgroup, Frame& frame, uint32_t mask, const std::vector<Instruction>& instructions, size_t first) {
+            size_t end = first;
+            while (end < instructions.size() && instructions[end].opcode == OpPhi) {
+                ++end;
+            }
+
+            scratch.clear();
+            for (size_t i = first; i < end; ++i) {
+                const Instruction& phi = instructions[i];
+                uint32_t words = program.slotWords[phi.op[1]];
+                forLanes(mask, [&](uint32_t lane) {
+                    uint32_t source = 0;
+                    for (uint32_t k = 2; k + 1 < phi.count; k += 2) {
+                        if (phi.op[k + 1] == frame.previous[lane]) {
+                            source = phi.op[k];
+                            break;
+                        }
+                    }
+                    const uint32_t* value = source && program.slot[source] != kNoSlot ? reg(subgroup, source) : nullptr;
+                    for (uint32_t w = 0; w < words; ++w) {
+                        scratch.push_back(value ? value[w * kLanes + lane] : 0);
+                    }
+                });
+            }
+
+            size_t position = 0;
+            for (size_t i = first; i < end; ++i) {
+                const Instruction& phi = instructions[i];
+                uint32_t words = program.slotWords[phi.op[1]];
+                uint32_t* result = reg(subgroup, phi.op[1]);
+                forLanes(mask, [&](uint32_t lane) {
+                    for (uint32_t w = 0; w < words; ++w) {
+                        result[w * kLanes + lane] = scratch[position++];
+                    }
+                });
+            }
+            return end;
+        }
+
+        // Calls run to completion for the calling lanes before the caller continues
+        void call(Subgroup& subgroup, uint32_t mask, const Instruction& instruction) {
+            const uint32_t* op = instruction.op;
+            uint32_t calleeIndex = program.functionIndex[op[2]];
+            const Function& callee = program.functions[calleeIndex];
+            for (size_t p = 0; p < callee.params.size() && 3 + p < instruction.count; ++p) {
+                copyValue(subgroup, callee.params[p], op[3 + p], mask);
+            }
+
+            Frame frame;
+            frame.function = calleeIndex;
+            frame.running = mask;
+            frame.returnId = op[1];
+            runFrame(subgroup, frame);
+        }
+
+        void copyValue(Subgroup& subgroup, uint32_t destination, uint32_t source, uint32_t mask) {
+            uint32_t words = program.slotWords[destination];
+            if (!words || program.slot[source] == kNoSlot) {
+                return;
+            }
+            copyWords(reg(subgroup, destination), reg(subgroup, source), words, mask);
+        }
+
+        static void copyWords(uint32_t* destination, const uint32_t* source, uint32_t words, uint32_t mask) {
+            for (uint32_t w = 0; w < words; ++w) {
+                uint32_t* d = destination + w * kLanes;
+                const uint32_t* s = source + w * kLanes;
+                forLanes(mask, [&](uint32_t lane) { d[lane] = s[lane]; });
+            }
+        }
+
+        template<typename F>
+        void unary(Subgroup& subgroup, uint32_t mask, uint32_t result, uint32_t a, F f) {
+            uint32_t words = program.slotWords[result];
+            uint32_t* d = reg(subgroup, result);
+            const uint32_t* x = reg(subgroup, a);
+            for (uint32_t c = 0; c < words; ++c) {
+                uint32_t* dc = d + c * kLanes;
+                const uint32_t* xc = x + c * kLanes;
+                forLanes(mask, [&](uint32_t lane) { dc[lane] = f(xc[lane]); });
+            }
+        }
+
+        template<typename F>
+        void binary(Subgroup& subgroup, uint32_t mask, uint32_t result, uint32_t a, uint32_t b, F f) {
+            uint32_t words = program.slotWords[result];
+            uint32_t* d = reg(subgroup, result);
+            const uint32_t* x = reg(subgroup, a);
+            const uint32_t* y = reg(subgroup, b);
+            for (uint32_t c = 0; c < words; ++c) {
+                uint32_t* dc = d + c * kLanes;
+                const uint32_t* xc = x + c * kLanes;
+                const uint32_t* yc = y + c * kLanes;
+                forLanes(mask, [&](uint32_t lane) { dc[lane] = f(xc[lane], yc[lane]); });
+            }
+        }
+
+        template<typename F>
+        void ternary(Subgroup& subgroup, uint32_t mask, uint32_t result, uint32_t a, uint32_t b, uint32_t c3, F f) {
+            uint32_t words = program.slotWords[result];
+            uint32_t* d = reg(subgroup, result);
+            const uint32_t* x = reg(subgroup, a);
+            const uint32_t* y = reg(subgroup, b);
+            const uint32_t* z = reg(subgroup, c3);
+            for (uint32_t c = 0; c < words; ++c) {
+                uint32_t* dc = d + c * kLanes;
+                const uint32_t* xc = x + c * kLanes;
+                const uint32_t* yc = y + c * kLanes;
+                const uint32_t* zc = z + c * kLanes;
+                forLanes(mask, [&](uint32_t lane) { dc[lane] = f(xc[lane], yc[lane], zc[lane]); });
+            }
+        }
+
+        static float dot(const uint32_t* a, const uint32_t* b, uint32_t components, uint32_t lane) {
+            float sum = 0.0f;
+            for (uint32_t c = 0; c < components; ++c) {
+                sum += asFloat(a[c * kLanes + lane]) * asFloat(b[c * kLanes + lane]);
+            }
+            return sum;
+        }
+
+        void execute(Subgroup& subgroup, uint32_t mask, const Instruction& instruction);
+        void load(Subgroup& subgroup, uint32_t mask, uint32_t typeId, uint32_t result, uint32_t pointer);
+        void store(Subgroup& subgroup, uint32_t mask, uint32_t pointer, uint32_t object);
+        void atomic(Subgroup& subgroup, uint32_t mask, const Instruction& instruction);
+        void glsl(Subgroup& subgroup, uint32_t mask, const Instruction& instruction);
+    };
+
+    void ComputeInterpreter::Workgroup::load(Subgroup& subgroup, uint32_t mask, uint32_t typeId, uint32_t result, uint32_t pointer) {
+        const uint32_t* p = reg(subgroup, pointer);
+        uint32_t* d = reg(subgroup, result);
+        uint32_t matrixStride = program.ptrMatrixStride[pointer];
+        uint32_t size = program.accessSize(typeId, matrixStride);
+        uint32_t words = program.slotWords[result];
+        TypeKind kind = program.types[typeId].kind;
+        bool scalar = kind == TypeKind::Int || kind == TypeKind::Float || kind == TypeKind::Bool;
+
+        forLanes(mask, [&](uint32_t lane) {
+            const uint8_t* source = resolve(subgroup, lane, p[lane], p[kLanes + lane], size);
+            if (!source) {
+                for (uint32_t w = 0; w < words; ++w) {
+                    d[w * kLanes + lane] = 0;
+                }
+            } else if (scalar) {
+                memcpy(d + lane, source, sizeof(uint32_t));
+            } else {
+                program.loadMemory(typeId, source, d + lane, matrixStride);
+            }
+        });
+    }
+
+    void ComputeInterpreter::Workgroup::store(Subgroup& subgroup, uint32_t mask, uint32_t pointer, uint32_t object) {
+        const uint32_t* p = reg(subgroup, pointer);
+        const uint32_t* value = reg(subgroup, object);
+        uint32_t typeId = program.valueType[object];
+        uint32_t matrixStride = program.ptrMatrixStride[pointer];
+        uint32_t size = program.accessSize(typeId, matrixStride);
+
+        forLanes(mask, [&](uint32_t lane) {
+            if (uint8_t* target = resolve(subgroup, lane, p[lane], p[kLanes + lane], size)) {
+                program.storeMemory(typeId, target, value + lane, matrixStride);
+            }
+        });
+    }
+
+    void ComputeInterpreter::Workgroup::atomic(Subgroup& subgroup, uint32_t mask, const Instruction& instruction) {
+        const uint32_t* op = instruction.op;
+        uint16_t opcode = instruction.opcode;
+        bool isStore = opcode == OpAtomicStore;
+        const uint32_t* p = reg(subgroup, isStore ? op[0] : op[2]);
+        uint32_t* d = isStore ? nullptr : reg(subgroup, op[1]);
+
+        uint32_t valueId = 0;
+        if (isStore) {
+            valueId = op[3];
+        } else if (opcode == OpAtomicCompareExchange) {
+            valueId = op[7];
+        } else if (instruction.count > 5) {
+            valueId = op[5];
+        }
+        const uint32_t* value = valueId ? reg(subgroup, valueId) : nullptr;
+        const uint32_t* comparator = opcode == OpAtomicCompareExchange ? reg(subgroup, op[8]) : nullptr;
+
+        forLanes(mask, [&](uint32_t lane) {
+            uint8_t* memory = resolve(subgroup, lane, p[lane], p[kLanes + lane], sizeof(uint32_t));
+            if (!memory) {
+                if (d) {
+                    d[lane] = 0;
+                }
+                return;
+            }
+            std::atomic_ref<uint32_t> target(*reinterpret_cast<uint32_t*>(memory));
+            uint32_t v = value ? value[lane] : 0;
+            auto update = [&](auto combine) {
+                uint32_t old = target.load();
+                while (!target.compare_exchange_weak(old, combine(old))) {
+                }
+                return old;
+            };
+
+            uint32_t old = 0;
+            switch (opcode) {
+                case OpAtomicLoad:       old = target.load(); break;
+                case OpAtomicStore:      target.store(v); return;
+                case OpAtomicExchange:   old = target.exchange(v); break;
+                case OpAtomicCompareExchange:
+                    old = comparator[lane];
+                    target.compare_exchange_strong(old, v);
+                    break;
+                case OpAtomicIIncrement: old = target.fetch_add(1); break;
+                case OpAtomicIDecrement: old = target.fetch_sub(1); break;
+                case OpAtomicIAdd:       old = target.fetch_add(v); break;
+                case OpAtomicISub:       old = target.fetch_sub(v); break;
+                case OpAtomicAnd:        old = target.fetch_and(v); break;
+                case OpAtomicOr:         old = target.fetch_or(v); break;
+                case OpAtomicXor:        old = target.fetch_xor(v); break;
+                case OpAtomicUMin:       old = update([&](uint32_t x) { return std::min(x, v); }); break;
+                case OpAtomicUMax:       old = update([&](uint32_t x) { return std::max(x, v); }); break;
+                case OpAtomicSMin:       old = update([&](uint32_t x) { return fromInt(std::min(asInt(x), asInt(v))); }); break;
+                case OpAtomicSMax:       old = update([&](uint32_t x) { return fromInt(std::max(asInt(x), asInt(v))); }); break;
+                default: break;
+            }
+            d[lane] = old;
+        });
+    }
+
+    void ComputeInterpreter::Workgroup::glsl(Subgroup& subgroup, uint32_t mask, const Instruction& instruction) {
+        const uint32_t* op = instruction.op;
+        uint32_t result = op[1];
+        const uint32_t* args = op + 4;
+        uint32_t* d = reg(subgroup, result);
+
+        auto f1 = [&](auto fn) {
+            unary(subgroup, mask, result, args[0], [&](uint32_t x) { return fromFloat(fn(asFloat(x))); });
+        };
+        auto f2 = [&](auto fn) {
+            binary(subgroup, mask, result, args[0], args[1], [&](uint32_t x, uint32_t y) {
+                return fromFloat(fn(asFloat(x), asFloat(y)));
+            });
+        };
+        auto f3 = [&](auto fn) {
+            ternary(subgroup, mask, result, args[0], args[1], args[2], [&](uint32_t x, uint32_t y, uint32_t z) {
+                return fromFloat(fn(asFloat(x), asFloat(y), asFloat(z)));
+            });
+        };
+        constexpr float kPi = 3.14159265358979323846f;
+
+        switch (op[3]) {
+            case GlslRound:       f1([](float x) { return std::round(x); }); break;
+            case GlslRoundEven:   f1([](float x) { return std::nearbyint(x); }); break;
+            case GlslTrunc:       f1([](float x) { return std::trunc(x); }); break;
+            case GlslFAbs:        f1([](float x) { return std::fabs(x); }); break;
+            case GlslFSign:       f1([](float x) { return x > 0.0f ? 1.0f : (x < 0.0f ? -1.0f : 0.0f); }); break;
+            case GlslFloor:       f1([](float x) { return std::floor(x); }); break;
+            case GlslCeil:        f1([](float x) { return std::ceil(x); }); break;
+            case GlslFract:       f1([](float x) { return x - std::floor(x); }); break;
+            case GlslRadians:     f1([=](float x) { return x * (kPi / 180.0f); }); break;
+            case GlslDegrees:     f1([=](float x) { return x * (180.0f / kPi); }); break;
+            case GlslSin:         f1([](float x) { return std::sin(x); }); break;
+            case GlslCos:         f1([](float x) { return std::cos(x); }); break;
+            case GlslTan:         f1([](float x) { return std::tan(x); }); break;
+            case GlslAsin:        f1([](float x) { return std::asin(x); }); break;
+            case GlslAcos:        f1([](float x) { return std::acos(x); }); break;
+            case GlslAtan:        f1([](float x) { return std::atan(x); }); break;
+            case GlslSinh:        f1([](float x) { return std::sinh(x); }); break;
+            case GlslCosh:        f1([](float x) { return std::cosh(x); }); break;
+            case GlslTanh:        f1([](float x) { return std::tanh(x); }); break;
+            case GlslAsinh:       f1([](float x) { return std::asinh(x); }); break;
+            case GlslAcosh:       f1([](float x) { return std::acosh(x); }); break;
+            case GlslAtanh:       f1([](float x) { return std::atanh(x); }); break;
+            case GlslAtan2:       f2([](float y, float x) { return std::atan2(y, x); }); break;
+            case GlslPow:         f2([](float x, float y) { return std::pow(x, y); }); break;
+            case GlslExp:         f1([](float x) { return std::exp(x); }); break;
+            case GlslLog:         f1([](float x) { return std::log(x); }); break;
+            case GlslExp2:        f1([](float x) { return std::exp2(x); }); break;
+            case GlslLog2:        f1([](float x) { return std::log2(x); }); break;
+            case GlslSqrt:        f1([](float x) { return std::sqrt(x); }); break;
+            case GlslInverseSqrt: f1([](float x) { return 1.0f / std::sqrt(x); }); break;
+            case GlslFMin:
+            case GlslNMin:        f2([](float x, float y) { return std::fmin(x, y); }); break;
+            case GlslFMax:
+            case GlslNMax:        f2([](float x, float y) { return std::fmax(x, y); }); break;
+            case GlslFClamp:
+            case GlslNClamp:      f3([](float x, float lo, float hi) { return std::fmin(std::fmax(x, lo), hi); }); break;
+            case GlslFMix:        f3([](float x, float y, float a) { return x * (1.0f - a) + y * a; }); break;
+            case GlslStep:        f2([](float edge, float x) { return x < edge ? 0.0f : 1.0f; }); break;
+            case GlslSmoothStep:
+                f3([](float edge0, float edge1, float x) {
+                    float t = std::fmin(std::fmax((x - edge0) / (edge1 - edge0), 0.0f), 1.0f);
+                    return t * t * (3.0f - 2.0f * t);
+                });
+                break;
+            case GlslFma:         f3([](float a, float b, float c) { return std::fma(a, b, c); }); break;
+
+            case GlslSAbs:
+                unary(subgroup, mask, result, args[0], [](uint32_t x) { return asInt(x) < 0 ? 0u - x : x; });
+                break;
+            case GlslSSign:
+                unary(subgroup, mask, result, args[0], [](uint32_t x) {
+                    return fromInt(asInt(x) > 0 ? 1 : (asInt(x) < 0 ? -1 : 0));
+                });
+                break;
+            case GlslUMin: binary(subgroup, mask, result, args[0], args[1], [](uint32_t x, uint32_t y) { return std::min(x, y); }); break;
+            case GlslUMax: binary(subgroup, mask, result, args[0], args[1], [](uint32_t x, uint32_t y) { return std::max(x, y); }); break;
+            case GlslSMin:
+                binary(subgroup, mask, result, args[0], args[1], [](uint32_t x, uint32_t y) { return fromInt(std::min(asInt(x), asInt(y))); });
+                break;
+            case GlslSMax:
+                binary(subgroup, mask, result, args[0], args[1], [](uint32_t x, uint32_t y) { return fromInt(std::max(asInt(x), asInt(y))); });
+                break;
+            case GlslUClamp:
+                ternary(subgroup, mask, result, args[0], args[1], args[2], [](uint32_t x, uint32_t lo, uint32_t hi) {
+                    return std::min(std::max(x, lo), hi);
+                });
+                break;
+            case GlslSClamp:
+                ternary(subgroup, mask, result, args[0], args[1], args[2], [](uint32_t x, uint32_t lo, uint32_t hi) {
+                    return fromInt(std::min(std::max(asInt(x), asInt(lo)), asInt(hi)));
+                });
+                break;
+            case GlslLdexp:
+                binary(subgroup, mask, result, args[0], args[1], [](uint32_t x, uint32_t e) {
+                    return fromFloat(std::ldexp(asFloat(x), asInt(e)));
+                });
+                break;
+            case GlslFindILsb:
+                unary(subgroup, mask, result, args[0], [](uint32_t x) {
+                    return x ? static_cast<uint32_t>(std::countr_zero(x)) : 0xFFFFFFFFu;
+                });
+                break;
+            case GlslFindSMsb:
+                unary(subgroup, mask, result, args[0], [](uint32_t x) {
+                    uint32_t bits = asInt(x) < 0 ? ~x : x;
+                    return bits ? static_cast<uint32_t>(31 - std::countl_zero(bits)) : 0xFFFFFFFFu;
+                });
+                break;
+            case GlslFindUMsb:
+                unary(subgroup, mask, result, args[0], [](uint32_t x) {
+                    return x ? static_cast<uint32_t>(31 - std::countl_zero(x)) : 0xFFFFFFFFu;
+                });
+                break;
+
+            case GlslLength:
+            case GlslDistance: {
+                uint32_t n = program.slotWords[args[0]];
+                const uint32_t* a = reg(subgroup, args[0]);
+                const uint32_t* b = op[3] == GlslDistance ? reg(subgroup, args[1]) : nullptr;
+                forLanes(mask, [&](uint32_t lane) {
+                    float sum = 0.0f;
+                    for (uint32_t c = 0; c < n; ++c) {
+                        float v = asFloat(a[c * kLanes + lane]) - (b ? asFloat(b[c * kLanes + lane]) : 0.0f);
+                        sum += v * v;
+                    }
+                    d[lane] = fromFloat(std::sqrt(sum));
+                });
+                break;
+            }
+            case GlslCross: {
+                const uint32_t* a = reg(subgroup, args[0]);
+                const uint32_t* b = reg(subgroup, args[1]);
+                forLanes(mask, [&](uint32_t lane) {
+                    auto x = [&](const uint32_t* v, uint32_t c) { return asFloat(v[c * kLanes + lane]); };
+                    d[0 * kLanes + lane] = fromFloat(x(a, 1) * x(b, 2) - x(b, 1) * x(a, 2));
+                    d[1 * kLanes + lane] = fromFloat(x(a, 2) * x(b, 0) - x(b, 2) * x(a, 0));
+                    d[2 * kLanes + lane] = fromFloat(x(a, 0) * x(b, 1) - x(b, 0) * x(a, 1));
+                });
+                break;
+            }
+            case GlslNormalize: {
+                uint32_t n = program.slotWords[result];
+                const uint32_t* a = reg(subgroup, args[0]);
+                forLanes(mask, [&](uint32_t lane) {
+                    float length = std::sqrt(dot(a, a, n, lane));
+                    for (uint32_t c = 0; c < n; ++c) {
+                        d[c * kLanes + lane] = fromFloat(asFloat(a[c * kLanes + lane]) / length);
+                    }
+                });
+                break;
+            }
+            case GlslFaceForward: {
+                uint32_t n = program.slotWords[result];
+                const uint32_t* normal = reg(subgroup, args[0]);
+                const uint32_t* incident = reg(subgroup, args[1]);
+                const uint32_t* reference = reg(subgroup, args[2]);
+                forLanes(mask, [&](uint32_t lane) {
+                    float sign = dot(reference, incident, n, lane) < 0.0f ? 1.0f : -1.0f;
+                    for (uint32_t c = 0; c < n; ++c) {
+                        d[c * kLanes + lane] = fromFloat(sign * asFloat(normal[c * kLanes + lane]));
+                    }
+                });
+                break;
+            }
+            case GlslReflect:
+            case GlslRefract: {
+                uint32_t n = program.slotWords[result];
+                const uint32_t* incident = reg(subgroup, args[0]);
+                const uint32_t* normal = reg(subgroup, args[1]);
+                const uint32_t* eta = op[3] == GlslRefract ? reg(subgroup, args[2]) : nullptr;
+                forLanes(mask, [&](uint32_t lane) {
+                    float ni = dot(normal, incident, n, lane);
+                    float scaleI = 1.0f;
+                    float scaleN = 2.0f * ni;
+                    if (eta) {
+                        float e = asFloat(eta[lane]);
+                        float k = 1.0f - e * e * (1.0f - ni * ni);
+                        scaleI = k < 0.0f ? 0.0f : e;
+                        scaleN = k < 0.0f ? 0.0f : e * ni + std::sqrt(k);
+                    }
+                    for (uint32_t c = 0; c < n; ++c) {
+                        float value = scaleI * asFloat(incident[c * kLanes + lane]) - scaleN * asFloat(normal[c * kLanes + lane]);
+                        d[c * kLanes + lane] = fromFloat(value);
+                    }
+                });
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    void ComputeInterpreter::Workgroup::execute(Subgroup& subgroup, uint32_t mask, const Instruction& instruction) {
+        const uint32_t* op = instruction.op;
+        uint32_t n = instruction.count;
+
+        auto u1 = [&](auto fn) { unary(subgroup, mask, op[1], op[2], fn); };
+        auto u2 = [&](auto fn) { binary(subgroup, mask, op[1], op[2], op[3], fn); };
+        auto f2 = [&](auto fn) {
+            binary(subgroup, mask, op[1], op[2], op[3], [&](uint32_t x, uint32_t y) { return fromFloat(fn(asFloat(x), asFloat(y))); });
+        };
+        auto s2 = [&](auto fn) {
+            binary(subgroup, mask, op[1], op[2], op[3], [&](uint32_t x, uint32_t y) { return fn(asInt(x), asInt(y)); });
+        };
+        auto fcmp = [&](auto fn) {
+            binary(subgroup, mask, op[1], op[2], op[3], [&](uint32_t x, uint32_t y) { return fn(asFloat(x), asFloat(y)) ? 1u : 0u; });
+        };
+
+        switch (instruction.opcode) {
+            case OpVariable:
+                if (n > 3) {
+                    const Region& region = program.regions[instruction.aux];
+                    const uint32_t* value = reg(subgroup, op[3]);
+                    forLanes(mask, [&](uint32_t lane) {
+                        program.storeMemory(region.pointee, laneMemory(subgroup, lane) + region.offset, value + lane, 0);
+                    });
+                }
+                break;
+
+            case OpLoad:
+                load(subgroup, mask, op[0], op[1], op[2]);
+                break;
+
+            case OpStore:
+                store(subgroup, mask, op[0], op[1]);
+                break;
+
+            case OpCopyMemory: {
+                uint32_t typeId = program.types[program.valueType[op[1]]].element;
+                uint32_t words = program.types[typeId].words;
+                const uint32_t* target = reg(subgroup, op[0]);
+                const uint32_t* source = reg(subgroup, op[1]);
+                uint32_t sourceStride = program.ptrMatrixStride[op[1]];
+                uint32_t targetStride = program.ptrMatrixStride[op[0]];
+                scratch.assign(static_cast<size_t>(words) * kLanes, 0);
+                forLanes(mask, [&](uint32_t lane) {
+                    if (auto from = resolve(subgroup, lane, source[lane], source[kLanes + lane], program.accessSize(typeId, sourceStride))) {
+                        program.loadMemory(typeId, from, scratch.data() + lane, sourceStride);
+                    }
+                    if (auto to = resolve(subgroup, lane, target[lane], target[kLanes + lane], program.accessSize(typeId, targetStride))) {
+                        program.storeMemory(typeId, to, scratch.data() + lane, targetStride);
+                    }
+                });
+                break;
+            }
+
+            case OpAccessChain:
+            case OpInBoundsAccessChain: {
+                const AccessChain& chain = program.accessChains[instruction.aux];
+                const uint32_t* base = reg(subgroup, op[2]);
+                uint32_t* d = reg(subgroup, op[1]);
+                forLanes(mask, [&](uint32_t lane) {
+                    d[lane] = base[lane];
+                    if (base[kLanes + lane] == kNullOffset) {
+                        d[kLanes + lane] = kNullOffset;
+                        return;
+                    }
+                    int64_t offset = static_cast<int64_t>(base[kLanes + lane]) + chain.constantOffset;
+                    for (const auto& step : chain.steps) {
+                        uint32_t raw = reg(subgroup, step.index)[lane];
+                        int64_t index = step.isSigned ? static_cast<int64_t>(asInt(raw)) : static_cast<int64_t>(raw);
+                        offset += index * step.stride;
+                    }
+                    bool outside = offset < 0 || offset >= static_cast<int64_t>(kNullOffset);
+                    d[kLanes + lane] = outside ? kNullOffset : static_cast<uint32_t>(offset);
+                });
+                break;
+            }
+
+            case OpArrayLength: {
+                const Type& block = program.types[program.types[program.valueType[op[2]]].element];
+                uint64_t memberOffset = block.memberOffsets[op[3]];
+                uint32_t stride = program.types[block.members[op[3]]].arrayStride;
+                const uint32_t* p = reg(subgroup, op[2]);
+                uint32_t* d = reg(subgroup, op[1]);
+                forLanes(mask, [&](uint32_t lane) {
+                    uint32_t region = p[lane];
+                    uint64_t size = 0;
+                    if (region < program.regions.size()) {
+                        size = program.regions[region].kind == RegionKind::Host ? spans[region].size : program.regions[region].size;
+                    }
+                    uint64_t begin = static_cast<uint64_t>(p[kLanes + lane]) + memberOffset;
+                    bool valid = p[kLanes + lane] != kNullOffset && stride && size > begin;
+                    d[lane] = valid ? static_cast<uint32_t>((size - begin) / stride) : 0;
+                });
+                break;
+            }
+
+            case OpCompositeConstruct: {
+                uint32_t* d = reg(subgroup, op[1]);
+                uint32_t position = 0;
+                for (uint32_t k = 2; k < n; ++k) {
+                    uint32_t words = program.slotWords[op[k]];
+                    copyWords(d + position * kLanes, reg(subgroup, op[k]), words, mask);
+                    position += words;
+                }
+                break;
+            }
+
+            case OpCompositeExtract:
+                copyWords(reg(subgroup, op[1]), reg(subgroup, op[2]) + instruction.aux * kLanes, program.slotWords[op[1]], mask);
+                break;
+
+            case OpCompositeInsert:
+                copyValue(subgroup, op[1], op[3], mask);
+                copyWords(reg(subgroup, op[1]) + instruction.aux * kLanes, reg(subgroup, op[2]), program.slotWords[op[2]], mask);
+                break;
+
+            case OpCopyObject:
+            case OpCopyLogical:
+            case OpBitcast:
+            case OpUConvert:
+            case OpSConvert:
+            case OpFConvert:
+                copyValue(subgroup, op[1], op[2], mask);
+                break;
+
+            case OpVectorShuffle: {
+                uint32_t firstCount = program.slotWords[op[2]];
+                uint32_t* d = reg(subgroup, op[1]);
+                for (uint32_t c = 0; c + 4 < n; ++c) {
+                    uint32_t select = op[4 + c];
+                    uint32_t* dc = d + c * kLanes;
+                    if (select == 0xFFFFFFFF) {
+                        forLanes(mask, [&](uint32_t lane) { dc[lane] = 0; });
+                        continue;
+                    }
+                    const uint32_t* source = select < firstCount ? reg(subgroup, op[2]) + select * kLanes
+                                                                 : reg(subgroup, op[3]) + (select - firstCount) * kLanes;
+                    copyWords(dc, source, 1, mask);
+                }
+                break;
+            }
+
+            case OpVectorExtractDynamic: {
+                uint32_t components = program.slotWords[op[2]];
+                const uint32_t* vector = reg(subgroup, op[2]);
+                const uint32_t* index = reg(subgroup, op[3]);
+                uint32_t* d = reg(subgroup, op[1]);
+                forLanes(mask, [&](uint32_t lane) {
+                    d[lane] = index[lane] < components ? vector[index[lane] * kLanes + lane] : 0;
+                });
+                break;
+            }
+
+            case OpVectorInsertDynamic: {
+                uint32_t components = program.slotWords[op[1]];
+                copyValue(subgroup, op[1], op[2], mask);
+                const uint32_t* component = reg(subgroup, op[3]);
+                const uint32_t* index = reg(subgroup, op[4]);
+                uint32_t* d = reg(subgroup, op[1]);
+                forLanes(mask, [&](uint32_t lane) {
+                    if (index[lane] < components) {
+                        d[index[lane] * kLanes + lane] = component[lane];
+                    }
+                });
+                break;
+            }
+
+            case OpTranspose: {
+                const Type& source = program.types[program.valueType[op[2]]];
+                uint32_t columns = source.count;
+                uint32_t rows = program.types[source.element].count;
+                const uint32_t* s = reg(subgroup, op[2]);
+                uint32_t* d = reg(subgroup, op[1]);
+                for (uint32_t c = 0; c < columns; ++c) {
+                    for (uint32_t r = 0; r < rows; ++r) {
+                        copyWords(d + (r * columns + c) * kLanes, s + (c * rows + r) * kLanes, 1, mask);
+                    }
+                }
+                break;
+            }
+
+            case OpConvertFToU: u1([](uint32_t x) { return convertFloat<uint32_t>(asFloat(x)); }); break;
+            case OpConvertFToS: u1([](uint32_t x) { return fromInt(convertFloat<int32_t>(asFloat(x))); }); break;
+            case OpConvertSToF: u1([](uint32_t x) { return fromFloat(static_cast<float>(asInt(x))); }); break;
+            case OpConvertUToF: u1([](uint32_t x) { return fromFloat(static_cast<float>(x)); }); break;
+
+            case OpSNegate: u1([](uint32_t x) { return 0u - x; }); break;
+            case OpFNegate: u1([](uint32_t x) { return fromFloat(-asFloat(x)); }); break;
+            case OpIAdd:    u2([](uint32_t x, uint32_t y) { return x + y; }); break;
+            case OpISub:    u2([](uint32_t x, uint32_t y) { return x - y; }); break;
+            case OpIMul:    u2([](uint32_t x, uint32_t y) { return x * y; }); break;
+            // Division by zero is undefined in SPIR-V; return 0 rather than trap
+            case OpUDiv:    u2([](uint32_t x, uint32_t y) { return y ? x / y : 0u; }); break;
+            case OpUMod:    u2([](uint32_t x, uint32_t y) { return y ? x % y : 0u; }); break;
+            case OpSDiv:
+                s2([](int32_t x, int32_t y) {
+                    if (y == 0) {
+                        return 0u;
+                    }
+                    return y == -1 ? 0u - static_cast<uint32_t>(x) : fromInt(x / y);
+                });
+                break;
+            case OpSRem:
+                s2([](int32_t x, int32_t y) { return (y == 0 || y == -1) ? 0u : fromInt(x % y); });
+                break;
+            case OpSMod:
+                s2([](int32_t x, int32_t y) {
+                    if (y == 0 || y == -1) {
+                        return 0u;
+                    }
+                    int32_t r = x % y;
+                    return fromInt(r != 0 && ((r < 0) != (y < 0)) ? r + y : r);
+                });
+                break;
+
+            case OpFAdd: f2([](float x, float y) { return x + y; }); break;
+            case OpFSub: f2([](float x, float y) { return x - y; }); break;
+            case OpFMul: f2([](float x, float y) { return x * y; }); break;
+            case OpFDiv: f2([](float x, float y) { return x / y; }); break;
+            case OpFRem: f2([](float x, float y) { return std::fmod(x, y); }); break;
+            case OpFMod: f2([](float x, float y) { return x - y * std::floor(x / y); }); break;
+
+            case OpVectorTimesScalar:
+            case OpMatrixTimesScalar: {
+                uint32_t words = program.slotWords[op[1]];
+                const uint32_t* v = reg(subgroup, op[2]);
+                const uint32_t* s = reg(subgroup, op[3]);
+                uint32_t* d = reg(subgroup, op[1]);
+                for (uint32_t c = 0; c < words; ++c) {
+                    uint32_t* dc = d + c * kLanes;
+                    const uint32_t* vc = v + c * kLanes;
+                    forLanes(mask, [&](uint32_t lane) { dc[lane] = fromFloat(asFloat(vc[lane]) * asFloat(s[lane])); });
+                }
+                break;
+            }
+
+            case OpDot: {
+                uint32_t components = program.slotWords[op[2]];
+                const uint32_t* a = reg(subgroup, op[2]);
+                const uint32_t* b = reg(subgroup, op[3]);
+                uint32_t* d = reg(subgroup, op[1]);
+                forLanes(mask, [&](uint32_t lane) { d[lane] = fromFloat(dot(a, b, components, lane)); });
+                break;
+            }
+
+            case OpMatrixTimesVector: {
+                uint32_t rows = program.slotWords[op[1]];
+                uint32_t columns = program.slotWords[op[3]];
+                const uint32_t* m = reg(subgroup, op[2]);
+                const uint32_t* v = reg(subgroup, op[3]);
+                uint32_t* d = reg(subgroup, op[1]);
+                forLanes(mask, [&](uint32_t lane) {
+                    for (uint32_t r = 0; r < rows; ++r) {
+                        float sum = 0.0f;
+                        for (uint32_t c = 0; c < columns; ++c) {
+                            sum += asFloat(m[(c * rows + r) * kLanes + lane]) * asFloat(v[c * kLanes + lane]);
+                        }
+                        d[r * kLanes + lane] = fromFloat(sum);
+                    }
+                });
+                break;
+            }
+
+            case OpVectorTimesMatrix: {
+                uint32_t rows = program.slotWords[op[2]];
+                uint32_t columns = program.slotWords[op[1]];
+                const uint32_t* v = reg(subgroup, op[2]);
+                const uint32_t* m = reg(subgroup, op[3]);
+                uint32_t* d = reg(subgroup, op[1]);
+                forLanes(mask, [&](uint32_t lane) {
+                    for (uint32_t c = 0; c < columns; ++c) {
+                        d[c * kLanes + lane] = fromFloat(dot(v, m + c * rows * kLanes, rows, lane));
+                    }
+                });
+                break;
+            }
+
+            case OpMatrixTimesMatrix: {
+                const Type& resultType = program.types[op[0]];
+                uint32_t columns = resultType.count;
+                uint32_t rows = program.types[resultType.element].count;
+                uint32_t inner = program.slotWords[op[2]] / rows;
+                const uint32_t* a = reg(subgroup, op[2]);
+                const uint32_t* b = reg(subgroup, op[3]);
+                uint32_t* d = reg(subgroup, op[1]);
+                forLanes(mask, [&](uint32_t lane) {
+                    for (uint32_t c = 0; c < columns; ++c) {
+                        for (uint32_t r = 0; r < rows; ++r) {
+                            float sum = 0.0f;
+                            for (uint32_t k = 0; k < inner; ++k) {
+                                sum += asFloat(a[(k * rows + r) * kLanes + lane]) * asFloat(b[(c * inner + k) * kLanes + lane]);
+                            }
+                            d[(c * rows + r) * kLanes + lane] = fromFloat(sum);
+                        }
+                    }
+                });
+                break;
+            }
+
+            case OpOuterProduct: {
+                uint32_t rows = program.slotWords[op[2]];
+                uint32_t columns = program.slotWords[op[3]];
+                const uint32_t* a = reg(subgroup, op[2]);
+                const uint32_t* b = reg(subgroup, op[3]);
+                uint32_t* d = reg(subgroup, op[1]);
+                forLanes(mask, [&](uint32_t lane) {
+                    for (uint32_t c = 0; c < columns; ++c) {
+                        for (uint32_t r = 0; r < rows; ++r) {
+                            d[(c * rows + r) * kLanes + lane] = fromFloat(asFloat(a[r * kLanes + lane]) * asFloat(b[c * kLanes + lane]));
+                        }
+                    }
+                });
+                break;
+            }
+
+            case OpAny:
+            case OpAll: {
+                uint32_t components = program.slotWords[op[2]];
+                bool all = instruction.opcode == OpAll;
+                const uint32_t* v = reg(subgroup, op[2]);
+                uint32_t* d = reg(subgroup, op[1]);
+                forLanes(mask, [&](uint32_t lane) {
+                    uint32_t value = all ? 1u : 0u;
+                    for (uint32_t c = 0; c < components; ++c) {
+                        value = all ? (value & (v[c * kLanes + lane] ? 1u : 0u)) : (value | (v[c * kLanes + lane] ? 1u : 0u));
+                    }
+                    d[lane] = value;
+                });
+                break;
+            }
+
+            case OpIsNan: u1([](uint32_t x) { return std::isnan(asFloat(x)) ? 1u : 0u; }); break;
+            case OpIsInf: u1([](uint32_t x) { return std::isinf(asFloat(x)) ? 1u : 0u; }); break;
+
+            case OpLogicalEqual:    u2([](uint32_t x, uint32_t y) { return (x != 0) == (y != 0) ? 1u : 0u; }); break;
+            case OpLogicalNotEqual: u2([](uint32_t x, uint32_t y) { return (x != 0) != (y != 0) ? 1u : 0u; }); break;
+            case OpLogicalOr:       u2([](uint32_t x, uint32_t y) { return (x | y) ? 1u : 0u; }); break;
+            case OpLogicalAnd:      u2([](uint32_t x, uint32_t y) { return (x && y) ? 1u : 0u; }); break;
+            case OpLogicalNot:      u1([](uint32_t x) { return x ? 0u : 1u; }); break;
+
+            case OpSelect: {
+                uint32_t words = program.slotWords[op[1]];
+                bool scalarCondition = program.slotWords[op[2]] == 1;
+                const uint32_t* condition = reg(subgroup, op[2]);
+                const uint32_t* a = reg(subgroup, op[3]);
+                const uint32_t* b = reg(subgroup, op[4]);
+                uint32_t* d = reg(subgroup, op[1]);
+                for (uint32_t c = 0; c < words; ++c) {
+                    const uint32_t* cc = condition + (scalarCondition ? 0 : c * kLanes);
+                    const uint32_t* ac = a + c * kLanes;
+                    const uint32_t* bc = b + c * kLanes;
+                    uint32_t* dc = d + c * kLanes;
+                    forLanes(mask, [&](uint32_t lane) { dc[lane] = cc[lane] ? ac[lane] : bc[lane]; });
+                }
+                break;
+            }
+
+            case OpIEqual:             u2([](uint32_t x, uint32_t y) { return x == y ? 1u : 0u; }); break;
+            case OpINotEqual:          u2([](uint32_t x, uint32_t y) { return x != y ? 1u : 0u; }); break;
+            case OpUGreaterThan:       u2([](uint32_t x, uint32_t y) { return x > y ? 1u : 0u; }); break;
+            case OpUGreaterThanEqual:  u2([](uint32_t x, uint32_t y) { return x >= y ? 1u : 0u; }); break;
+            case OpULessThan:          u2([](uint32_t x, uint32_t y) { return x < y ? 1u : 0u; }); break;
+            case OpULessThanEqual:     u2([](uint32_t x, uint32_t y) { return x <= y ? 1u : 0u; }); break;
+            case OpSGreaterThan:       s2([](int32_t x, int32_t y) { return x > y ? 1u : 0u; }); break;
+            case OpSGreaterThanEqual:  s2([](int32_t x, int32_t y) { return x >= y ? 1u : 0u; }); break;
+            case OpSLessThan:          s2([](int32_t x, int32_t y) { return x < y ? 1u : 0u; }); break;
+            case OpSLessThanEqual:     s2([](int32_t x, int32_t y) { return x <= y ? 1u : 0u; }); break;
+
+            case OpFOrdEqual:              fcmp([](float x, float y) { return x == y; }); break;
+            case OpFUnordEqual:            fcmp([](float x, float y) { return !(x < y || x > y); }); break;
+            case OpFOrdNotEqual:           fcmp([](float x, float y) { return x < y || x > y; }); break;
+            case OpFUnordNotEqual:         fcmp([](float x, float y) { return x != y; }); break;
+            case OpFOrdLessThan:           fcmp([](float x, float y) { return x < y; }); break;
+            case OpFUnordLessThan:         fcmp([](float x, float y) { return !(x >= y); }); break;
+            case OpFOrdGreaterThan:        fcmp([](float x, float y) { return x > y; }); break;
+            case OpFUnordGreaterThan:      fcmp([](float x, float y) { return !(x <= y); }); break;
+            case OpFOrdLessThanEqual:      fcmp([](float x, float y) { return x <= y; }); break;
+            case OpFUnordLessThanEqual:    fcmp([](float x, float y) { return !(x > y); }); break;
+            case OpFOrdGreaterThanEqual:   fcmp([](float x, float y) { return x >= y; }); break;
+            case OpFUnordGreaterThanEqual: fcmp([](float x, float y) { return !(x < y); }); break;
+
+            // Shift amounts past the bit width are undefined; mask them like x86 does
+            case OpShiftRightLogical:    u2([](uint32_t x, uint32_t y) { return x >> (y & 31); }); break;
+            case OpShiftRightArithmetic: u2([](uint32_t x, uint32_t y) { return fromInt(asInt(x) >> (y & 31)); }); break;
+            case OpShiftLeftLogical:     u2([](uint32_t x, uint32_t y) { return x << (y & 31); }); break;
+            case OpBitwiseOr:            u2([](uint32_t x, uint32_t y) { return x | y; }); break;
+            case OpBitwiseXor:           u2([](uint32_t x, uint32_t y) { return x ^ y; }); break;
+            case OpBitwiseAnd:           u2([](uint32_t x, uint32_t y) { return x & y; }); break;
+            case OpNot:                  u1([](uint32_t x) { return ~x; }); break;
+            case OpBitCount:             u1([](uint32_t x) { return static_cast<uint32_t>(std::popcount(x)); }); break;
+            case OpBitReverse:
+                u1([](uint32_t x) {
+                    x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+                    x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+                    x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+                    x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+                    return (x >> 16) | (x << 16);
+                });
+                break;
+
+            case OpAtomicLoad: case OpAtomicStore: case OpAtomicExchange: case OpAtomicCompareExchange:
+            case OpAtomicIIncrement: case OpAtomicIDecrement: case OpAtomicIAdd: case OpAtomicISub:
+            case OpAtomicSMin: case OpAtomicUMin: case OpAtomicSMax: case OpAtomicUMax:
+            case OpAtomicAnd: case OpAtomicOr: case OpAtomicXor:
+                atomic(subgroup, mask, instruction);
+                break;
+
+            case OpExtInst:
+                if (op[2] == program.glslSet) {
+                    glsl(subgroup, mask, instruction);
+                }
+                break;
+
+            default:
+                // OpNop, OpUndef, debug lines, merge hints and memory barriers: nothing to do
+                // when every invocation of a workgroup runs on one thread
+                break;
+        }
+    }
+
+    ComputeInterpreter::ComputeInterpreter(unsigned threadCount)
+        : m_pool(threadCount)
+    {}
+
+    ComputeInterpreter::~ComputeInterpreter() = default;
+
+    bool ComputeInterpreter::load(const std::vector<uint32_t>& spirv, std::string& error) {
+        m_program.reset();
+
+        ShaderReflection reflection;
+        if (!reflectSpirv(spirv, reflection, error)) {
+            return false;
+        }
+        auto program = std::make_unique<Program>();
+        if (!program->parse(spirv, reflection, m_specConstants, error)) {
+            return false;
+        }
+        m_reflection = std::move(reflection);
+        m_program = std::move(program);
+        return true;
+    }
+
+    std::array<uint32_t, 3> ComputeInterpreter::workgroupSize() const {
+        return m_program ? m_program->workgroupSize : m_reflection.localSize;
+    }
+
+    void ComputeInterpreter::bindBuffer(uint32_t set, uint32_t binding, void* data, size_t size) {
+        m_buffers[{set, binding}] = {data, size};
+    }
+
+    void ComputeInterpreter::setPushConstants(const void* data, size_t size) {
+        auto bytes = static_cast<const uint8_t*>(data);
+        m_pushConstants.assign(bytes, bytes + size);
+    }
+
+    bool ComputeInterpreter::dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ, std::string& error) {
+        if (!m_program) {
+            error = "No compute module loaded";
+            return false;
+        }
+
+        std::vector<Workgroup::Span> spans(m_program->regions.size());
+        for (size_t i = 0; i < spans.size(); ++i) {
+            const Region& region = m_program->regions[i];
+            if (region.kind != RegionKind::Host) {
+                continue;
+            }
+            if (region.pushConstant) {
+                spans[i] = {m_pushConstants.data(), m_pushConstants.size()};
+                continue;
+            }
+            auto it = m_buffers.find({region.set, region.binding});
+            if (it == m_buffers.end()) {
+                error = "No buffer bound to set " + std::to_string(region.set) + " binding " + std::to_string(region.binding);
+                return false;
+            }
+            spans[i] = {static_cast<uint8_t*>(it->second.data), it->second.size};
+        }
+
+        uint64_t total = static_cast<uint64_t>(groupCountX) * groupCountY * groupCountZ;
+        if (total == 0) {
+            return true;
+        }
+
+        // A few chunks per worker: enough for stealing to even out the load, few enough
+        // that per-chunk register file setup stays negligible
+        std::array<uint32_t, 3> groupCount{groupCountX, groupCountY, groupCountZ};
+        size_t chunks = static_cast<size_t>(std::min<uint64_t>(total, std::max(1u, m_pool.threadCount()) * 4ull));
+        m_pool.parallelFor(chunks, [&](size_t chunk) {
+            Workgroup workgroup(*m_program, spans, groupCount);
+            uint64_t begin = total * chunk / chunks;
+            uint64_t end = total * (chunk + 1) / chunks;
+            for (uint64_t g = begin; g < end; ++g) {
+                workgroup.run({static_cast<uint32_t>(g % groupCountX),
+                               static_cast<uint32_t>((g / groupCountX) % groupCountY),
+                               static_cast<uint32_t>(g / (static_cast<uint64_t>(groupCountX) * groupCountY))});
+            }
+        });
+        return true;
+    }
+
+} // namespace ShaderLoader
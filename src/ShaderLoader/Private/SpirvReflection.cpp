@@ -0,0 +1,227 @@
+//
+// Created by charlie on 8/7/25.
+//
+
+#include "../Public/SpirvReflection.h"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+namespace ShaderLoader {
+
+    namespace {
+
+        constexpr uint32_t kSpirvMagic  = 0x07230203;
+        constexpr size_t   kHeaderWords = 5;
+
+        enum Op : uint16_t {
+            OpName                   = 5,
+            OpEntryPoint             = 15,
+            OpExecutionMode          = 16,
+            OpTypeBool               = 20,
+            OpTypeInt                = 21,
+            OpTypeFloat              = 22,
+            OpConstantTrue           = 41,
+            OpConstantFalse          = 42,
+            OpConstant               = 43,
+            OpSpecConstantTrue       = 48,
+            OpSpecConstantFalse      = 49,
+            OpSpecConstant           = 50,
+            OpSpecConstantComposite  = 51,
+            OpDecorate               = 71,
+            OpExecutionModeId        = 331,
+        };
+
+        enum Decoration : uint32_t {
+            DecorationSpecId  = 1,
+            DecorationBuiltIn = 11,
+        };
+
+        constexpr uint32_t kBuiltInWorkgroupSize    = 25;
+        constexpr uint32_t kExecutionModeLocalSize   = 17;
+        constexpr uint32_t kExecutionModeLocalSizeId = 38;
+
+        struct ScalarType {
+            SpecConstantType kind;
+            uint32_t         width;
+        };
+
+        struct Constant {
+            uint32_t typeId = 0;
+            uint64_t value = 0;
+            bool     isSpec = false;
+        };
+
+        std::string readString(const uint32_t* words, size_t wordCount) {
+            const char* text = reinterpret_cast<const char*>(words);
+            size_t maxLength = wordCount * sizeof(uint32_t);
+            return std::string(text, strnlen(text, maxLength));
+        }
+
+    } // namespace
+
+    bool reflectSpirv(const std::vector<uint32_t>& spirv, ShaderReflection& reflection, std::string& error) {
+        reflection = {};
+        if (spirv.size() < kHeaderWords || spirv[0] != kSpirvMagic) {
+            error = "Not a SPIR-V module";
+            return false;
+        }
+
+        std::unordered_map<uint32_t, std::string> names;
+        std::unordered_map<uint32_t, uint32_t>    specIds;
+        std::unordered_map<uint32_t, ScalarType>  scalarTypes;
+        std::unordered_map<uint32_t, Constant>    constants;
+        std::unordered_map<uint32_t, std::vector<uint32_t>> specComposites;
+        uint32_t workgroupSizeId = 0;
+        uint32_t entryFunction = 0;
+        bool haveEntryPoint = false;
+        std::array<uint32_t, 3> localSizeIds{0, 0, 0};
+
+        const uint32_t* words = spirv.data();
+        size_t i = kHeaderWords;
+        while (i < spirv.size()) {
+            uint16_t opcode = static_cast<uint16_t>(words[i] & 0xFFFF);
+            uint32_t count = words[i] >> 16;
+            if (count == 0 || i + count > spirv.size()) {
+                error = "Malformed SPIR-V instruction at word " + std::to_string(i);
+                return false;
+            }
+            const uint32_t* op = words + i + 1;
+            uint32_t operands = count - 1;
+
+            switch (opcode) {
+                case OpName:
+                    if (operands >= 2) {
+                        names[op[0]] = readString(op + 1, operands - 1);
+                    }
+                    break;
+
+                case OpEntryPoint:
+                    if (!haveEntryPoint && operands >= 3) {
+                        haveEntryPoint = true;
+                        reflection.executionModel = static_cast<ExecutionModel>(op[0]);
+                        entryFunction = op[1];
+                        reflection.entryPoint = readString(op + 2, operands - 2);
+                    }
+                    break;
+
+                case OpExecutionMode:
+                    if (operands >= 5 && op[0] == entryFunction && op[1] == kExecutionModeLocalSize) {
+                        reflection.localSize = {op[2], op[3], op[4]};
+                    }
+                    break;
+
+                case OpExecutionModeId:
+                    if (operands >= 5 && op[0] == entryFunction && op[1] == kExecutionModeLocalSizeId) {
+                        localSizeIds = {op[2], op[3], op[4]};
+                    }
+                    break;
+
+                case OpDecorate:
+                    if (operands >= 3 && op[1] == DecorationSpecId) {
+                        specIds[op[0]] = op[2];
+                    } else if (operands >= 3 && op[1] == DecorationBuiltIn && op[2] == kBuiltInWorkgroupSize) {
+                        workgroupSizeId = op[0];
+                    }
+                    break;
+
+                case OpTypeBool:
+                    if (operands >= 1) {
+                        scalarTypes[op[0]] = {SpecConstantType::Bool, 32};
+                    }
+                    break;
+
+                case OpTypeInt:
+                    if (operands >= 3) {
+                        scalarTypes[op[0]] = {op[2] ? SpecConstantType::Int : SpecConstantType::UInt, op[1]};
+                    }
+                    break;
+
+                case OpTypeFloat:
+                    if (operands >= 2) {
+                        scalarTypes[op[0]] = {SpecConstantType::Float, op[1]};
+                    }
+                    break;
+
+                case OpConstantTrue:
+                case OpConstantFalse:
+                case OpSpecConstantTrue:
+                case OpSpecConstantFalse:
+                    if (operands >= 2) {
+                        bool value = opcode == OpConstantTrue || opcode == OpSpecConstantTrue;
+                        bool isSpec = opcode == OpSpecConstantTrue || opcode == OpSpecConstantFalse;
+                        constants[op[1]] = {op[0], value ? 1u : 0u, isSpec};
+                    }
+                    break;
+
+                case OpConstant:
+                case OpSpecConstant:
+                    if (operands >= 3) {
+                        uint64_t value = op[2];
+                        if (operands >= 4) {
+                            value |= static_cast<uint64_t>(op[3]) << 32;
+                        }
+                        constants[op[1]] = {op[0], value, opcode == OpSpecConstant};
+                    }
+                    break;
+
+                case OpSpecConstantComposite:
+                    if (operands >= 2) {
+                        specComposites[op[1]] = {op + 2, op + operands};
+                    }
+                    break;
+
+                default:
+                    break;
+            }
+            i += count;
+        }
+
+        if (!haveEntryPoint) {
+            error = "SPIR-V module has no entry point";
+            return false;
+        }
+
+        for (const auto& [id, specId] : specIds) {
+            auto constant = constants.find(id);
+            if (constant == constants.end() || !constant->second.isSpec) {
+                continue;
+            }
+            auto type = scalarTypes.find(constant->second.typeId);
+            if (type == scalarTypes.end()) {
+                continue;
+            }
+            SpecConstantInfo info;
+            info.specId = specId;
+            info.type = type->second.kind;
+            info.bitWidth = type->second.width;
+            info.defaultValue = constant->second.value;
+            if (auto name = names.find(id); name != names.end()) {
+                info.name = name->second;
+            }
+            reflection.specConstants.push_back(std::move(info));
+        }
+        std::sort(reflection.specConstants.begin(), reflection.specConstants.end(),
+                  [](const SpecConstantInfo& a, const SpecConstantInfo& b) { return a.specId < b.specId; });
+
+        // Workgroup size: a WorkgroupSize builtin overrides LocalSize/LocalSizeId.
+        // local_size_x_id compiles to such a composite of spec constants.
+        std::array<uint32_t, 3> sizeIds = localSizeIds;
+        if (auto composite = specComposites.find(workgroupSizeId); composite != specComposites.end() && composite->second.size() == 3) {
+            std::copy(composite->second.begin(), composite->second.end(), sizeIds.begin());
+        }
+        for (size_t d = 0; d < 3; ++d) {
+            auto constant = constants.find(sizeIds[d]);
+            if (sizeIds[d] == 0 || constant == constants.end()) {
+                continue;
+            }
+            reflection.localSize[d] = static_cast<uint32_t>(constant->second.value);
+            if (auto specId = specIds.find(sizeIds[d]); specId != specIds.end() && constant->second.isSpec) {
+                reflection.localSizeSpecIds[d] = static_cast<int32_t>(specId->second);
+            }
+        }
+
+        return true;
+    }
+
+} // namespace ShaderLoader
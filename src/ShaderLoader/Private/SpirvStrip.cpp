@@ -0,0 +1,98 @@
+//
+// Created by charlie on 8/5/25.
+//
+
+#include "../Public/SpirvStrip.h"
+#include <cstring>
+#include <unordered_set>
+
+namespace ShaderLoader {
+
+    namespace {
+
+        constexpr uint32_t kSpirvMagic  = 0x07230203;
+        constexpr size_t   kHeaderWords = 5;
+
+        enum Op : uint16_t {
+            OpSourceContinued = 2,
+            OpSource          = 3,
+            OpSourceExtension = 4,
+            OpName            = 5,
+            OpMemberName      = 6,
+            OpString          = 7,
+            OpLine            = 8,
+            OpExtInstImport   = 11,
+            OpExtInst         = 12,
+            OpNoLine          = 317,
+            OpModuleProcessed = 330,
+        };
+
+        bool isDebugOp(uint16_t opcode) {
+            switch (opcode) {
+                case OpSourceContinued:
+                case OpSource:
+                case OpSourceExtension:
+                case OpName:
+                case OpMemberName:
+                case OpString:
+                case OpLine:
+                case OpNoLine:
+                case OpModuleProcessed:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+    } // namespace
+
+    size_t stripDebugInfo(std::vector<uint32_t>& spirv) {
+        if (spirv.size() < kHeaderWords || spirv[0] != kSpirvMagic) {
+            return 0;
+        }
+
+        // Result ids of NonSemantic.* OpExtInstImport; their OpExtInsts go too
+        std::unordered_set<uint32_t> nonSemanticSets;
+
+        uint32_t* words = spirv.data();
+        size_t size = spirv.size();
+        size_t read = kHeaderWords;
+        size_t write = kHeaderWords;
+
+        while (read < size) {
+            uint16_t opcode = static_cast<uint16_t>(words[read] & 0xFFFF);
+            uint32_t count = words[read] >> 16;
+            if (count == 0 || read + count > size) {
+                // Malformed stream: keep the remainder untouched
+                memmove(words + write, words + read, (size - read) * sizeof(uint32_t));
+                write += size - read;
+                break;
+            }
+
+            bool drop = isDebugOp(opcode);
+            if (opcode == OpExtInstImport && count >= 3) {
+                const char* name = reinterpret_cast<const char*>(words + read + 2);
+                size_t maxLength = (count - 2) * sizeof(uint32_t);
+                if (maxLength >= 12 && strncmp(name, "NonSemantic.", 12) == 0) {
+                    nonSemanticSets.insert(words[read + 1]);
+                    drop = true;
+                }
+            } else if (opcode == OpExtInst && count >= 4 && !nonSemanticSets.empty()) {
+                drop = nonSemanticSets.count(words[read + 3]) != 0;
+            }
+
+            if (!drop) {
+                if (write != read) {
+                    memmove(words + write, words + read, count * sizeof(uint32_t));
+                }
+                write += count;
+            }
+            read += count;
+        }
+
+        size_t removed = size - write;
+        spirv.resize(write);
+        return removed;
+    }
+
+} // namespace ShaderLoader
@@ -0,0 +1,262 @@
+//
+// Created by charlie on 8/3/25.
+//
+
+#include "../Public/VariantCompiler.h"
+#include "../Public/ContentHash.h"
+#include "../Public/SpirvCompression.h"
+#include "../Public/WorkStealingPool.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+
+namespace ShaderLoader {
+
+    namespace {
+
+        namespace fs = std::filesystem;
+
+        bool writeFileAtomic(const fs::path& path, const void* data, size_t size) {
+            auto tempPath = path;
+            tempPath += ".tmp";
+            {
+                std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+                if (!file) {
+                    return false;
+                }
+                file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+                if (!file) {
+                    return false;
+                }
+            }
+            std::error_code ec;
+            fs::rename(tempPath, path, ec);
+            return !ec;
+        }
+
+    } // namespace
+
+    bool parseVariantManifest(const std::string& path, VariantManifest& manifest, std::string& error) {
+        std::ifstream file(path);
+        if (!file) {
+            error = "Failed to open variant manifest: " + path;
+            return false;
+        }
+
+        auto baseDir = fs::path(path).parent_path();
+        manifest = {};
+
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(file, line)) {
+            ++lineNumber;
+            if (auto comment = line.find('#'); comment != std::string::npos) {
+                line.erase(comment);
+            }
+
+            std::istringstream words(line);
+            std::string directive;
+            if (!(words >> directive)) {
+                continue;
+            }
+
+            std::vector<std::string> args;
+            for (std::string arg; words >> arg;) {
+                args.push_back(arg);
+            }
+
+            auto fail = [&](const std::string& message) {
+                error = path + ":" + std::to_string(lineNumber) + ": " + message;
+                return false;
+            };
+
+            if (directive == "source") {
+                if (args.size() != 1) {
+                    return fail("expected: source <file>");
+                }
+                manifest.source = (baseDir / args[0]).string();
+            } else if (directive == "include") {
+                if (args.size() != 1) {
+                    return fail("expected: include <dir>");
+                }
+                manifest.includeDirs.push_back((baseDir / args[0]).string());
+            } else if (directive == "flag") {
+                if (args.size() != 1) {
+                    return fail("expected: flag <NAME>");
+                }
+                manifest.axes.push_back({args[0], {"", "1"}});
+            } else if (directive == "option") {
+                if (args.size() < 2) {
+                    return fail("expected: option <NAME> <value>...");
+                }
+                manifest.axes.push_back({args[0], {args.begin() + 1, args.end()}});
+            } else {
+                return fail("unknown directive '" + directive + "'");
+            }
+        }
+
+        if (manifest.source.empty()) {
+            error = path + ": manifest has no source directive";
+            return false;
+        }
+        return true;
+    }
+
+    std::vector<std::vector<ShaderDefine>> expandPermutations(const VariantManifest& manifest) {
+        std::vector<std::vector<ShaderDefine>> permutations{{}};
+        for (const auto& axis : manifest.axes) {
+            std::vector<std::vector<ShaderDefine>> next;
+            next.reserve(permutations.size() * axis.values.size());
+            for (const auto& base : permutations) {
+                for (const auto& value : axis.values) {
+                    auto defines = base;
+                    if (!value.empty()) {
+                        defines.push_back({axis.name, value});
+                    }
+                    next.push_back(std::move(defines));
+                }
+            }
+            permutations = std::move(next);
+        }
+        return permutations;
+    }
+
+    std::string variantKey(std::vector<ShaderDefine> defines) {
+        std::sort(defines.begin(), defines.end(), [](const ShaderDefine& a, const ShaderDefine& b) {
+            return a.name < b.name;
+        });
+        std::string key;
+        for (const auto& define : defines) {
+            if (!key.empty()) {
+                key += ';';
+            }
+            key += define.name + "=" + define.value;
+        }
+        return key;
+    }
+
+    std::string variantModuleName(const std::string& source, const std::string& key) {
+        return source + "[" + key + "]";
+    }
+
+    VariantBuildResult buildVariants(IShaderCompiler& compiler, const VariantManifest& manifest,
+                                     const CompileOptions& baseOptions, const std::string& outputDir,
+                                     unsigned threadCount, bool compressOutput) {
+        VariantBuildResult result;
+        auto permutations = expandPermutations(manifest);
+        result.permutations = permutations.size();
+
+        std::error_code ec;
+        fs::create_directories(outputDir, ec);
+        if (ec) {
+            result.infoLog = "Failed to create output directory: " + outputDir;
+            return result;
+        }
+
+        struct Output {
+            std::string key;
+            std::string file;
+        };
+        std::vector<Output> outputs(permutations.size());
+
+        // Unique modules by content hash; the bytes are kept to rule out hash collisions
+        std::mutex mutex;
+        std::map<uint64_t, std::vector<std::vector<uint32_t>>> unique;
+        std::string errors;
+        auto fileName = [&](uint64_t hash, size_t slot) {
+            return toHex(hash) + (slot ? "-" + std::to_string(slot) : "") + (compressOutput ? ".spv.z" : ".spv");
+        };
+
+        WorkStealingPool pool(threadCount);
+        pool.parallelFor(permutations.size(), [&](size_t i) {
+            CompileOptions options = baseOptions;
+            options.includeDirs.insert(options.includeDirs.end(), manifest.includeDirs.begin(), manifest.includeDirs.end());
+            options.defines.insert(options.defines.end(), permutations[i].begin(), permutations[i].end());
+
+            auto module = compiler.compileFromFile(manifest.source, options);
+            outputs[i].key = variantKey(permutations[i]);
+            uint64_t hash = module.spirv.empty() ? 0 : hashSpirv(module.spirv);
+
+            std::lock_guard lock(mutex);
+            if (module.spirv.empty()) {
+                result.failed++;
+                errors += "[" + outputs[i].key + "] " + module.infoLog + "\n";
+                return;
+            }
+
+            auto& bucket = unique[hash];
+            size_t slot = 0;
+            while (slot < bucket.size() && bucket[slot] != module.spirv) {
+                ++slot;
+            }
+            if (slot == bucket.size()) {
+                bucket.push_back(std::move(module.spirv));
+            }
+            outputs[i].file = fileName(hash, slot);
+        });
+
+        // Each unique module is written once, outside the lock; the bucket vectors no longer change
+        struct UniqueFile {
+            std::string                  file;
+            const std::vector<uint32_t>* spirv;
+        };
+        std::vector<UniqueFile> files;
+        for (const auto& [hash, bucket] : unique) {
+            for (size_t slot = 0; slot < bucket.size(); ++slot) {
+                files.push_back({fileName(hash, slot), &bucket[slot]});
+            }
+        }
+        result.uniqueModules = files.size();
+
+        std::vector<char> written(files.size(), 0);
+        pool.parallelFor(files.size(), [&](size_t i) {
+            const auto& spirv = *files[i].spirv;
+            auto path = fs::path(outputDir) / files[i].file;
+            if (compressOutput) {
+                auto encoded = encodeSpirvZ(spirv);
+                written[i] = !encoded.empty() && writeFileAtomic(path, encoded.data(), encoded.size());
+            } else {
+                written[i] = writeFileAtomic(path, spirv.data(), spirv.size() * sizeof(uint32_t));
+            }
+        });
+
+        // Every permutation deduplicated onto a file that failed to write is left out of the index
+        std::set<std::string> unwritten;
+        for (size_t i = 0; i < files.size(); ++i) {
+            if (!written[i]) {
+                result.failed++;
+                errors += "Failed to write " + files[i].file + "\n";
+                unwritten.insert(files[i].file);
+            }
+        }
+        for (auto& output : outputs) {
+            if (unwritten.count(output.file)) {
+                output.file.clear();
+            }
+        }
+
+        std::string index = "source " + fs::path(manifest.source).filename().string() + "\n";
+        for (const auto& output : outputs) {
+            if (!output.file.empty()) {
+                index += output.key + "\t" + output.file + "\n";
+            }
+        }
+        if (!writeFileAtomic(fs::path(outputDir) / kVariantIndexFile, index.data(), index.size())) {
+            errors += "Failed to write " + std::string(kVariantIndexFile) + "\n";
+            result.failed++;
+        }
+
+        result.success = result.failed == 0;
+        result.infoLog = "Compiled " + std::to_string(result.permutations) + " variants of " + manifest.source +
+            " into " + std::to_string(result.uniqueModules) + " unique modules";
+        if (!errors.empty()) {
+            result.infoLog += "\n" + errors;
+        }
+        return result;
+    }
+
+} // namespace ShaderLoader
@@ -0,0 +1,153 @@
+//
+// Created by charlie on 8/3/25.
+//
+
+#include "../Public/WorkStealingPool.h"
+#include <algorithm>
+
+namespace ShaderLoader {
+
+    namespace {
+        thread_local const WorkStealingPool* tl_pool = nullptr;
+        thread_local size_t                  tl_index = 0;
+    }
+
+    WorkStealingPool::WorkStealingPool(unsigned threadCount) {
+        if (threadCount == 0) {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        m_queues.reserve(threadCount);
+        for (unsigned i = 0; i < threadCount; ++i) {
+            m_queues.push_back(std::make_unique<TaskQueue>());
+        }
+
+        m_threads.reserve(threadCount);
+        for (unsigned i = 0; i < threadCount; ++i) {
+            m_threads.emplace_back([this, i] { workerLoop(i); });
+        }
+    }
+
+    WorkStealingPool::~WorkStealingPool() {
+        wait();
+        {
+            std::lock_guard lock(m_wakeMutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (auto& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    void WorkStealingPool::submit(std::function<void()> task) {
+        size_t target = (tl_pool == this) ? tl_index : m_nextQueue++ % m_queues.size();
+
+        m_pending++;
+        {
+            std::lock_guard lock(m_queues[target]->mutex);
+            m_queues[target]->tasks.push_back(std::move(task));
+        }
+        m_queued++;
+
+        {
+            std::lock_guard lock(m_wakeMutex);
+        }
+        m_wake.notify_one();
+    }
+
+    bool WorkStealingPool::tryRunTask(size_t home) {
+        std::function<void()> task;
+
+        // Own deque first, newest task (cache-warm), then steal the oldest from others
+        {
+            auto& own = *m_queues[home];
+            std::lock_guard lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+            }
+        }
+        for (size_t k = 1; !task && k < m_queues.size(); ++k) {
+            auto& victim = *m_queues[(home + k) % m_queues.size()];
+            std::lock_guard lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+            }
+        }
+
+        if (!task) {
+            return false;
+        }
+
+        m_queued--;
+        task();
+
+        if (--m_pending == 0) {
+            std::lock_guard lock(m_wakeMutex);
+            m_wake.notify_all();
+        }
+        return true;
+    }
+
+    void WorkStealingPool::workerLoop(size_t index) {
+        tl_pool = this;
+        tl_index = index;
+
+        while (true) {
+            if (tryRunTask(index)) {
+                continue;
+            }
+            std::unique_lock lock(m_wakeMutex);
+            m_wake.wait(lock, [this] { return m_stop || m_queued > 0; });
+            if (m_stop && m_queued == 0) {
+                return;
+            }
+        }
+    }
+
+    void WorkStealingPool::wait() {
+        size_t home = (tl_pool == this) ? tl_index : 0;
+        while (m_pending > 0) {
+            if (tryRunTask(home)) {
+                continue;
+            }
+            std::unique_lock lock(m_wakeMutex);
+            m_wake.wait(lock, [this] { return m_pending == 0 || m_queued > 0; });
+        }
+    }
+
+    void WorkStealingPool::parallelFor(size_t count, const std::function<void(size_t)>& fn, size_t grain) {
+        grain = std::max<size_t>(1, grain);
+        size_t chunks = (count + grain - 1) / grain;
+        if (chunks == 0) {
+            return;
+        }
+
+        // Track this loop's own chunks so it can also be called from inside a task
+        std::atomic<size_t> remaining{chunks};
+        for (size_t begin = 0; begin < count; begin += grain) {
+            size_t end = std::min(count, begin + grain);
+            submit([this, &fn, &remaining, begin, end] {
+                for (size_t i = begin; i < end; ++i) {
+                    fn(i);
+                }
+                if (--remaining == 0) {
+                    std::lock_guard lock(m_wakeMutex);
+                    m_wake.notify_all();
+                }
+            });
+        }
+
+        size_t home = (tl_pool == this) ? tl_index : 0;
+        while (remaining > 0) {
+            if (tryRunTask(home)) {
+                continue;
+            }
+            std::unique_lock lock(m_wakeMutex);
+            m_wake.wait(lock, [this, &remaining] { return remaining == 0 || m_queued > 0; });
+        }
+    }
+
+} // namespace ShaderLoader
@@ -0,0 +1,95 @@
+//
+// Created by charlie on 8/2/25.
+//
+
+#ifndef CONTENTHASH_H
+#define CONTENTHASH_H
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace ShaderLoader {
+
+    // Small non-cryptographic 64-bit hash used to key caches by content.
+    // Processes 8 bytes per step and finishes with a murmur-style avalanche.
+    class ContentHasher {
+    public:
+        explicit ContentHasher(uint64_t seed = 0x9E3779B97F4A7C15ull)
+            : m_state(seed ^ 0xCBF29CE484222325ull)
+        {}
+
+        ContentHasher& update(const void* data, size_t size) {
+            auto bytes = static_cast<const unsigned char*>(data);
+            while (size >= sizeof(uint64_t)) {
+                uint64_t word;
+                memcpy(&word, bytes, sizeof(word));
+                mix(word);
+                bytes += sizeof(word);
+                size -= sizeof(word);
+            }
+            if (size > 0) {
+                uint64_t tail = 0;
+                memcpy(&tail, bytes, size);
+                mix(tail ^ (static_cast<uint64_t>(size) << 56));
+            }
+            return *this;
+        }
+
+        // Strings are length-prefixed so consecutive fields can't alias
+        ContentHasher& update(std::string_view text) {
+            updateValue(static_cast<uint64_t>(text.size()));
+            return update(text.data(), text.size());
+        }
+
+        template<typename T>
+        ContentHasher& updateValue(const T& value) {
+            static_assert(std::is_trivially_copyable_v<T>, "updateValue needs a trivially copyable type");
+            return update(&value, sizeof(T));
+        }
+
+        uint64_t digest() const {
+            uint64_t h = m_state;
+            h ^= h >> 33;
+            h *= 0xFF51AFD7ED558CCDull;
+            h ^= h >> 33;
+            h *= 0xC4CEB9FE1A85EC53ull;
+            h ^= h >> 33;
+            return h;
+        }
+
+    private:
+        void mix(uint64_t word) {
+            m_state ^= word;
+            m_state *= 0x100000001B3ull;
+            m_state ^= m_state >> 29;
+        }
+
+        uint64_t m_state;
+    };
+
+    inline uint64_t hashBytes(const void* data, size_t size) {
+        return ContentHasher().update(data, size).digest();
+    }
+
+    inline uint64_t hashSpirv(const std::vector<uint32_t>& spirv) {
+        return hashBytes(spirv.data(), spirv.size() * sizeof(uint32_t));
+    }
+
+    inline std::string toHex(uint64_t value) {
+        static const char digits[] = "0123456789abcdef";
+        std::string out(16, '0');
+        for (int i = 15; i >= 0; --i) {
+            out[i] = digits[value & 0xF];
+            value >>= 4;
+        }
+        return out;
+    }
+
+} // namespace ShaderLoader
+
+#endif //CONTENTHASH_H
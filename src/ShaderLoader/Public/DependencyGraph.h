@@ -0,0 +1,57 @@
+//
+// Created by charlie on 8/4/25.
+//
+
+#ifndef DEPENDENCYGRAPH_H
+#define DEPENDENCYGRAPH_H
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace ShaderLoader {
+
+    // Tracks which files each compiled shader was built from (the source plus its
+    // transitive includes) so a change to a shared header only rebuilds its dependents.
+    // Files are compared by mtime and size first and by content hash when those differ,
+    // so touching a file without editing it doesn't trigger a rebuild.
+    class DependencyGraph {
+    public:
+        // Record (or replace) the file set a source was compiled from, stamping every file as current
+        void record(const std::string& source, const std::vector<std::string>& includes);
+        void remove(const std::string& source);
+
+        // Sources whose own file or any of its includes changed since they were recorded
+        std::vector<std::string> dirtySources() const;
+
+        // Sources that include the given file, directly or transitively
+        std::vector<std::string> dependents(const std::string& file) const;
+
+        bool contains(const std::string& source) const { return m_sources.count(source) != 0; }
+
+        // returns false, leaving the graph empty, if the file is missing or malformed
+        bool load(const std::string& path);
+        bool save(const std::string& path) const;
+        void clear();
+
+    private:
+        struct FileStamp {
+            int64_t  mtime = 0;
+            uint64_t size  = 0;
+            uint64_t hash  = 0;
+        };
+
+        static bool stampFile(const std::string& path, FileStamp& stamp);
+        bool fileChanged(const std::string& path) const;
+
+        std::map<std::string, std::vector<std::string>> m_sources;     // source -> includes
+        std::map<std::string, std::set<std::string>>    m_dependents;  // file -> sources
+        std::map<std::string, FileStamp>                m_stamps;
+    };
+
+} // namespace ShaderLoader
+
+#endif //DEPENDENCYGRAPH_H
@@ -20,8 +20,25 @@ namespace ShaderLoader {
     };
 
     struct ShaderModule {
-        std::vector<uint32_t> spirv;
-        std::string           infoLog;
+        std::vector<uint32_t>    spirv;
+        std::string              infoLog;
+        std::vector<std::string> dependencies; // transitive includes, filled by compileFromFile
+        uint64_t                 hash = 0;     // content hash of spirv, filled in by ShaderLoader
+    };
+
+    struct ShaderDefine {
+        std::string name;
+        std::string value;
+    };
+
+    // Options for compiling shader source to SPIR-V
+    struct CompileOptions {
+        ShaderLanguage            language  = ShaderLanguage::GLSL;
+        std::vector<ShaderDefine> defines;
+        std::vector<std::string>  includeDirs;
+        std::string               targetEnv = "vulkan1.0";
+        bool                      optimize  = true;
+        bool                      debugInfo = false;
     };
 
     class IShaderCompiler {
@@ -30,6 +47,18 @@ namespace ShaderLoader {
 
         // Load SPIR-V directly from file
         virtual ShaderModule loadSpirvFromFile(const std::string& path) = 0;
+
+        // Compile shader source to SPIR-V
+        // compilers that only load SPIR-V report this in the infoLog
+        virtual ShaderModule compileFromFile(const std::string& path, const CompileOptions& options) {
+            (void)options;
+            return {.spirv = {}, .infoLog = "Shader compilation not supported by this compiler: " + path};
+        }
+
+        // Identifies the compiler build, used to key compile caches
+        virtual std::string version() const {
+            return {};
+        }
     };
 
     // Factory function to create the default compiler
@@ -0,0 +1,79 @@
+//
+// Created by charlie on 8/2/25.
+//
+
+#ifndef SHADERCACHE_H
+#define SHADERCACHE_H
+#pragma once
+
+#include "IShaderCompiler.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace ShaderLoader {
+
+    struct ShaderCacheConfig {
+        std::string directory    = ".shader_cache";
+        uint64_t    maxSizeBytes = 256ull * 1024 * 1024;
+    };
+
+    // On-disk content-addressed store of compiled SPIR-V.
+    // Entries are written to a temp file and renamed into place, so concurrent
+    // writers (threads or processes) never expose a partial entry.
+    // Hits refresh the entry's mtime; when the cache grows past maxSizeBytes
+    // the least recently used entries are removed.
+    class ShaderCache {
+    public:
+        explicit ShaderCache(ShaderCacheConfig config);
+
+        std::optional<std::vector<uint32_t>> load(uint64_t key);
+        bool store(uint64_t key, const std::vector<uint32_t>& spirv);
+
+        // Drop least recently used entries until the cache fits its size limit
+        void prune();
+
+        uint64_t hits() const { return m_hits; }
+        uint64_t misses() const { return m_misses; }
+
+    private:
+        std::string entryPath(uint64_t key) const;
+
+        ShaderCacheConfig     m_config;
+        std::mutex            m_sizeMutex;
+        uint64_t              m_totalSize = 0;
+        std::atomic<uint64_t> m_hits{0};
+        std::atomic<uint64_t> m_misses{0};
+    };
+
+    // Compile cache key: include-expanded source, defines, options,
+    // shader stage (file extension) and compiler version
+    uint64_t computeCompileKey(const std::string& expandedSource, const std::string& path,
+                               const CompileOptions& options, const std::string& compilerVersion);
+
+    // IShaderCompiler decorator that serves compileFromFile from a ShaderCache
+    class CachingShaderCompiler : public IShaderCompiler {
+    public:
+        CachingShaderCompiler(std::unique_ptr<IShaderCompiler> compiler, ShaderCacheConfig config);
+
+        ShaderModule loadSpirvFromFile(const std::string& path) override;
+        ShaderModule compileFromFile(const std::string& path, const CompileOptions& options) override;
+        std::string version() const override;
+
+        ShaderCache& cache() { return m_cache; }
+
+    private:
+        std::unique_ptr<IShaderCompiler> m_compiler;
+        ShaderCache                      m_cache;
+    };
+
+    std::unique_ptr<IShaderCompiler> createCachingCompiler(std::unique_ptr<IShaderCompiler> compiler,
+                                                           ShaderCacheConfig config = {});
+
+} // namespace ShaderLoader
+
+#endif //SHADERCACHE_H
@@ -7,26 +7,68 @@
 #pragma once
 
 #include "IShaderCompiler.h"
+#include "DependencyGraph.h"
+#include "SpirvReflection.h"
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace ShaderLoader {
 
     class ShaderLoader {
     public:
         explicit ShaderLoader(std::unique_ptr<IShaderCompiler> compiler);
+        // Saves the dependency graph if it changed since the last save
+        ~ShaderLoader();
+
+        // Strip debug-only instructions (names, source text, line info) from every
+        // module as it is loaded, for shipping builds. Off by default
+        void setStripDebugInfo(bool strip) { m_stripDebugInfo = strip; }
 
         // Load SPIR-V shader from disk
         // returns true on success
         bool loadShader(const std::string& path);
 
+        // Compile shader source (e.g. custom_fragment.frag) and store it under its source path
+        // returns true on success
+        bool compileShader(const std::string& path, const CompileOptions& options = {});
+
+        // Load a directory written by buildVariants; each variant is registered
+        // under variantModuleName(source, key). returns true if every module loaded
+        bool loadVariants(const std::string& directory);
+
         // get the compiled SPIR-V module for a previously loaded shader
         const ShaderModule* getModule(const std::string& path) const;
 
+        // Reflect a loaded module: entry point, workgroup size and specialization constant ids
+        // returns false if the shader isn't loaded or its SPIR-V can't be parsed
+        bool reflectModule(const std::string& path, ShaderReflection& reflection, std::string& error) const;
+
+        // Track the include set of every compiled shader and persist it to graphPath,
+        // so reloadChanged() only rebuilds the shaders a header edit actually affects
+        void enableDependencyTracking(const std::string& graphPath);
+
+        // Write the dependency graph if loads changed it since the last save. reloadChanged()
+        // and the destructor call this, so loads in between are written in one go.
+        // returns false if the file couldn't be written
+        bool saveDependencies();
+
+        // Recompile (or reload, for SPIR-V files) every shader whose file or includes changed,
+        // then save the dependency graph. returns the paths that were reloaded
+        std::vector<std::string> reloadChanged();
+
     private:
+        void prepareModule(ShaderModule& module) const;
+        void trackDependencies(const std::string& path, const std::vector<std::string>& includes);
+
         std::unique_ptr<IShaderCompiler> m_compiler;
         std::unordered_map<std::string, ShaderModule> m_modules;
+        std::unordered_map<std::string, CompileOptions> m_compileOptions;
+        std::unique_ptr<DependencyGraph> m_dependencies;
+        std::string m_dependencyGraphPath;
+        bool m_dependenciesDirty = false;
+        bool m_stripDebugInfo = false;
     };
 
 } // namespace ShaderLoader
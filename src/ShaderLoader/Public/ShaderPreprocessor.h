@@ -0,0 +1,28 @@
+//
+// Created by charlie on 8/2/25.
+//
+
+#ifndef SHADERPREPROCESSOR_H
+#define SHADERPREPROCESSOR_H
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace ShaderLoader {
+
+    struct PreprocessedSource {
+        std::string              text;      // source with every #include inlined
+        std::vector<std::string> includes;  // transitive include set, in first-seen order
+        std::string              infoLog;
+        bool                     success = false;
+    };
+
+    // Inline #include "..." and #include <...> directives the way glslc resolves them:
+    // quoted includes search the including file's directory first, then includeDirs.
+    // Each file is inlined once, which is all the compile cache and dependency tracking need.
+    PreprocessedSource expandIncludes(const std::string& path, const std::vector<std::string>& includeDirs);
+
+} // namespace ShaderLoader
+
+#endif //SHADERPREPROCESSOR_H
@@ -0,0 +1,87 @@
+//
+// Created by charlie on 8/6/25.
+//
+
+#ifndef SPIRVCOMPRESSION_H
+#define SPIRVCOMPRESSION_H
+#pragma once
+
+#include "IShaderCompiler.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ShaderLoader {
+
+    // .spv.z: compact SPIR-V storage in the spirit of SMOL-V.
+    //
+    // Every instruction is stored as varint(opcode), varint(word count) and its operands.
+    // The first operands of common opcodes are zigzag varint deltas against the same operand
+    // of the previous instruction with that opcode, which turns repeated type ids and
+    // sequential result ids into single bytes. The stream can additionally be zstd
+    // compressed when the library is built with SHADERLOADER_HAS_ZSTD.
+    struct SpirvZHeader {
+        uint32_t magic;      // kSpirvZMagic
+        uint8_t  version;
+        uint8_t  flags;      // kSpirvZFlagZstd
+        uint16_t reserved;
+        uint32_t wordCount;  // decoded SPIR-V size, so the output is allocated exactly once
+    };
+
+    constexpr uint32_t kSpirvZMagic    = 0x5A565053; // "SPVZ"
+    constexpr uint8_t  kSpirvZVersion  = 1;
+    constexpr uint8_t  kSpirvZFlagZstd = 0x1;
+
+    // Encode a module to the .spv.z format (header included)
+    // compress is ignored when zstd isn't available
+    std::vector<uint8_t> encodeSpirvZ(const std::vector<uint32_t>& spirv, bool compress = true);
+
+    bool writeSpirvZ(const std::string& path, const std::vector<uint32_t>& spirv, bool compress, std::string& error);
+
+    // Incremental decoder for the varint stream (after the header and any zstd layer).
+    // Input may arrive in chunks of any size; words are written straight into the
+    // caller's buffer, which must hold header.wordCount words.
+    class SpirvZDecoder {
+    public:
+        SpirvZDecoder(uint32_t* output, size_t wordCount);
+
+        // returns false on malformed input or overflow of the output buffer
+        bool feed(const uint8_t* data, size_t size);
+
+        // true once exactly wordCount words have been decoded
+        bool finished() const { return m_written == m_wordCount && m_state == State::Opcode; }
+
+    private:
+        enum class State { Header, Opcode, Count, Operand };
+
+        bool decodeInstructionFast(const uint8_t*& cursor, const uint8_t* end);
+        bool acceptValue(uint32_t value);
+
+        uint32_t* m_output;
+        size_t    m_wordCount;
+        size_t    m_written = 0;
+
+        State     m_state = State::Header;
+        uint32_t  m_opcode = 0;
+        uint32_t  m_operandCount = 0;
+        uint32_t  m_operandIndex = 0;
+
+        // partially read varint
+        uint64_t  m_value = 0;
+        uint32_t  m_shift = 0;
+
+        std::vector<uint32_t> m_previous;
+    };
+
+    // Read and decode a .spv.z file
+    ShaderModule loadSpirvZ(const std::string& path);
+
+    // IShaderCompiler backend that loads .spv.z files transparently and
+    // forwards everything else to the wrapped compiler
+    std::unique_ptr<IShaderCompiler> createCompressedSpirvCompiler(std::unique_ptr<IShaderCompiler> compiler);
+
+} // namespace ShaderLoader
+
+#endif //SPIRVCOMPRESSION_H
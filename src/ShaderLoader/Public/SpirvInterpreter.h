@@ -0,0 +1,89 @@
+//
+// Created by charlie on 8/8/25.
+//
+
+#ifndef SPIRVINTERPRETER_H
+#define SPIRVINTERPRETER_H
+#pragma once
+
+#include "IShaderCompiler.h"
+#include "SpirvReflection.h"
+#include "WorkStealingPool.h"
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ShaderLoader {
+
+    // Runs GLCompute SPIR-V on the CPU, as a GPU-less backend for headless machines and
+    // a deterministic reference to diff device results against.
+    //
+    // Workgroups are spread over a work-stealing pool. Inside a workgroup, invocations run in
+    // subgroups of kSubgroupSize lanes that share a program counter: registers are stored
+    // lane-minor, so each instruction is one tight loop over the lanes. Lanes that diverge
+    // are parked and the lowest program counter runs next, which reconverges them at merge blocks.
+    //
+    // Storage buffers, uniform buffers and push constants are read and written in place in
+    // host memory. Out-of-bounds accesses read zero and drop writes, like robustBufferAccess.
+    //
+    // Covers the subset compute shaders compiled by glslc use: 32-bit scalars, vectors and
+    // matrices, arrays and structs, workgroup/private/function variables, structured control flow,
+    // function calls, barriers in the entry point, 32-bit atomics and most of GLSL.std.450.
+    // load() reports anything outside that subset instead of running it wrongly.
+    class ComputeInterpreter {
+    public:
+        static constexpr uint32_t kSubgroupSize = 8;
+
+        // threadCount 0 means one worker per hardware thread
+        explicit ComputeInterpreter(unsigned threadCount = 0);
+        ~ComputeInterpreter();
+
+        ComputeInterpreter(const ComputeInterpreter&) = delete;
+        ComputeInterpreter& operator=(const ComputeInterpreter&) = delete;
+
+        // Override a specialization constant with its raw 32-bit value; applies from the next load()
+        void setSpecConstant(uint32_t specId, uint32_t bits) { m_specConstants[specId] = bits; }
+
+        // Parse a compute module (e.g. from ShaderLoader::getModule)
+        // returns false and sets error if it isn't compute or uses unsupported features
+        bool load(const ShaderModule& module, std::string& error) { return load(module.spirv, error); }
+        bool load(const std::vector<uint32_t>& spirv, std::string& error);
+
+        bool isLoaded() const { return m_program != nullptr; }
+        const ShaderReflection& reflection() const { return m_reflection; }
+
+        // Workgroup size after specialization
+        std::array<uint32_t, 3> workgroupSize() const;
+
+        // Bind host memory to a storage or uniform buffer; it must outlive dispatch()
+        void bindBuffer(uint32_t set, uint32_t binding, void* data, size_t size);
+        void setPushConstants(const void* data, size_t size);
+
+        // Run groupCountX * groupCountY * groupCountZ workgroups and wait for them
+        // returns false and sets error if no module is loaded or a buffer isn't bound
+        bool dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ, std::string& error);
+
+    private:
+        struct Program;
+        struct Workgroup;
+
+        struct HostBuffer {
+            void*  data = nullptr;
+            size_t size = 0;
+        };
+
+        std::unique_ptr<Program> m_program;
+        ShaderReflection m_reflection;
+        std::map<uint32_t, uint32_t> m_specConstants;
+        std::map<std::pair<uint32_t, uint32_t>, HostBuffer> m_buffers;
+        std::vector<uint8_t> m_pushConstants;
+        WorkStealingPool m_pool;
+    };
+
+} // namespace ShaderLoader
+
+#endif //SPIRVINTERPRETER_H
@@ -0,0 +1,64 @@
+//
+// Created by charlie on 8/7/25.
+//
+
+#ifndef SPIRVREFLECTION_H
+#define SPIRVREFLECTION_H
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ShaderLoader {
+
+    enum class ExecutionModel : uint32_t {
+        Vertex    = 0,
+        Fragment  = 4,
+        GLCompute = 5,
+        Unknown   = 0xFFFFFFFF
+    };
+
+    enum class SpecConstantType {
+        Bool,
+        Int,
+        UInt,
+        Float
+    };
+
+    struct SpecConstantInfo {
+        uint32_t         specId = 0;
+        SpecConstantType type = SpecConstantType::UInt;
+        uint32_t         bitWidth = 32;     // 32 or 64; bools are specialized as 32-bit VkBool32
+        uint64_t         defaultValue = 0;  // raw bits
+        std::string      name;              // empty when the module was stripped
+    };
+
+    struct ShaderReflection {
+        ExecutionModel                executionModel = ExecutionModel::Unknown;
+        std::string                   entryPoint;
+
+        // Compute workgroup size, with the spec id driving each dimension or -1 if fixed
+        std::array<uint32_t, 3>       localSize{1, 1, 1};
+        std::array<int32_t, 3>        localSizeSpecIds{-1, -1, -1};
+
+        std::vector<SpecConstantInfo> specConstants;
+
+        const SpecConstantInfo* findSpecConstant(uint32_t specId) const {
+            for (const auto& constant : specConstants) {
+                if (constant.specId == specId) {
+                    return &constant;
+                }
+            }
+            return nullptr;
+        }
+    };
+
+    // Reflect the first entry point of a SPIR-V module
+    // returns false and sets error on malformed input
+    bool reflectSpirv(const std::vector<uint32_t>& spirv, ShaderReflection& reflection, std::string& error);
+
+} // namespace ShaderLoader
+
+#endif //SPIRVREFLECTION_H
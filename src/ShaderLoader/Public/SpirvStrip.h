@@ -0,0 +1,23 @@
+//
+// Created by charlie on 8/5/25.
+//
+
+#ifndef SPIRVSTRIP_H
+#define SPIRVSTRIP_H
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ShaderLoader {
+
+    // Remove instructions with no effect on execution: OpSource*, OpName, OpMemberName,
+    // OpString, OpLine/OpNoLine, OpModuleProcessed and NonSemantic.* extended instruction sets.
+    // Runs as one linear scan that compacts the words in place and shrinks the size
+    // without reallocating. Returns the number of words removed (0 for invalid SPIR-V).
+    size_t stripDebugInfo(std::vector<uint32_t>& spirv);
+
+} // namespace ShaderLoader
+
+#endif //SPIRVSTRIP_H
@@ -0,0 +1,63 @@
+//
+// Created by charlie on 8/3/25.
+//
+
+#ifndef VARIANTCOMPILER_H
+#define VARIANTCOMPILER_H
+#pragma once
+
+#include "IShaderCompiler.h"
+#include <string>
+#include <vector>
+
+namespace ShaderLoader {
+
+    // One permutation axis. A flag axis has the values {"", "1"},
+    // where "" leaves the define out entirely.
+    struct VariantAxis {
+        std::string              name;
+        std::vector<std::string> values;
+    };
+
+    // Permutation manifest, one directive per line ('#' starts a comment):
+    //   source custom_fragment.frag     shader source, relative to the manifest
+    //   include common                  extra include directory, relative to the manifest
+    //   flag   USE_PULSE                compiled with and without -DUSE_PULSE=1
+    //   option QUALITY 0 1 2            compiled once per value
+    struct VariantManifest {
+        std::string              source;
+        std::vector<std::string> includeDirs;
+        std::vector<VariantAxis> axes;
+    };
+
+    bool parseVariantManifest(const std::string& path, VariantManifest& manifest, std::string& error);
+
+    // Cartesian product of all axes; flags that are off produce no define
+    std::vector<std::vector<ShaderDefine>> expandPermutations(const VariantManifest& manifest);
+
+    // Canonical, order-independent name for a define set, e.g. "QUALITY=2;USE_PULSE=1"
+    std::string variantKey(std::vector<ShaderDefine> defines);
+
+    // Name a variant is registered under in ShaderLoader, e.g. "custom_fragment.frag[QUALITY=2]"
+    std::string variantModuleName(const std::string& source, const std::string& key);
+
+    struct VariantBuildResult {
+        size_t      permutations  = 0;
+        size_t      uniqueModules = 0;
+        size_t      failed        = 0;
+        std::string infoLog;
+        bool        success       = false;
+    };
+
+    // Compile every permutation on a work-stealing pool and write the results to outputDir:
+    // byte-identical modules are stored once as <hash>.spv (or <hash>.spv.z when compressed),
+    // and variants.index maps each variant key to its module file (see ShaderLoader::loadVariants).
+    VariantBuildResult buildVariants(IShaderCompiler& compiler, const VariantManifest& manifest,
+                                     const CompileOptions& baseOptions, const std::string& outputDir,
+                                     unsigned threadCount = 0, bool compressOutput = false);
+
+    constexpr const char* kVariantIndexFile = "variants.index";
+
+} // namespace ShaderLoader
+
+#endif //VARIANTCOMPILER_H
@@ -0,0 +1,66 @@
+//
+// Created by charlie on 8/3/25.
+//
+
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ShaderLoader {
+
+    // Fixed-size thread pool with one task deque per worker.
+    // Workers pop their own deque LIFO and steal from the others FIFO, so
+    // uneven tasks (a slow shader permutation, a heavy workgroup) don't leave cores idle.
+    class WorkStealingPool {
+    public:
+        // threadCount 0 means one worker per hardware thread
+        explicit WorkStealingPool(unsigned threadCount = 0);
+        ~WorkStealingPool();
+
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+        // Tasks submitted from a worker go to that worker's own deque
+        void submit(std::function<void()> task);
+
+        // Block until every submitted task has finished; the caller helps run tasks meanwhile.
+        // Not for use inside a task, which would wait on itself - use parallelFor there
+        void wait();
+
+        // Run fn(i) for every i in [0, count), grain indices per task, and wait for those tasks only
+        void parallelFor(size_t count, const std::function<void(size_t)>& fn, size_t grain = 1);
+
+        unsigned threadCount() const { return static_cast<unsigned>(m_threads.size()); }
+
+    private:
+        struct TaskQueue {
+            std::mutex                        mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        bool tryRunTask(size_t home);
+        void workerLoop(size_t index);
+
+        std::vector<std::unique_ptr<TaskQueue>> m_queues;
+        std::vector<std::thread>                m_threads;
+        std::atomic<size_t>                     m_queued{0};
+        std::atomic<size_t>                     m_pending{0};
+        std::atomic<size_t>                     m_nextQueue{0};
+        std::mutex                              m_wakeMutex;
+        std::condition_variable                 m_wake;
+        bool                                    m_stop = false;
+    };
+
+} // namespace ShaderLoader
+
+#endif //WORKSTEALINGPOOL_H